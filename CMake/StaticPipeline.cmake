@@ -0,0 +1,73 @@
+# Generates static_pipeline.hpp for the module list of a CHM configuration file.
+#
+# For each module in the config's "modules" list that implements run(mesh_elem&), the generated header provides a
+# dispatch id and a direct, qualified (non-virtual) call so the per-face loop in core::run() does not go through the
+# vtable. Modules not in the list, or domain-parallel modules, continue to use the dynamic path.
+#
+# chm_generate_static_pipeline(<config.json> <output header>)
+
+function(chm_generate_static_pipeline config_file out_header)
+
+    if(NOT EXISTS "${config_file}")
+        message(FATAL_ERROR "STATIC_PIPELINE_CONFIG=${config_file} does not exist")
+    endif()
+
+    file(READ "${config_file}" config_json)
+
+    # CHM configs allow // comments, which string(JSON) does not. Only strip whole line comments to avoid mangling urls
+    string(REGEX REPLACE "(^|\n)[ \t]*//[^\n]*" "\\1" config_json "${config_json}")
+
+    string(JSON nmodules ERROR_VARIABLE json_error LENGTH "${config_json}" modules)
+    if(json_error)
+        message(FATAL_ERROR "Unable to read the modules list from ${config_file}: ${json_error}")
+    endif()
+
+    # Find the header that registers each module
+    file(GLOB_RECURSE module_headers "${CMAKE_SOURCE_DIR}/src/modules/*.hpp")
+
+    set(includes "")
+    set(id_checks "")
+    set(cases "")
+    set(names "")
+    set(id 0)
+
+    math(EXPR last "${nmodules} - 1")
+    foreach(i RANGE ${last})
+        string(JSON module GET "${config_json}" modules ${i})
+
+        set(module_header "")
+        foreach(header ${module_headers})
+            file(STRINGS "${header}" registered REGEX "REGISTER_MODULE_HPP\\(${module}\\)")
+            if(registered)
+                set(module_header "${header}")
+                break()
+            endif()
+        endforeach()
+
+        if(NOT module_header)
+            message(FATAL_ERROR "Static pipeline: no module named ${module} is registered in src/modules")
+        endif()
+
+        # domain parallel modules and block kernel modules do not implement run(mesh_elem&), they stay on the dynamic path
+        file(STRINGS "${module_header}" face_run REGEX "run[ \t]*\\([ \t]*mesh_elem[ \t]*&")
+        if(NOT face_run)
+            message(STATUS "Static pipeline: ${module} has no per-face run, using dynamic dispatch")
+            continue()
+        endif()
+
+        file(RELATIVE_PATH rel_header "${CMAKE_SOURCE_DIR}/src" "${module_header}")
+        string(APPEND includes "#include \"${rel_header}\"\n")
+        string(APPEND names "        \"${module}\",\n")
+        string(APPEND id_checks "        if (m->ID == \"${module}\" && dynamic_cast<${module}*>(m) != nullptr) return ${id};\n")
+        string(APPEND cases "            case ${id}: static_cast<${module}*>(m)->${module}::run(face); break;\n")
+
+        message(STATUS "Static pipeline: ${module} (${rel_header})")
+        math(EXPR id "${id} + 1")
+    endforeach()
+
+    configure_file("${CMAKE_SOURCE_DIR}/src/static_pipeline.hpp.in" "${out_header}" @ONLY)
+
+    # re-run cmake if the config changes
+    set_property(DIRECTORY APPEND PROPERTY CMAKE_CONFIGURE_DEPENDS "${config_file}")
+
+endfunction()
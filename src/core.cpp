@@ -59,6 +59,8 @@ core::~core()
         itr.first.reset();
     }
 
+    // the GRIB2 forcing may be in an MPI shared memory window
+    _metdata.reset();
 }
 
 void core::config_options( pt::ptree &value)
@@ -159,6 +161,35 @@ void core::config_options( pt::ptree &value)
         point_mode.enable = false; // we don't have point_mode
     }
 
+    _perf_counters.enable = value.get("perf_counters", false);
+
+    _snow_free_fast_path = value.get("snow_free_fast_path", true);
+
+    _parallel_module_init = value.get("parallel_module_init", true);
+
+    _forcing_ranks_per_aggregator = value.get("forcing_ranks_per_aggregator", 0);
+
+    int block_size = value.get("block_size", 256);
+    if (block_size < 1)
+        CHM_THROW_EXCEPTION(config_error, "option.block_size must be > 0");
+    _block_size = block_size;
+
+    std::string face_schedule = value.get("face_schedule", "static");
+    if (face_schedule != "static" && face_schedule != "cost")
+        CHM_THROW_EXCEPTION(config_error, "option.face_schedule must be one of static or cost, got " + face_schedule);
+
+    // point mode only runs one face
+    _cost_schedule = face_schedule == "cost" && !point_mode.enable;
+
+    int window = value.get("face_schedule_window", 10);
+    if (window < 1)
+        CHM_THROW_EXCEPTION(config_error, "option.face_schedule_window must be > 0");
+    _cost_schedule_window = window;
+
+    auto cache_dir = value.get_optional<std::string>("forcing_cache");
+    if (cache_dir)
+        _forcing_cache_dir = *cache_dir;
+
     auto notify_sh = value.get_optional<std::string>("notification_script");
     if(notify_sh)
     {
@@ -167,13 +198,39 @@ void core::config_options( pt::ptree &value)
 
     auto radius = value.get_optional<double>("station_search_radius");
     auto N = value.get_optional<double>("station_N_nearest");
+    auto N_quadrant = value.get_optional<int>("station_N_per_quadrant");
+
+    // spline and idw need at least 2 stations to interpolate
+    unsigned int min_N = ia == "nearest" ? 1 : 2;
+
+    if(N && N_quadrant)
+    {
+        CHM_THROW_EXCEPTION(config_error, "Cannot have both station_N_nearest and station_N_per_quadrant set.");
+    }
 
-    if(radius && N)
+    if(N_quadrant)
     {
-        CHM_THROW_EXCEPTION(config_error, "Cannot have both station_search_radius and station_N_nearest set.");
+        if(*N_quadrant < 1)
+        {
+            CHM_THROW_EXCEPTION(config_error, "station_N_per_quadrant must be >= 1. N = " + std::to_string(*N_quadrant));
+        }
+
+        double r = radius ? *radius : -1;
+        SPDLOG_DEBUG("Using up to {} stations per quadrant", *N_quadrant);
+        _metdata->get_stations = boost::bind( &metdata::quadrant_stations,_metdata,boost::placeholders::_1,boost::placeholders::_2, *N_quadrant, r, min_N);
     }
+    else if(radius && N)
+    {
+        int n = *N;
+        if( n < static_cast<int>(min_N))
+        {
+            CHM_THROW_EXCEPTION(config_error, "station_N_nearest must be >= 2 if spline or idw is used. N = " + std::to_string(n));
+        }
 
-    if(radius)
+        SPDLOG_DEBUG("Using N={} nearest stations within a radius of {} m", n, *radius);
+        _metdata->get_stations = boost::bind( &metdata::nearest_station_in_radius,_metdata,boost::placeholders::_1,boost::placeholders::_2, n, *radius, min_N);
+    }
+    else if(radius)
     {
         _metdata->get_stations = boost::bind( &metdata::get_stations_in_radius,_metdata,boost::placeholders::_1,boost::placeholders::_2, *radius);
     }
@@ -321,6 +378,16 @@ void core::config_checkpoint( pt::ptree& value)
         _checkpoint_opts.ckpt_path = output_folder_path / dir;
         boost::filesystem::create_directories(_checkpoint_opts.ckpt_path);
 
+        // write to fast node-local storage and drain to ckpt_path in the background
+        auto local_path = value.get_optional<std::string>("local_path");
+        if (local_path)
+        {
+            _checkpoint_opts.local_path = boost::filesystem::path(*local_path) / dir;
+            boost::filesystem::create_directories(*_checkpoint_opts.local_path);
+            SPDLOG_DEBUG("Checkpoints are written to {} and drained to {}", _checkpoint_opts.local_path->string(),
+                         _checkpoint_opts.ckpt_path.string());
+        }
+
         // check for the old naming and bail
         auto tmp = value.get_optional<size_t>("frequency");
         if(tmp)
@@ -499,13 +566,14 @@ void core::config_forcing(pt::ptree &value)
 
     //need to determine if we have been given a netcdf file
     _use_netcdf = value.get("use_netcdf",false);
+    bool use_grib2 = value.get("use_grib2",false);
 
 
     timer c;
     c.tic();
     size_t nstations = 0;
     //we need to treat this very differently than the txt files
-    if(_use_netcdf)
+    if(_use_netcdf || use_grib2)
     {
         std::string file = value.get<std::string>("file");
         std::map<std::string, boost::shared_ptr<filter_base> > netcdf_filters;
@@ -529,7 +597,25 @@ void core::config_forcing(pt::ptree &value)
         }
 
         // this delegates all filter responsibility to metdata from now on
-        _metdata->load_from_netcdf(file, &_mesh->_bounding_box,netcdf_filters);
+        if(use_grib2)
+        {
+            // overrides of which GRIB2 messages provide each variable
+            std::map<std::string, std::string> grib2_variables;
+            if(auto vars = value.get_child_optional("grib2_variables"))
+            {
+                for (auto& jtr : *vars)
+                    grib2_variables[jtr.first] = jtr.second.data();
+            }
+
+#ifdef USE_MPI
+            _metdata->share_grib2(_comm_world);
+#endif
+            _metdata->load_from_grib2(file, &_mesh->_bounding_box, netcdf_filters, grib2_variables);
+        }
+        else
+        {
+            _metdata->load_from_netcdf(file, &_mesh->_bounding_box,netcdf_filters);
+        }
         nstations = _metdata->nstations();
     } else
     {
@@ -826,6 +912,8 @@ bool core::config_meshes( pt::ptree &value)
     ////////////////////////////////////////////////////////////
     if(mesh_file_extension == ".h5")
     {
+        _mesh->distributed_load(value.get("distributed_load", false));
+        _mesh->max_ghost_distance(value.get("max_ghost_distance", 100.0));
         _mesh->from_hdf5(_mesh_path, param_file_paths, initial_condition_file_paths);
     }
     else if(mesh_file_extension == ".partition")
@@ -1509,7 +1597,7 @@ void core::init(int argc, char **argv)
         SPDLOG_DEBUG("Running in point mode");
         //Each face knows which stations are closest to it and what it should use
 
-        if(point_mode.use_specific_station && _metdata->is_netcdf())
+        if(point_mode.use_specific_station && (_metdata->is_netcdf() || _metdata->is_grib2()))
         {
             CHM_THROW_EXCEPTION(model_init_error, "If a specific station is requested, this must be done using an ascii forcing file definition." );
         }
@@ -1536,7 +1624,7 @@ void core::init(int argc, char **argv)
             }
         }
 
-        if(_metdata->is_netcdf())
+        if(_metdata->is_netcdf() || _metdata->is_grib2())
         {
             SPDLOG_DEBUG("Using the following input nc grid cells as forcing:");
             for(auto& s:_outputs.at(0).face->stations())
@@ -1555,6 +1643,30 @@ void core::init(int argc, char **argv)
     SPDLOG_DEBUG("Determining module dependencies");
     _determine_module_dep();
 
+    for (auto& m : _modules)
+    {
+        for (auto& d : m.first->diagnostics())
+        {
+            _diagnostics.push_back({d.first, xxh64::hash(d.first.c_str(), d.first.length()), d.second});
+        }
+    }
+
+    // diagnostics are only evaluated for output, so nothing can use them as an input
+    for (auto& m : _modules)
+    {
+        auto depends = m.first->get_variable_names_from_collection(*(m.first->depends()));
+        depends.insert(depends.end(), m.first->optionals()->begin(), m.first->optionals()->end());
+
+        for (auto& d : _diagnostics)
+        {
+            if (std::find(depends.begin(), depends.end(), d.name) != depends.end())
+            {
+                CHM_THROW_EXCEPTION(module_error, "Module " + m.first->ID + " depends on " + d.name +
+                                                      ", which is an output only diagnostic.");
+            }
+        }
+    }
+
     //now we know what outputs we have, and have ensure that's valid, we need to ensure the user hasn't asked to output
     // a variable that won't be created, otherwise this will segfault.
 
@@ -1575,6 +1687,15 @@ void core::init(int argc, char **argv)
 
     determine_startend_ts_forcing();
 
+#ifdef USE_MPI
+    // the station lists are final at this point, so each rank's share of the forcing is known
+    if (_comm_world.size() > 1 && _metdata->is_netcdf() && _forcing_ranks_per_aggregator != 1 && !point_mode.enable)
+    {
+        SPDLOG_DEBUG("Setting up forcing I/O aggregation");
+        _metdata->init_io_aggregation(_comm_world, _forcing_ranks_per_aggregator);
+    }
+#endif
+
     //set interpolation algorithm
     _global->interp_algorithm = _interpolation_method;
 
@@ -1635,19 +1756,10 @@ void core::init(int argc, char **argv)
     _mesh->init_face_data(_provided_var_module, _provided_var_vector, module_list);
 
     timer c;
-    SPDLOG_DEBUG("Running init() for each module");
-    c.tic();
-
-
-    for (auto& itr : _modules)
-    {
-      spdlog::debug("\t{}", itr.first->ID);
-      itr.first->init(_mesh);
-    }
 
+    _init_modules();
 
-
-    SPDLOG_DEBUG("Took {}ms", c.toc<ms>());
+    _init_forcing_cache();
 
     //we do this here now because init is allowing a module to chance its mind and declare itself
     // data parallel or domain parallel after the fact.
@@ -1845,7 +1957,10 @@ void core::_determine_module_dep()
                         }
 
                         if (!ignore)
+                        {
                             boost::add_edge(itr_module->IDnum, module->IDnum, e, g);
+                            _module_predecessors[module->IDnum].insert(itr_module->IDnum);
+                        }
 
                         //even if we ignore, inc our depencies so we don't fail later
 
@@ -1889,7 +2004,10 @@ void core::_determine_module_dep()
                         }
 
                         if (!ignore)
+                        {
                             boost::add_edge(itr_module->IDnum, module->IDnum, e, g);
+                            _module_predecessors[module->IDnum].insert(itr_module->IDnum);
+                        }
 
                         //output_graph << itr_module->IDnum << "->" << module->IDnum << " [label=\"" << *i << "\"];" << std::endl;
                         //curr_mod_depends[*i]++; //ref count our variable
@@ -2070,6 +2188,201 @@ void core::_determine_module_dep()
 
 
 
+}
+
+void core::_init_modules()
+{
+    SPDLOG_DEBUG("Running init() for each module");
+
+    timer c;
+    c.tic();
+
+    size_t nmodules = _modules.size();
+    std::vector<double> init_time(nmodules, 0); // ms, same order as _modules
+
+    // Face geometry is read from the compact mesh and never written after loading, so inits that run concurrently can
+    // read neighbouring faces from parallel loops without any warm up
+
+    // _modules is in topological order, so running init() in order on this thread is always safe
+    if(!_parallel_module_init)
+    {
+        for (size_t i = 0; i < nmodules; i++)
+        {
+            SPDLOG_DEBUG("\t{}", _modules[i].first->ID);
+            timer t;
+            t.tic();
+            _modules[i].first->init(_mesh);
+            init_time[i] = t.toc<ms>();
+        }
+    }
+    else
+    {
+        // Modules can read each other's face data in init(), e.g., parameters or initial conditions set by another
+        // module, so a module is only started once every module it depends on has finished
+        std::map<int, size_t> idx_from_id; // IDnum -> index into _modules
+        for (size_t i = 0; i < nmodules; i++)
+            idx_from_id[_modules[i].first->IDnum] = i;
+
+        std::vector<size_t> n_waiting(nmodules, 0); // number of unfinished modules each module depends on
+        std::vector<std::vector<size_t>> dependents(nmodules);
+        for (size_t i = 0; i < nmodules; i++)
+        {
+            for (auto id : _module_predecessors[_modules[i].first->IDnum])
+            {
+                dependents.at(idx_from_id.at(id)).push_back(i);
+                n_waiting[i]++;
+            }
+        }
+
+        std::deque<size_t> ready;
+        for (size_t i = 0; i < nmodules; i++)
+            if (n_waiting[i] == 0)
+                ready.push_back(i);
+
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<size_t> finished; // guarded by mutex
+        std::exception_ptr error;    // guarded by mutex
+        std::vector<std::thread> workers;
+
+        // OpenMP threads not in use by a running init. Each concurrent init gets a share of these and returns it
+        // when done, so the total never exceeds the budget
+        int threads_free = omp_get_max_threads();
+        std::vector<int> threads_used(nmodules, 0);
+        size_t running = 0;
+        size_t ndone = 0;
+
+        auto complete = [&](size_t i)
+        {
+            ndone++;
+            for (auto j : dependents[i])
+            {
+                if (--n_waiting[j] == 0)
+                    ready.push_back(j);
+            }
+        };
+
+        while (ndone < nmodules)
+        {
+            int nconcurrent = std::count_if(ready.begin(), ready.end(),
+                                            [&](size_t i) { return _modules[i].first->has_thread_safe_init(); });
+
+            for (auto it = ready.begin(); it != ready.end() && threads_free > 0;)
+            {
+                if (!_modules[*it].first->has_thread_safe_init())
+                {
+                    ++it;
+                    continue;
+                }
+
+                // split the free OpenMP threads between the inits that can start now. Any that don't get a thread
+                // wait in ready for a running init to finish
+                size_t i = *it;
+                int share = std::max(1, threads_free / nconcurrent);
+                threads_free -= share;
+                threads_used[i] = share;
+                nconcurrent--;
+                running++;
+                SPDLOG_DEBUG("\t{} [concurrent, {} threads]", _modules[i].first->ID, share);
+
+                workers.emplace_back(
+                    [&, i, share]
+                    {
+                        omp_set_num_threads(share);
+
+                        timer t;
+                        t.tic();
+                        std::exception_ptr e;
+                        try
+                        {
+                            _modules[i].first->init(_mesh);
+                        }
+                        catch (...)
+                        {
+                            e = std::current_exception();
+                        }
+
+                        std::lock_guard<std::mutex> lock(mutex);
+                        init_time[i] = t.toc<ms>();
+                        if (e && !error)
+                            error = e;
+                        finished.push_back(i);
+                        cv.notify_one();
+                    });
+
+                it = ready.erase(it);
+            }
+
+            // everything else has to run on its own. The order that the concurrent inits finish in differs between
+            // ranks, so take the lowest index rather than the first ready: these inits may do MPI collectives and
+            // have to run in the same order on every rank. When nothing is running, the set of ready modules is the
+            // same on every rank
+            if (running == 0 && !ready.empty())
+            {
+                auto it = std::min_element(ready.begin(), ready.end());
+                size_t i = *it;
+                ready.erase(it);
+
+                SPDLOG_DEBUG("\t{}", _modules[i].first->ID);
+                timer t;
+                t.tic();
+                _modules[i].first->init(_mesh);
+                init_time[i] = t.toc<ms>();
+
+                complete(i);
+                continue;
+            }
+
+            if (running == 0)
+            {
+                CHM_THROW_EXCEPTION(module_error, "Unable to schedule module init, the module dependencies are not a DAG");
+            }
+
+            std::deque<size_t> done_now;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [&] { return !finished.empty(); });
+                std::swap(done_now, finished);
+            }
+
+            for (auto i : done_now)
+            {
+                running--;
+                threads_free += threads_used[i];
+                complete(i);
+            }
+
+            bool failed = false;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                failed = error != nullptr;
+            }
+
+            if (failed)
+            {
+                for (auto& w : workers)
+                    w.join();
+                std::rethrow_exception(error);
+            }
+        }
+
+        for (auto& w : workers)
+            w.join();
+    }
+
+    double total = c.toc<ms>();
+
+    std::vector<size_t> order(nmodules);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return init_time[a] > init_time[b]; });
+
+    double sum = std::accumulate(init_time.begin(), init_time.end(), 0.0);
+    SPDLOG_DEBUG("Module init took {}ms, sum of module init times {}ms", total, sum);
+    for (auto i : order)
+    {
+        SPDLOG_DEBUG("\t{:<30} {:>10}ms  {:5.1f}%", _modules[i].first->ID, init_time[i],
+                     sum > 0 ? 100.0 * init_time[i] / sum : 0.0);
+    }
 }
 
 void core::_schedule_modules()
@@ -2079,6 +2392,13 @@ void core::_schedule_modules()
     size_t chunk_itr = 0;
     for (auto &itr : _modules)
     {
+        // the replayed forcing cache provides these modules' outputs
+        if (_forcing_cache.get_mode() == forcing_cache::mode::replay && _cached_modules.count(itr.first->ID))
+        {
+            SPDLOG_DEBUG("Not running module {}, replayed from the forcing cache", itr.first->ID);
+            continue;
+        }
+
         SPDLOG_DEBUG( "Chunking module: {}", itr.first->ID);
         //first case, empty list
         if (_chunked_modules.size() == 0)
@@ -2100,6 +2420,18 @@ void core::_schedule_modules()
         }
     }
 
+    if (_forcing_cache.get_mode() == forcing_cache::mode::record)
+    {
+        for (size_t i = 0; i < _chunked_modules.size(); ++i)
+        {
+            for (auto& jtr : _chunked_modules[i])
+            {
+                if (_cached_modules.count(jtr->ID))
+                    _forcing_cache_chunk = i;
+            }
+        }
+    }
+
     chunks = 0;
     for (auto &itr : _chunked_modules)
     {
@@ -2110,9 +2442,242 @@ void core::_schedule_modules()
         }
         chunks++;
     }
+
+    // Data chunks with a block kernel module are run over blocks of faces. Build the face columns the block kernels
+    // read and write through. Chunks with a module that skips snow-free faces also run over blocks, so that whole
+    // snow-free blocks are skipped. With perf counters every data chunk runs over blocks, so that the counters are
+    // read once per module and block instead of around every face
+    _block_chunks.assign(_chunked_modules.size(), false);
+    std::set<std::string> block_variables;
+    std::set<std::string> block_parameters;
+    for (size_t i = 0; i < _chunked_modules.size(); ++i)
+    {
+        for (auto& jtr : _chunked_modules.at(i))
+        {
+            if (jtr->parallel_type() != module_base::parallel::data)
+                continue;
+
+            if ((_snow_free_fast_path && jtr->skips_if_snow_free()) || _perf_counters.enable)
+                _block_chunks.at(i) = true;
+
+            if (!jtr->has_block_kernel())
+                continue;
+
+            _block_chunks.at(i) = true;
+            for (auto& v : *(jtr->provides()))
+                block_variables.insert(v.name);
+            for (auto& v : *(jtr->depends()))
+                block_variables.insert(v.name);
+            for (auto& v : *(jtr->optionals()))
+                block_variables.insert(v);
+            for (auto& p : *(jtr->provides_parameter()))
+                block_parameters.insert(p);
+        }
+
+        if (_block_chunks.at(i))
+            SPDLOG_DEBUG("Chunk {} runs over blocks of {} faces", i, _block_size);
+    }
+
+    if (!block_variables.empty() || !block_parameters.empty())
+    {
+        auto params = _mesh->parameters();
+        block_parameters.insert(params.begin(), params.end());
+        _mesh->init_face_columns(block_variables, block_parameters);
+    }
+
+#ifdef STATIC_PIPELINE
+    // A data chunk can only use the static pipeline if every module in it was compiled in
+    _static_chunk_ids.resize(_chunked_modules.size());
+    for (size_t i = 0; i < _chunked_modules.size(); ++i)
+    {
+        auto& chunk = _chunked_modules.at(i);
+        if (chunk.at(0)->parallel_type() != module_base::parallel::data)
+            continue;
+
+        std::vector<int> ids;
+        for (auto &jtr : chunk)
+        {
+            int id = static_pipeline::id(jtr.get());
+            if (id == -1)
+            {
+                SPDLOG_DEBUG("Module {} is not in the static pipeline", jtr->ID);
+                ids.clear();
+                break;
+            }
+            ids.push_back(id);
+        }
+
+        // block chunks are run by _run_blocks, which always uses dynamic dispatch
+        if (_block_chunks.at(i))
+            ids.clear();
+
+        SPDLOG_INFO("Chunk {} uses {} dispatch", i, ids.empty() ? "dynamic" : "static");
+        _static_chunk_ids.at(i) = ids;
+    }
+#endif
+}
+
+
+
+void core::_evaluate_diagnostics(size_t max_ts, size_t current_ts)
+{
+    if (_diagnostics.empty())
+        return;
+
+    // the diagnostics a mesh output writes this timestep. An output without a variable list writes everything
+    std::vector<diagnostic*> mesh_diagnostics;
+    for (auto& d : _diagnostics)
+    {
+        for (auto& itr : _outputs)
+        {
+            if (itr.type == output_info::output_type::mesh &&
+                itr.should_output(max_ts, current_ts, _global->_current_date) &&
+                (itr.variables.empty() || itr.variables.count(d.name)))
+            {
+                mesh_diagnostics.push_back(&d);
+                break;
+            }
+        }
+    }
+
+    if (!mesh_diagnostics.empty())
+    {
+#ifdef OMP_SAFE_EXCEPTION
+        ompException e;
+#endif
+
+        #pragma omp parallel for
+        for (size_t i = 0; i < _mesh->size_faces(); i++)
+        {
+#ifdef OMP_SAFE_EXCEPTION
+            e.Run(
+                [&]
+                {
+#endif
+                    auto face = _mesh->face(i);
+                    for (auto d : mesh_diagnostics)
+                        (*face)[d->hash] = d->fn(face);
+#ifdef OMP_SAFE_EXCEPTION
+                });
+#endif
+        }
+#ifdef OMP_SAFE_EXCEPTION
+        e.Rethrow();
+#endif
+    }
+
+    for (auto& itr : _outputs)
+    {
+        if (itr.type == output_info::output_type::time_series)
+        {
+            for (auto& d : _diagnostics)
+                (*itr.face)[d.hash] = d.fn(itr.face);
+        }
+    }
 }
 
+void core::_run_blocks(std::vector<module>& chunk, size_t chunk_idx)
+{
+#ifdef OMP_SAFE_EXCEPTION
+    ompException e;
+#endif
+    size_t nfaces = _mesh->size_faces();
+
+    // in point mode, blocks of one face so that only the output face is run
+    size_t block = point_mode.enable ? 1 : _block_size;
+    size_t nblocks = (nfaces + block - 1) / block;
+
+    auto run_block = [&](face_range& range, size_t b)
+    {
+        size_t begin = b * block;
+        size_t end = std::min(nfaces, begin + block);
+
+        if (point_mode.enable && _mesh->face(begin)->_debug_name != _outputs[0].name)
+            return;
+
+#ifdef OMP_SAFE_EXCEPTION
+        e.Run(
+            [&]
+            {
+#endif
+                // modules in a chunk only depend on earlier modules at the same face, so running each module over
+                // the whole block before the next keeps the per-face order
+                for (auto& jtr : chunk)
+                {
+                    // a block that ended the last timestep without snow and has none now
+                    if (jtr->skips_if_snow_free() && jtr->snow_free(*_mesh, begin, end))
+                        continue;
+
+                    if (jtr->has_block_kernel())
+                    {
+                        range.set(begin, end);
+                        if (_perf_counters.enable)
+                            _perf_counters.measure(jtr->IDnum, [&] { jtr->run(range); range.commit(); });
+                        else
+                        {
+                            jtr->run(range);
+                            range.commit();
+                        }
+                        continue;
+                    }
+
+                    auto run_faces = [&]
+                    {
+                        for (size_t i = begin; i < end; i++)
+                        {
+                            auto face = _mesh->face(i);
+                            if (jtr->skips_if_snow_free() && jtr->snow_free(face))
+                                continue;
+
+                            jtr->run(face);
+                        }
+                    };
+
+                    if (_perf_counters.enable)
+                        _perf_counters.measure(jtr->IDnum, run_faces);
+                    else
+                        run_faces();
+                }
+#ifdef OMP_SAFE_EXCEPTION
+            });
+#endif
+    };
+
+    if (_cost_schedule)
+    {
+        auto& schedule = _chunk_schedules.at(chunk_idx);
+
+        #pragma omp parallel
+        {
+            face_range range(*_mesh);
+
+            // normally one range per thread, but be robust to getting fewer threads than the schedule was made for
+            for (int p = omp_get_thread_num(); p < schedule.parts(); p += omp_get_num_threads())
+            {
+                for (size_t b = schedule.begin(p); b < schedule.end(p); b++)
+                {
+                    auto start = std::chrono::steady_clock::now();
+                    run_block(range, b);
+                    schedule.add(b, std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+                }
+            }
+        }
+    }
+    else
+    {
+        #pragma omp parallel
+        {
+            face_range range(*_mesh);
 
+            #pragma omp for
+            for (size_t b = 0; b < nblocks; b++)
+                run_block(range, b);
+        }
+    }
+#ifdef OMP_SAFE_EXCEPTION
+    e.Rethrow();
+#endif
+}
 
 void core::run()
 {
@@ -2129,23 +2694,31 @@ void core::run()
     SPDLOG_DEBUG("Loading first timestep's met data");
     // Populate the stations with the first timestep's data.
     // We can do this _once_ without incrementing the internal iterators
-    _metdata->next();
+    _next_forcing();
 
     SPDLOG_DEBUG("Starting model run");
 
     c.tic();
 
+    if (_perf_counters.enable)
+        _init_perf_counters();
+
+    if (_cost_schedule)
+        _init_cost_schedules();
+
     double meantime = 0;
     size_t current_ts = 0;
     _global->timestep_counter = 0; //use this to pass the timestep info to the modules for easier debugging specific timesteps
     size_t max_ts = _metdata->n_timestep();
     bool done = false;
+    bool failed = false;           // a module threw
+    bool forcing_finished = false; // the run ended because the forcing ran out, i.e., it ran to the end
 
     while (!done)
     {
         boost::posix_time::ptime t;
 
-        _global->_current_date = _metdata->current_time();
+        _global->set_current_date(_metdata->current_time());
 
         SPDLOG_DEBUG("Timestep: {}\tstep#{}", boost::posix_time::to_simple_string(_global->posix_time()), current_ts);
 
@@ -2156,24 +2729,62 @@ void core::run()
         size_t chunks = 0;
         try
         {
+            if (_forcing_cache.get_mode() == forcing_cache::mode::replay)
+                _forcing_cache.read(_mesh, _global->posix_time());
+
             for (auto &itr : _chunked_modules)
             {
+                // timestep wide values, computed serially before any thread reads them
+                for (auto &jtr : itr)
+                    jtr->pre_timestep();
 
-                if (itr.at(0)->parallel_type() == module_base::parallel::data)
+                if (itr.at(0)->parallel_type() == module_base::parallel::data && _block_chunks.at(chunks))
+                {
+                    _run_blocks(itr, chunks);
+                }
+                else if (itr.at(0)->parallel_type() == module_base::parallel::data)
                 {
 #ifdef OMP_SAFE_EXCEPTION
                     ompException e;
 #endif
-                    #pragma omp parallel for
-                    for (size_t i = 0; i < _mesh->size_faces(); i++)
+#ifdef STATIC_PIPELINE
+                    const auto& static_ids = _static_chunk_ids.at(chunks);
+#endif
+                    auto run_face = [&](size_t i)
                     {
                         auto face = _mesh->face(i);
                         if (point_mode.enable && face->_debug_name != _outputs[0].name)
-                            continue;
+                            return;
+
+#ifdef STATIC_PIPELINE
+                        // statically composed chunk, no virtual dispatch
+                        if (!static_ids.empty())
+                        {
+#ifdef OMP_SAFE_EXCEPTION
+                            e.Run(
+                                [&]
+                                {
+#endif
+                                    for (size_t k = 0; k < static_ids.size(); ++k)
+                                    {
+                                        if (itr[k]->skips_if_snow_free() && itr[k]->snow_free(face))
+                                            continue;
+
+                                        static_pipeline::run(static_ids[k], itr[k].get(), face);
+                                    }
+#ifdef OMP_SAFE_EXCEPTION
+                                });
+#endif
+                            return;
+                        }
+#endif
 
                          //module calls
                          for (auto &jtr : itr)
                          {
+                             if (jtr->skips_if_snow_free() && jtr->snow_free(face))
+                                 continue;
+
 #ifdef OMP_SAFE_EXCEPTION
                              e.Run(
                                  [&]
@@ -2184,6 +2795,31 @@ void core::run()
                                  });
 #endif
                          }
+                    };
+
+                    if (_cost_schedule)
+                    {
+                        auto& schedule = _chunk_schedules.at(chunks);
+
+                        // each thread runs a contiguous range of faces weighted by their measured cost
+                        #pragma omp parallel
+                        {
+                            for (int p = omp_get_thread_num(); p < schedule.parts(); p += omp_get_num_threads())
+                            {
+                                for (size_t i = schedule.begin(p); i < schedule.end(p); i++)
+                                {
+                                    auto start = std::chrono::steady_clock::now();
+                                    run_face(i);
+                                    schedule.add(i, std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+                                }
+                            }
+                        }
+                    }
+                    else
+                    {
+                        #pragma omp parallel for
+                        for (size_t i = 0; i < _mesh->size_faces(); i++)
+                            run_face(i);
                     }
 #ifdef OMP_SAFE_EXCEPTION
                     e.Rethrow();
@@ -2194,10 +2830,17 @@ void core::run()
                     //module calls for domain parallel
                     for (auto &jtr : itr)
                     {
-                      jtr->run(_mesh);
+                        // only the calling thread is counted for domain parallel modules
+                        if (_perf_counters.enable)
+                            _perf_counters.measure(jtr->IDnum, [&] { jtr->run(_mesh); });
+                        else
+                            jtr->run(_mesh);
                     }
                 }
 
+                if (_forcing_cache.get_mode() == forcing_cache::mode::record && chunks == _forcing_cache_chunk)
+                    _forcing_cache.write(_mesh, _global->posix_time());
+
                 chunks++;
 
             }
@@ -2209,6 +2852,7 @@ void core::run()
             SPDLOG_ERROR("Exception has occured. Timeseries and meshes WILL BE INCOMPLETE!");
             *_end_ts = _global->posix_time();
             done = true;
+            failed = true;
             SPDLOG_ERROR(boost::diagnostic_information(e));
 
         }
@@ -2218,9 +2862,16 @@ void core::run()
             SPDLOG_ERROR(e.what());
             *_end_ts = _global->posix_time();
             done = true;
+            failed = true;
             SPDLOG_ERROR(e.what());
         }
 
+        if (!done)
+            _update_snow_free();
+
+        if (!done)
+            _evaluate_diagnostics(max_ts, current_ts);
+
         // check that we actually need a mesh output this timestep
         for (auto &itr : _outputs)
         {
@@ -2244,7 +2895,8 @@ void core::run()
         {
             SPDLOG_DEBUG("Checkpointing...");
 
-            netcdf savestate; //file to save to when checkpointing.
+            // a previous checkpoint may still be draining to the same files
+            _finish_checkpoint_drain();
 
             auto timestamp = _global->posix_time() + boost::posix_time::seconds(_global->_dt);
             //also write it out in seconds because netcdf is struggling with the string
@@ -2259,33 +2911,38 @@ void core::run()
 #endif
 
             auto dirpath = _checkpoint_opts.ckpt_path / timestr;
-            boost::filesystem::create_directories(dirpath);
+            auto writepath = _checkpoint_opts.local_path ? *_checkpoint_opts.local_path / timestr : dirpath;
+            boost::filesystem::create_directories(writepath);
 
             //this parses both the input and the output paths for the checkpoint.
             auto fname = ("chkp"+timestr + "_" + std::to_string(rank) + ".nc");
-            auto f = dirpath / fname;
-            savestate.create( f.string());
+            auto f = writepath / fname;
 
             c.tic();
-            for (auto &itr : _chunked_modules)
             {
-                //module calls
-                for (auto &jtr : itr)
+                netcdf savestate; //file to save to when checkpointing. Closed at the end of this scope
+                savestate.create( f.string());
+
+                for (auto &itr : _chunked_modules)
                 {
-                    jtr->checkpoint(_mesh, savestate);
+                    //module calls
+                    for (auto &jtr : itr)
+                    {
+                        jtr->checkpoint(_mesh, savestate);
+                    }
                 }
-            }
 
-            auto& ids = _mesh->get_global_IDs();
-            savestate.create_variable1D("global_id",ids.size());
+                auto& ids = _mesh->get_global_IDs();
+                savestate.create_variable1D("global_id",ids.size());
 
-            for (size_t i = 0; i < ids.size(); i++)
-            {
-                savestate.put_var1D("global_id", i, ids[i]);
-            }
+                for (size_t i = 0; i < ids.size(); i++)
+                {
+                    savestate.put_var1D("global_id", i, ids[i]);
+                }
 
-            savestate.get_ncfile().putAtt("restart_time",boost::posix_time::to_simple_string(timestamp));
-            savestate.get_ncfile().putAtt("restart_time_sec", netCDF::ncUint64,ts_sec);
+                savestate.get_ncfile().putAtt("restart_time",boost::posix_time::to_simple_string(timestamp));
+                savestate.get_ncfile().putAtt("restart_time_sec", netCDF::ncUint64,ts_sec);
+            }
 
             pt::ptree tree;
 
@@ -2311,11 +2968,41 @@ void core::run()
             tree.add_child("files", tmp_files);
 
 
-            if(rank == 0)
+            auto json_path = _checkpoint_opts.ckpt_path / ("checkpoint_" + timestr + ".np" + std::to_string(nranks) + ".json");
+
+            if(_checkpoint_opts.local_path)
+            {
+                // the json is only written once every rank's file is on ckpt_path, see _finish_checkpoint_drain
+                auto& drain = _checkpoint_opts.drain;
+                drain = std::make_unique<chkptOp::drain_info>();
+                drain->json = tree;
+                drain->json_path = json_path;
+                drain->thread = std::thread(
+                    [f, dirpath, fname, &error = drain->error]()
+                    {
+                        try
+                        {
+                            boost::filesystem::create_directories(dirpath);
+
+                            // copy then rename so that a partially copied file is never mistaken for a complete one
+                            auto tmp = dirpath / (fname + ".part");
+#if BOOST_VERSION < 107400
+                            boost::filesystem::copy_file(f, tmp, boost::filesystem::copy_option::overwrite_if_exists);
+#else
+                            boost::filesystem::copy_file(f, tmp, boost::filesystem::copy_options::overwrite_existing);
+#endif
+                            boost::filesystem::rename(tmp, dirpath / fname);
+                            boost::filesystem::remove(f);
+                        }
+                        catch (...)
+                        {
+                            error = std::current_exception();
+                        }
+                    });
+            }
+            else if(rank == 0)
             {
-                pt::write_json(
-                    (_checkpoint_opts.ckpt_path / ("checkpoint_" + timestr + ".np" + std::to_string(nranks) + ".json")).string(),
-                    tree);
+                pt::write_json(json_path.string(), tree);
             }
 
             SPDLOG_DEBUG("Done checkpoint [ {} s]", c.toc<s>());
@@ -2407,8 +3094,17 @@ void core::run()
                 }
             }
 
-            if(!_metdata->next())
+            if (_perf_counters.enable)
+                _end_timestep_perf_counters();
+
+            if (_cost_schedule)
+                _end_timestep_cost_schedules();
+
+            if(!_next_forcing())
+            {
                 done = true;
+                forcing_finished = !failed;
+            }
 
             auto timestep = c.toc<ms>();
             meantime += timestep;
@@ -2444,6 +3140,18 @@ void core::run()
         double elapsed = c.toc<s>();
         SPDLOG_DEBUG("Total runtime was {}s", elapsed);
 
+    // publish the last checkpoint
+    _finish_checkpoint_drain();
+
+    if (_perf_counters.enable)
+        _write_perf_counters();
+
+    if (_cost_schedule)
+        _report_cost_schedules();
+
+    // only a run that got to the end of the forcing leaves a cache that can be replayed. A run stopped by an exception
+    // or by a checkpoint time limit does not
+    _forcing_cache.close(forcing_finished);
 
 
     std::string base_name="";
@@ -2489,6 +3197,480 @@ void core::run()
     }
 }
 
+void core::_update_snow_free()
+{
+    // without swe there is no snow model and nothing to skip
+    if (!_snow_free_fast_path || !_provided_var_module.count("swe"))
+        return;
+
+    // same blocks as _run_blocks
+    _mesh->update_snow_free(_block_size);
+}
+
+void core::_init_forcing_cache()
+{
+    _forcing_cache_skip_io = false;
+    _forcing_cache_chunk = 0;
+
+    if (_forcing_cache_dir.empty())
+        return;
+
+    std::map<std::string, std::string> provider; // variable -> module ID
+    for (auto& m : _modules)
+    {
+        for (auto& v : *(m.first->provides()))
+            provider[v.name] = m.first->ID;
+    }
+
+    // the modules that read the stations, as long as every module output they read is also cached. _modules is in
+    // run order, so a module's providers have already been decided
+    for (auto& m : _modules)
+    {
+        if (m.first->depends_from_met()->empty())
+            continue;
+
+        auto inputs = m.first->get_variable_names_from_collection(*(m.first->depends()));
+        inputs.insert(inputs.end(), m.first->optionals()->begin(), m.first->optionals()->end());
+
+        bool cacheable = true;
+        for (auto& v : inputs)
+        {
+            auto p = provider.find(v);
+            if (p != provider.end() && !_cached_modules.count(p->second))
+                cacheable = false;
+        }
+
+        if (cacheable)
+            _cached_modules.insert(m.first->ID);
+        else
+            SPDLOG_DEBUG("Module {} reads the forcing but depends on a module that isn't cached, not caching it",
+                         m.first->ID);
+    }
+
+    if (_cached_modules.empty())
+    {
+        SPDLOG_WARN("option.forcing_cache is set but no module interpolates the forcing, not caching");
+        return;
+    }
+
+    std::vector<std::string> variables;
+    std::vector<std::string> vectors;
+    bool all_met_cached = true;
+    for (auto& m : _modules)
+    {
+        if (!_cached_modules.count(m.first->ID))
+        {
+            if (!m.first->depends_from_met()->empty())
+                all_met_cached = false;
+            continue;
+        }
+
+        for (auto& v : *(m.first->provides()))
+            variables.push_back(v.name);
+        for (auto& v : *(m.first->provides_vector()))
+            vectors.push_back(v);
+    }
+
+    std::string rank = "";
+#ifdef USE_MPI
+    rank = "." + std::to_string(_comm_world.rank());
+#endif
+    auto hash = _forcing_cache_hash(variables, vectors);
+    size_t nvalues = variables.size() + 3 * vectors.size();
+    size_t ntimesteps = _metdata->n_timestep();
+
+    // the hash is in the name so that a run with a different configuration, e.g., a restart from a checkpoint, which
+    // changes the start time, records its own cache rather than replacing an existing one
+    std::stringstream name;
+    name << "forcing_cache." << std::hex << std::setw(16) << std::setfill('0') << hash << rank << ".bin";
+
+    boost::filesystem::create_directories(_forcing_cache_dir);
+    auto file = (boost::filesystem::path(_forcing_cache_dir) / name.str()).string();
+
+    int valid = forcing_cache::is_valid(file, hash, _mesh->size_faces(), nvalues, ntimesteps);
+#ifdef USE_MPI
+    // every rank has to agree, as the ranks all read the forcing or all skip it
+    int all_valid = 0;
+    boost::mpi::all_reduce(_comm_world, valid, all_valid, boost::mpi::minimum<int>());
+    valid = all_valid;
+#endif
+
+    if (valid)
+    {
+        _forcing_cache.open_replay(file, variables, vectors, _mesh->size_faces());
+        _forcing_cache_skip_io = all_met_cached;
+        SPDLOG_INFO("Replaying the outputs of {} modules from the forcing cache {}{}", _cached_modules.size(), file,
+                    _forcing_cache_skip_io ? ", the forcing will not be read" : "");
+    }
+    else
+    {
+        _forcing_cache.open_record(file, hash, variables, vectors, _mesh->size_faces(), ntimesteps);
+        SPDLOG_INFO("Recording the outputs of {} modules to the forcing cache {}", _cached_modules.size(), file);
+    }
+    for (auto& m : _cached_modules)
+        SPDLOG_DEBUG("Forcing cache module: {}", m);
+}
+
+uint64_t core::_forcing_cache_hash(const std::vector<std::string>& variables, const std::vector<std::string>& vectors)
+{
+    uint64_t h = 0;
+
+    for (auto& v : variables)
+        h = forcing_cache::hash(v, h);
+    for (auto& v : vectors)
+        h = forcing_cache::hash(v, h);
+
+    // anything referenced by path in these sections is hashed by size and modification time
+    std::function<void(const pt::ptree&)> hash_files = [&](const pt::ptree& tree)
+    {
+        for (auto& itr : tree)
+        {
+            auto& value = itr.second.data();
+            boost::system::error_code ec;
+            if (!value.empty() && boost::filesystem::is_regular_file(value, ec))
+            {
+                h = forcing_cache::hash(value, h);
+                uintmax_t size = boost::filesystem::file_size(value, ec);
+                std::time_t mtime = boost::filesystem::last_write_time(value, ec);
+                h = forcing_cache::hash(&size, sizeof(size), h);
+                h = forcing_cache::hash(&mtime, sizeof(mtime), h);
+            }
+            hash_files(itr.second);
+        }
+    };
+
+    for (auto key : {"meshes", "forcing", "option", "global", "parameter_mapping"})
+    {
+        auto tree = _cfg.get_child_optional(key);
+        if (!tree)
+            continue;
+
+        std::stringstream ss;
+        pt::write_json(ss, *tree, false);
+        h = forcing_cache::hash(ss.str(), h);
+        hash_files(*tree);
+    }
+
+    for (auto& m : _modules)
+    {
+        if (!_cached_modules.count(m.first->ID))
+            continue;
+
+        std::stringstream ss;
+        pt::write_json(ss, m.first->cfg, false);
+        h = forcing_cache::hash(m.first->ID, h);
+        h = forcing_cache::hash(ss.str(), h);
+    }
+
+    auto st = boost::posix_time::to_iso_string(_metdata->start_time());
+    auto et = boost::posix_time::to_iso_string(_metdata->end_time());
+    h = forcing_cache::hash(st, h);
+    h = forcing_cache::hash(et, h);
+
+    const auto& cmesh = _mesh->compact();
+    size_t n = cmesh.size_faces();
+    h = forcing_cache::hash(cmesh.global_id.data(), n * sizeof(size_t), h);
+    h = forcing_cache::hash(cmesh.x.data(), n * sizeof(double), h);
+    h = forcing_cache::hash(cmesh.y.data(), n * sizeof(double), h);
+    h = forcing_cache::hash(cmesh.z.data(), n * sizeof(double), h);
+
+    return h;
+}
+
+bool core::_next_forcing()
+{
+    if (_forcing_cache_skip_io)
+        return _metdata->next_time_only();
+
+    return _metdata->next();
+}
+
+void core::_init_cost_schedules()
+{
+    int nthreads = omp_get_max_threads();
+    size_t nfaces = _mesh->size_faces();
+
+    _chunk_schedules.resize(_chunked_modules.size());
+    for (size_t i = 0; i < _chunked_modules.size(); ++i)
+    {
+        if (_chunked_modules[i].at(0)->parallel_type() != module_base::parallel::data)
+            continue;
+
+        // block chunks are scheduled by block, the others by face
+        size_t n = _block_chunks.at(i) ? (nfaces + _block_size - 1) / _block_size : nfaces;
+        _chunk_schedules[i].init(n, nthreads, _cost_schedule_window);
+    }
+
+    SPDLOG_INFO("Cost weighted face schedule over {} threads, rebalanced every {} timesteps", nthreads,
+                _cost_schedule_window);
+}
+
+void core::_end_timestep_cost_schedules()
+{
+    for (size_t i = 0; i < _chunk_schedules.size(); ++i)
+    {
+        auto& schedule = _chunk_schedules[i];
+        if (schedule.size() == 0)
+            continue;
+
+        if (schedule.end_timestep())
+            SPDLOG_DEBUG("Chunk {}: thread imbalance {:.3f} over the last window, {:.3f} with the new ranges", i,
+                         schedule.measured_imbalance(), schedule.predicted_imbalance());
+    }
+}
+
+void core::_report_cost_schedules()
+{
+    for (size_t i = 0; i < _chunk_schedules.size(); ++i)
+    {
+        auto& schedule = _chunk_schedules[i];
+        if (schedule.size() == 0 || schedule.initial_imbalance() == 0)
+            continue;
+
+        // imbalance is the slowest thread's time over the mean thread time, so 1 is perfectly balanced
+        SPDLOG_INFO("Chunk {}: thread imbalance {:.3f} with equal ranges, {:.3f} with cost weighted ranges", i,
+                    schedule.initial_imbalance(), schedule.measured_imbalance());
+    }
+}
+
+void core::_init_perf_counters()
+{
+    size_t nthreads = omp_get_max_threads();
+    size_t nmodules = _modules.size();
+
+    _perf_counters.counters.resize(nthreads);
+    _perf_counters.thread_totals.assign(nthreads, std::vector<perf_counters::values>(nmodules, perf_counters::values{}));
+    _perf_counters.thread_run_totals = _perf_counters.thread_totals;
+
+    _perf_counters.module_names.resize(nmodules);
+    for (auto &itr : _modules)
+    {
+        _perf_counters.module_names.at(itr.first->IDnum) = itr.first->ID;
+    }
+
+    int available = 0;
+    // perf_event counters are per thread, so they have to be opened by the thread being measured
+#pragma omp parallel reduction(+:available)
+    {
+        auto pc = std::make_unique<perf_counters>();
+        if (pc->open())
+            available++;
+        _perf_counters.counters.at(omp_get_thread_num()) = std::move(pc);
+    }
+
+    // any thread that didn't participate reads zeros
+    for (auto &itr : _perf_counters.counters)
+    {
+        if (!itr)
+            itr = std::make_unique<perf_counters>();
+    }
+
+    // the write reduces over ranks, so either every rank counts or none do
+    int all_available = available > 0;
+#ifdef USE_MPI
+    boost::mpi::all_reduce(_comm_world, available > 0 ? 1 : 0, all_available, boost::mpi::minimum<int>());
+#endif
+
+    if (all_available == 0)
+    {
+        if (available == 0)
+            SPDLOG_WARN("Hardware performance counters are not available, disabling. Check /proc/sys/kernel/perf_event_paranoid");
+        else
+            SPDLOG_WARN("Hardware performance counters are not available on every rank, disabling on all ranks. Check /proc/sys/kernel/perf_event_paranoid");
+
+        _perf_counters.enable = false;
+        _perf_counters.counters.clear();
+        return;
+    }
+
+    if (available != static_cast<int>(nthreads))
+    {
+        SPDLOG_WARN("Hardware performance counters only available on {} of {} threads", available, nthreads);
+    }
+
+    SPDLOG_INFO("Hardware performance counters enabled on {} threads", available);
+}
+
+void core::_end_timestep_perf_counters()
+{
+    size_t nmodules = _perf_counters.module_names.size();
+    std::vector<perf_counters::values> sum(nmodules, perf_counters::values{});
+
+    for (size_t t = 0; t < _perf_counters.thread_totals.size(); ++t)
+    {
+        for (size_t m = 0; m < nmodules; ++m)
+        {
+            auto& v = _perf_counters.thread_totals[t][m];
+            for (size_t k = 0; k < v.size(); ++k)
+            {
+                sum[m][k] += v[k];
+                _perf_counters.thread_run_totals[t][m][k] += v[k];
+            }
+            v.fill(0);
+        }
+    }
+
+    _perf_counters.timesteps.push_back(sum);
+    _perf_counters.timestep_dates.push_back(boost::posix_time::to_iso_string(_global->posix_time()));
+}
+
+void core::_write_perf_counters()
+{
+    size_t nts = _perf_counters.timesteps.size();
+    size_t nmodules = _perf_counters.module_names.size();
+    size_t nthreads = _perf_counters.thread_run_totals.size();
+    size_t nc = perf_counters::n_values;
+
+    std::vector<uint64_t> local(nts * nmodules * nc, 0);
+    for (size_t ts = 0; ts < nts; ++ts)
+        for (size_t m = 0; m < nmodules; ++m)
+            for (size_t k = 0; k < nc; ++k)
+                local[(ts * nmodules + m) * nc + k] = _perf_counters.timesteps[ts][m][k];
+
+    // whole run per thread, kept separate so imbalance between threads and ranks is visible
+    std::vector<uint64_t> local_threads(nthreads * nmodules * nc, 0);
+    for (size_t t = 0; t < nthreads; ++t)
+        for (size_t m = 0; m < nmodules; ++m)
+            for (size_t k = 0; k < nc; ++k)
+                local_threads[(t * nmodules + m) * nc + k] = _perf_counters.thread_run_totals[t][m][k];
+
+    std::vector<uint64_t> total = local;
+    std::vector<std::vector<uint64_t>> threads(1, local_threads);
+#ifdef USE_MPI
+    boost::mpi::reduce(_comm_world, local.data(), local.size(), total.data(), std::plus<uint64_t>(), 0);
+
+    // thread counts can differ between ranks, so gather whole vectors
+    threads.clear();
+    boost::mpi::gather(_comm_world, local_threads, threads, 0);
+
+    if (_comm_world.rank() != 0)
+        return;
+#endif
+
+    auto path = output_folder_path / "perf_counters.csv";
+    std::ofstream out(path.string());
+    out << "datetime,module";
+    for (auto &n : perf_counters::names)
+        out << "," << n;
+    out << "\n";
+
+    std::vector<perf_counters::values> run_total(nmodules, perf_counters::values{});
+    for (size_t ts = 0; ts < nts; ++ts)
+    {
+        for (size_t m = 0; m < nmodules; ++m)
+        {
+            out << _perf_counters.timestep_dates[ts] << "," << _perf_counters.module_names[m];
+            for (size_t k = 0; k < nc; ++k)
+            {
+                auto v = total[(ts * nmodules + m) * nc + k];
+                run_total[m][k] += v;
+                out << "," << v;
+            }
+            out << "\n";
+        }
+    }
+
+    auto thread_path = output_folder_path / "perf_counters_threads.csv";
+    std::ofstream thread_out(thread_path.string());
+    thread_out << "rank,thread,module";
+    for (auto &n : perf_counters::names)
+        thread_out << "," << n;
+    thread_out << "\n";
+
+    for (size_t r = 0; r < threads.size(); ++r)
+    {
+        auto& v = threads[r];
+        for (size_t t = 0; t < v.size() / (nmodules * nc); ++t)
+        {
+            for (size_t m = 0; m < nmodules; ++m)
+            {
+                thread_out << r << "," << t << "," << _perf_counters.module_names[m];
+                for (size_t k = 0; k < nc; ++k)
+                    thread_out << "," << v[(t * nmodules + m) * nc + k];
+                thread_out << "\n";
+            }
+        }
+    }
+
+    SPDLOG_INFO("Hardware counter summary (all ranks and threads), per timestep values in {}, per rank and thread in {}",
+                path.string(), thread_path.string());
+    for (size_t m = 0; m < nmodules; ++m)
+    {
+        auto& v = run_total[m];
+        double instr = std::max<double>(1.0, v[perf_counters::instructions]);
+
+        // per thread spread over all ranks
+        uint64_t min_cycles = std::numeric_limits<uint64_t>::max();
+        uint64_t max_cycles = 0;
+        for (auto& r : threads)
+        {
+            for (size_t t = 0; t < r.size() / (nmodules * nc); ++t)
+            {
+                auto c = r[(t * nmodules + m) * nc + perf_counters::cycles];
+                min_cycles = std::min(min_cycles, c);
+                max_cycles = std::max(max_cycles, c);
+            }
+        }
+
+        SPDLOG_INFO("{:>30}: cycles={:.3e} (thread min={:.3e} max={:.3e}) IPC={:.2f} LLC misses/kinstr={:.3f} "
+                    "branch misses/kinstr={:.3f} PMU running={:.1f}%",
+                    _perf_counters.module_names[m],
+                    static_cast<double>(v[perf_counters::cycles]),
+                    static_cast<double>(min_cycles),
+                    static_cast<double>(max_cycles),
+                    v[perf_counters::instructions] / std::max<double>(1.0, v[perf_counters::cycles]),
+                    1000.0 * v[perf_counters::llc_misses] / instr,
+                    1000.0 * v[perf_counters::branch_misses] / instr,
+                    100.0 * v[perf_counters::time_running] / std::max<double>(1.0, v[perf_counters::time_enabled]));
+    }
+}
+
+void core::_finish_checkpoint_drain()
+{
+    auto& drain = _checkpoint_opts.drain;
+    if (!drain)
+        return;
+
+    timer c;
+    c.tic();
+    drain->thread.join();
+
+    int failed = drain->error != nullptr;
+    if (failed)
+    {
+        try
+        {
+            std::rethrow_exception(drain->error);
+        }
+        catch (std::exception& e)
+        {
+            SPDLOG_ERROR("Draining checkpoint to {} failed: {}", _checkpoint_opts.ckpt_path.string(), e.what());
+        }
+    }
+
+    int rank = 0;
+#ifdef USE_MPI
+    int any_failed = 0;
+    boost::mpi::all_reduce(_comm_world, failed, any_failed, boost::mpi::maximum<int>());
+    failed = any_failed;
+    rank = _comm_world.rank();
+#endif
+
+    if (failed)
+    {
+        drain.reset();
+        CHM_THROW_EXCEPTION(chm_error, "Failed to drain checkpoint from local_path");
+    }
+
+    if (rank == 0)
+    {
+        pt::write_json(drain->json_path.string(), drain->json);
+    }
+
+    SPDLOG_DEBUG("Checkpoint drain finished [ {} s]", c.toc<s>());
+    drain.reset();
+}
+
 void core::end(const bool abort)
 {
 #ifdef USE_MPI
@@ -2577,6 +3759,12 @@ void core::populate_face_station_lists()
 
     SPDLOG_DEBUG("Populating each face's station list");
 
+    // Neighbouring faces nearly always resolve to the same set of stations. Intern the lists so that faces with identical
+    // station sets share a single list. Keyed on the raw pointers in search order, as the order determines the interpolant
+    // weights ordering.
+    std::map< std::vector<station*>, std::shared_ptr< std::vector< std::shared_ptr<station> > > > unique_lists;
+    size_t max_stations = 0;
+
     for (size_t i = 0; i < _mesh->size_faces(); i++)
     {
         auto f = _mesh->face(i);
@@ -2584,7 +3772,20 @@ void core::populate_face_station_lists()
         if ( f->stations().size() == 0 )
         {
             auto stations = _metdata->get_stations(f->get_x(), f->get_y());
-            f->stations().insert(std::end(f->stations()), std::begin(stations), std::end(stations));
+
+            std::vector<station*> key;
+            key.reserve(stations.size());
+            for(auto& s : stations)
+                key.push_back(s.get());
+
+            auto& list = unique_lists[key];
+            if(!list)
+            {
+                list = std::make_shared< std::vector< std::shared_ptr<station> > >(std::move(stations));
+                max_stations = std::max(max_stations, list->size());
+            }
+
+            f->set_stations(list);
 
             f->nearest_station() = _metdata->nearest_station(f->get_x(), f->get_y()).at(0);
 
@@ -2594,6 +3795,9 @@ void core::populate_face_station_lists()
         }
     }
 
+    SPDLOG_DEBUG("{} unique station lists across {} faces, with at most {} stations per face",
+                 unique_lists.size(), _mesh->size_faces(), max_stations);
+
 }
 
 void core::populate_distributed_station_lists()
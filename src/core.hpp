@@ -35,16 +35,24 @@
 #include <algorithm>
 #include <chrono>
 #include <chrono>
+#include <condition_variable>
 #include <cstdlib>
 #include <cstdlib>
+#include <deque>
 #include <errno.h>
+#include <exception>
 #include <fstream>
+#include <functional>
+#include <iomanip>
 #include <map>
 #include <memory> //unique ptr
+#include <mutex>
+#include <numeric>
 #include <set>
 #include <sstream>
 #include <stdio.h>
 #include <string>
+#include <thread>
 #include <unistd.h> //for getpid
 #include <utility> // std::pair
 #include <vector>
@@ -93,13 +101,21 @@ namespace po = boost::program_options;
 #include "station.hpp"
 #include "str_format.h"
 #include "timer.hpp"
+#include "perf_counters.hpp"
+#include "cost_schedule.hpp"
+#include "forcing_cache.hpp"
 #include "timeseries/netcdf.hpp"
 #include "triangulation.hpp"
 #include "version.h"
 
+#ifdef STATIC_PIPELINE
+#include "static_pipeline.hpp"
+#endif
+
 #ifdef USE_MPI
 #include <boost/mpi.hpp>
 #include <boost/serialization/string.hpp>
+#include <boost/serialization/vector.hpp>
 #endif
 
 struct vertex{
@@ -197,6 +213,12 @@ public:
     void config_global( pt::ptree& value);
     void config_checkpoint( pt::ptree& value);
 
+    /**
+     * Waits for the checkpoint being drained from the node-local checkpoint path, if any, and once every rank has
+     * drained its file writes that checkpoint's json. Collective.
+     */
+    void _finish_checkpoint_drain();
+
     /**
      * Determines what the start end times should be, and ensures consistency from a check pointed file
      */
@@ -206,6 +228,12 @@ public:
      * Determines the order modules need to be scheduleled in to maximize parallelism
      */
     void _schedule_modules();
+
+    /**
+     * Calls init() for every module. Modules whose init is thread safe are run concurrently as soon as all the
+     * modules they depend on have been initialized, otherwise init() is run alone. Logs the per-module init times.
+     */
+    void _init_modules();
     void _find_and_insert_subjson(pt::ptree& value);
 
     /**
@@ -277,6 +305,25 @@ protected:
     //this is called via system call when the model is done to notify the user
     std::string _notification_script;
 
+    // maintain the per-face snow_free flag so that modules can skip snow-free faces. option.snow_free_fast_path
+    bool _snow_free_fast_path;
+    void _update_snow_free();
+
+    // output only diagnostics of all the modules, see module_base::provides_diagnostic
+    struct diagnostic
+    {
+        std::string name;
+        uint64_t hash;
+        std::function<double(mesh_elem&)> fn;
+    };
+    std::vector<diagnostic> _diagnostics;
+
+    /**
+     * Evaluates the diagnostics that will be written this timestep. Those a mesh output requests are evaluated on
+     * every face, and as timeseries outputs write every variable, all of them are evaluated on timeseries faces.
+     */
+    void _evaluate_diagnostics(size_t max_ts, size_t current_ts);
+
     //main mesh object
     boost::shared_ptr< triangulation > _mesh;
 
@@ -292,6 +339,73 @@ protected:
     //pair as we also need to store the make order
     std::vector< std::pair<module,size_t> > _modules;
     std::vector< std::vector < module> > _chunked_modules;
+
+    // module IDnum -> IDnums of the modules it depends on, from the dependency graph. Used to order init()
+    std::map<int, std::set<int> > _module_predecessors;
+
+    // run thread safe module inits concurrently. option.parallel_module_init
+    bool _parallel_module_init;
+
+    // ranks per forcing I/O aggregator, 0 for one per node and 1 for every rank reading its own forcing.
+    // option.forcing_ranks_per_aggregator
+    int _forcing_ranks_per_aggregator;
+
+    // per chunk, true if it is a data chunk with a block kernel module and is run over blocks of faces
+    std::vector<bool> _block_chunks;
+
+    // number of faces per block for block kernels. option.block_size
+    size_t _block_size;
+
+    /**
+     * Runs a data parallel chunk over blocks of faces. Block kernel modules get a face_range for each block, the
+     * others are called per face within the block
+     */
+    void _run_blocks(std::vector<module>& chunk, size_t chunk_idx);
+
+    // weight each thread's range of faces (or blocks) by their measured cost. option.face_schedule = "cost"
+    bool _cost_schedule;
+
+    // timesteps the per-face cost is accumulated over before the ranges are recomputed. option.face_schedule_window
+    size_t _cost_schedule_window;
+
+    // per chunk, the thread ranges of data chunks when _cost_schedule is set
+    std::vector<cost_schedule> _chunk_schedules;
+
+    void _init_cost_schedules();
+    void _end_timestep_cost_schedules();
+    void _report_cost_schedules();
+#ifdef STATIC_PIPELINE
+    // per chunk, the static_pipeline dispatch id of each module. Empty if the chunk has to use virtual dispatch
+    std::vector< std::vector<int> > _static_chunk_ids;
+#endif
+    // directory of the per-rank forcing caches, empty if disabled. option.forcing_cache
+    std::string _forcing_cache_dir;
+    forcing_cache _forcing_cache;
+
+    // IDs of the modules whose outputs are in the forcing cache, i.e., the forcing interpolation modules
+    std::set<std::string> _cached_modules;
+
+    // replaying with every module that reads the stations cached, so the forcing doesn't need to be read at all
+    bool _forcing_cache_skip_io;
+
+    // when recording, the chunk after which all the cached modules have run
+    size_t _forcing_cache_chunk;
+
+    /**
+     * Decides which modules are cached and whether to record or replay. Must be called before the modules are
+     * scheduled, as replayed modules are not run.
+     */
+    void _init_forcing_cache();
+
+    /**
+     * Validity hash of the forcing cache: the mesh, the meshes/forcing/option/global configuration, the size and
+     * modification time of the files they reference, and the cached modules' configuration
+     */
+    uint64_t _forcing_cache_hash(const std::vector<std::string>& variables, const std::vector<std::string>& vectors);
+
+    // advances the forcing one timestep, without reading it if the cache replaces it
+    bool _next_forcing();
+
     std::vector< std::pair<std::string,std::string> > _overrides;
     boost::shared_ptr<global> _global;
 
@@ -328,6 +442,51 @@ protected:
 
     } point_mode;
 
+    /**
+     * Hardware counters per module, enabled with option.perf_counters
+     */
+    struct perf_counter_info
+    {
+        bool enable = false;
+
+        // one counter group per OpenMP thread, opened on that thread
+        std::vector< std::unique_ptr<perf_counters> > counters;
+
+        // [thread][module IDnum], for the current timestep
+        std::vector< std::vector<perf_counters::values> > thread_totals;
+
+        // [thread][module IDnum], for the whole run
+        std::vector< std::vector<perf_counters::values> > thread_run_totals;
+
+        // [timestep][module IDnum], summed over threads
+        std::vector< std::vector<perf_counters::values> > timesteps;
+        std::vector<std::string> timestep_dates;
+
+        std::vector<std::string> module_names; // index is module IDnum
+
+        /**
+         * Runs f, adding the counter deltas to this thread's total for the module. This is two read() calls, so f
+         * should be a module over a block of faces rather than a single face
+         */
+        template<typename F>
+        void measure(int module, F&& f)
+        {
+            int t = omp_get_thread_num();
+
+            perf_counters::values start, end;
+            counters[t]->read(start);
+            f();
+            counters[t]->read(end);
+
+            perf_counters::add_scaled(thread_totals[t][module], start, end);
+        }
+
+    } _perf_counters;
+
+    void _init_perf_counters();
+    void _end_timestep_perf_counters();
+    void _write_perf_counters();
+
 
     class output_info
     {
@@ -536,6 +695,26 @@ protected:
         // used to stop the simulation when we checkpoint when we are outta time
         bool checkpoint_request_terminate;
 
+        // If set, checkpoints are first written to this node-local directory and then drained to ckpt_path by a
+        // background thread. The checkpoint's json is only written once every rank has drained its file.
+        boost::optional<boost::filesystem::path> local_path;
+
+        // The checkpoint currently being drained from local_path
+        struct drain_info
+        {
+            std::thread thread;
+            std::exception_ptr error;
+            pt::ptree json;
+            boost::filesystem::path json_path;
+        };
+        std::unique_ptr<drain_info> drain;
+
+        ~chkptOp()
+        {
+            if (drain && drain->thread.joinable())
+                drain->thread.join();
+        }
+
         /**
          * Should checkpointing occur
          * @param current_ts
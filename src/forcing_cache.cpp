@@ -0,0 +1,226 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+
+#include "forcing_cache.hpp"
+
+#include <cstring>
+
+#include "exception.hpp"
+#include "logger.hpp"
+#include "utility/wyhash.h"
+
+const char forcing_cache::_magic[8] = {'C', 'H', 'M', 'F', 'C', 'A', 'C', 'H'};
+
+forcing_cache::forcing_cache()
+{
+    _mode = mode::off;
+    _nfaces = 0;
+    _nvalues = 0;
+    std::memset(&_header, 0, sizeof(header));
+}
+
+forcing_cache::~forcing_cache()
+{
+    // an unfinished recording is left incomplete so it isn't replayed
+    if (_fs.is_open())
+        _fs.close();
+}
+
+uint64_t forcing_cache::hash(const void* data, size_t len, uint64_t seed)
+{
+    return wyhash(data, len, seed);
+}
+
+uint64_t forcing_cache::hash(const std::string& s, uint64_t seed)
+{
+    return wyhash(s.data(), s.size(), seed);
+}
+
+bool forcing_cache::is_valid(const std::string& file, uint64_t hash, size_t nfaces, size_t nvalues, size_t ntimesteps)
+{
+    std::ifstream in(file, std::ios::binary);
+    if (!in)
+        return false;
+
+    header h;
+    in.read(reinterpret_cast<char*>(&h), sizeof(header));
+    if (!in)
+        return false;
+
+    return std::memcmp(h.magic, _magic, sizeof(_magic)) == 0 && h.version == _version && h.complete == 1 &&
+           h.hash == hash && h.nfaces == nfaces && h.nvalues == nvalues && h.ntimesteps == ntimesteps &&
+           h.expected_timesteps == ntimesteps;
+}
+
+void forcing_cache::set_variables(const std::vector<std::string>& variables, const std::vector<std::string>& vectors,
+                                  size_t nfaces)
+{
+    _variables.clear();
+    for (auto& v : variables)
+        _variables.push_back(xxh64::hash(v.c_str(), v.length()));
+    _vectors = vectors;
+
+    _nfaces = nfaces;
+    _nvalues = variables.size() + 3 * vectors.size();
+    _buffer.resize(_nvalues * _nfaces);
+}
+
+void forcing_cache::open_record(const std::string& file, uint64_t hash, const std::vector<std::string>& variables,
+                                const std::vector<std::string>& vectors, size_t nfaces, size_t ntimesteps)
+{
+    set_variables(variables, vectors, nfaces);
+
+    _file = file;
+    _fs.open(file, std::ios::binary | std::ios::in | std::ios::out | std::ios::trunc);
+    if (!_fs)
+        CHM_THROW_EXCEPTION(io_error, "Unable to create forcing cache " + file);
+
+    std::memcpy(_header.magic, _magic, sizeof(_magic));
+    _header.version = _version;
+    _header.complete = 0;
+    _header.hash = hash;
+    _header.nfaces = _nfaces;
+    _header.nvalues = _nvalues;
+    _header.ntimesteps = 0;
+    _header.expected_timesteps = ntimesteps;
+
+    _fs.write(reinterpret_cast<const char*>(&_header), sizeof(header));
+    _mode = mode::record;
+}
+
+void forcing_cache::open_replay(const std::string& file, const std::vector<std::string>& variables,
+                                const std::vector<std::string>& vectors, size_t nfaces)
+{
+    set_variables(variables, vectors, nfaces);
+
+    _file = file;
+    _fs.open(file, std::ios::binary | std::ios::in);
+    if (!_fs)
+        CHM_THROW_EXCEPTION(io_error, "Unable to open forcing cache " + file);
+
+    _fs.read(reinterpret_cast<char*>(&_header), sizeof(header));
+    _mode = mode::replay;
+}
+
+void forcing_cache::write(mesh& domain, const boost::posix_time::ptime& time)
+{
+    size_t nscalar = _variables.size();
+
+#pragma omp parallel for
+    for (size_t i = 0; i < _nfaces; i++)
+    {
+        auto face = domain->face(i);
+        for (size_t v = 0; v < nscalar; v++)
+            _buffer[v * _nfaces + i] = (*face)[_variables[v]];
+
+        for (size_t v = 0; v < _vectors.size(); v++)
+        {
+            auto vec = face->face_vector(_vectors[v]);
+            size_t k = nscalar + 3 * v;
+            _buffer[k * _nfaces + i] = vec.x();
+            _buffer[(k + 1) * _nfaces + i] = vec.y();
+            _buffer[(k + 2) * _nfaces + i] = vec.z();
+        }
+    }
+
+    write(_buffer, time);
+}
+
+void forcing_cache::write(const std::vector<double>& values, const boost::posix_time::ptime& time)
+{
+    if (values.size() != _nvalues * _nfaces)
+        CHM_THROW_EXCEPTION(io_error, "Forcing cache " + _file + " expects " + std::to_string(_nvalues * _nfaces) +
+                                          " values per timestep, got " + std::to_string(values.size()));
+
+    int64_t t = (time - boost::posix_time::from_time_t(0)).total_seconds();
+    _fs.write(reinterpret_cast<const char*>(&t), sizeof(t));
+    _fs.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(double));
+    if (!_fs)
+        CHM_THROW_EXCEPTION(io_error, "Failed writing forcing cache " + _file);
+
+    _header.ntimesteps++;
+}
+
+void forcing_cache::read(std::vector<double>& values, const boost::posix_time::ptime& time)
+{
+    values.resize(_nvalues * _nfaces);
+
+    int64_t t = 0;
+    _fs.read(reinterpret_cast<char*>(&t), sizeof(t));
+    _fs.read(reinterpret_cast<char*>(values.data()), values.size() * sizeof(double));
+    if (!_fs)
+        CHM_THROW_EXCEPTION(io_error, "Forcing cache " + _file + " ended before " + boost::posix_time::to_simple_string(time));
+
+    int64_t expected = (time - boost::posix_time::from_time_t(0)).total_seconds();
+    if (t != expected)
+        CHM_THROW_EXCEPTION(forcing_error, "Forcing cache " + _file + " is at " +
+                                               boost::posix_time::to_simple_string(boost::posix_time::from_time_t(t)) +
+                                               " but the model is at " + boost::posix_time::to_simple_string(time));
+}
+
+void forcing_cache::read(mesh& domain, const boost::posix_time::ptime& time)
+{
+    read(_buffer, time);
+
+    size_t nscalar = _variables.size();
+
+#pragma omp parallel for
+    for (size_t i = 0; i < _nfaces; i++)
+    {
+        auto face = domain->face(i);
+        for (size_t v = 0; v < nscalar; v++)
+            (*face)[_variables[v]] = _buffer[v * _nfaces + i];
+
+        for (size_t v = 0; v < _vectors.size(); v++)
+        {
+            size_t k = nscalar + 3 * v;
+            face->set_face_vector(_vectors[v], Vector_3(_buffer[k * _nfaces + i], _buffer[(k + 1) * _nfaces + i],
+                                                        _buffer[(k + 2) * _nfaces + i]));
+        }
+    }
+}
+
+void forcing_cache::close(bool finished)
+{
+    if (!_fs.is_open())
+        return;
+
+    if (_mode == mode::record)
+    {
+        _header.complete = finished && _header.ntimesteps == _header.expected_timesteps;
+
+        // the count is also kept for an incomplete file, which helps when looking at one
+        _fs.seekp(0);
+        _fs.write(reinterpret_cast<const char*>(&_header), sizeof(header));
+
+        if (_header.complete)
+            SPDLOG_DEBUG("Forcing cache {} complete with {} timesteps", _file, _header.ntimesteps);
+        else
+            SPDLOG_WARN("Forcing cache {} is incomplete, {} of {} timesteps, and will be recorded again by the next run",
+                        _file, _header.ntimesteps, _header.expected_timesteps);
+    }
+
+    _fs.close();
+    _mode = mode::off;
+}
@@ -0,0 +1,146 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+#include "triangulation.hpp"
+
+/**
+ * Per-rank binary file holding the per-face outputs of the forcing interpolation modules for every timestep, so that
+ * a later run with the same mesh, forcing and interpolation configuration can stream them back into the faces instead
+ * of reading the forcing and interpolating. Meant for calibration, where only downstream parameters change.
+ *
+ * Layout: a fixed header (magic, version, complete flag, hash, number of faces, values per face, number of
+ * timesteps written, number of timesteps in the run), then one contiguous block per timestep of the timestep's epoch
+ * seconds followed by [value][face] doubles. Scalars come first, in the order given, then each vector as its x, y, z
+ * components.
+ *
+ * The file is only valid once close(true) has marked it complete, which it only does if every timestep of the run was
+ * written, so an aborted recording is recorded again.
+ */
+class forcing_cache
+{
+  public:
+    enum class mode
+    {
+        off,
+        record,
+        replay
+    };
+
+    forcing_cache();
+    ~forcing_cache();
+
+    /**
+     * True if file is a complete cache made with this hash for this number of faces and values, holding all ntimesteps
+     */
+    static bool is_valid(const std::string& file, uint64_t hash, size_t nfaces, size_t nvalues, size_t ntimesteps);
+
+    /**
+     * Starts recording a run of ntimesteps, truncating any existing file
+     */
+    void open_record(const std::string& file, uint64_t hash, const std::vector<std::string>& variables,
+                     const std::vector<std::string>& vectors, size_t nfaces, size_t ntimesteps);
+
+    /**
+     * Starts replaying a file that is_valid
+     */
+    void open_replay(const std::string& file, const std::vector<std::string>& variables,
+                     const std::vector<std::string>& vectors, size_t nfaces);
+
+    /**
+     * Appends the current timestep's values of the local faces
+     */
+    void write(mesh& domain, const boost::posix_time::ptime& time);
+
+    /**
+     * Appends a timestep's [value][face] values
+     */
+    void write(const std::vector<double>& values, const boost::posix_time::ptime& time);
+
+    /**
+     * Reads the next timestep's values into the local faces. Throws if the file is at a different timestep.
+     */
+    void read(mesh& domain, const boost::posix_time::ptime& time);
+
+    /**
+     * Reads the next timestep's [value][face] values. Throws if the file is at a different timestep.
+     */
+    void read(std::vector<double>& values, const boost::posix_time::ptime& time);
+
+    /**
+     * Finishes the file. When recording and finished is true, i.e., the run reached the end of the forcing, marks it
+     * complete so that it can be replayed, as long as every timestep was written. Otherwise it is left incomplete.
+     */
+    void close(bool finished = false);
+
+    mode get_mode() const
+    {
+        return _mode;
+    }
+
+    /**
+     * Running 64-bit hash for building the validity hash
+     */
+    static uint64_t hash(const void* data, size_t len, uint64_t seed);
+    static uint64_t hash(const std::string& s, uint64_t seed);
+
+  private:
+    struct header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t complete;
+        uint64_t hash;
+        uint64_t nfaces;
+        uint64_t nvalues;
+        uint64_t ntimesteps; // written
+        uint64_t expected_timesteps;
+    };
+
+    static const char _magic[8];
+    static const uint32_t _version = 2;
+
+    void set_variables(const std::vector<std::string>& variables, const std::vector<std::string>& vectors,
+                       size_t nfaces);
+
+    mode _mode;
+    std::string _file;
+    std::fstream _fs;
+    header _header;
+
+    std::vector<uint64_t> _variables; // hashes of the scalar variables
+    std::vector<std::string> _vectors;
+    size_t _nfaces;
+    size_t _nvalues;
+
+    std::vector<double> _buffer; // [value][face]
+};
@@ -30,6 +30,8 @@ global::global()
     _is_point_mode = false;
     timestep_counter=0;
     _from_checkpoint = false;
+    _calendar = calendar{};
+    _utc_calendar = calendar{};
 }
 
 bool global::is_geographic()
@@ -38,27 +40,27 @@ bool global::is_geographic()
 }
 int global::year()
 {
-    return _current_date.date().year();
+    return _calendar.year;
 }
 int global::day()
 {
-    return _current_date.date().day();
+    return _calendar.day;
 }
 int global::month()
 {
-    return _current_date.date().month();
+    return _calendar.month;
 }
 int global::hour()
 {
-    return boost::posix_time::to_tm(_current_date).tm_hour;
+    return _calendar.hour;
 }
 int global::min()
 {
-    return boost::posix_time::to_tm(_current_date).tm_min;
+    return _calendar.minute;
 }
 int global::sec()
 {
-    return boost::posix_time::to_tm(_current_date).tm_sec;
+    return _calendar.second;
 }
 boost::posix_time::ptime global::posix_time()
 {
@@ -67,9 +69,48 @@ boost::posix_time::ptime global::posix_time()
 
 uint64_t global::posix_time_int()
 {
+    return _calendar.epoch_seconds;
+}
+
+const global::calendar& global::now()
+{
+    return _calendar;
+}
+
+const global::calendar& global::now_utc()
+{
+    return _utc_calendar;
+}
+
+void global::set_current_date(const boost::posix_time::ptime& date)
+{
+    _current_date = date;
+    _calendar = to_calendar(date);
+    _utc_calendar = to_calendar(date + boost::posix_time::hours(_utc_offset));
+}
+
+global::calendar global::to_calendar(const boost::posix_time::ptime& date)
+{
+    calendar c{};
+    if (date.is_special())
+        return c;
+
+    auto ymd = date.date().year_month_day();
+    auto tod = date.time_of_day();
+
+    c.year = ymd.year;
+    c.month = ymd.month;
+    c.day = ymd.day;
+    c.hour = tod.hours();
+    c.minute = tod.minutes();
+    c.second = tod.seconds();
+    c.day_of_year = date.date().day_of_year();
+    c.fractional_hour = c.hour + c.minute / 60.0 + c.second / 3600.0;
+
     const boost::posix_time::ptime epoch = boost::posix_time::from_time_t(0);
-    boost::posix_time::time_duration duration = _current_date - epoch;
-    return duration.total_seconds();
+    c.epoch_seconds = (date - epoch).total_seconds();
+
+    return c;
 }
 
 int global::dt()
@@ -25,6 +25,7 @@
 
 
 
+#include <cstdint>
 #include <string>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/property_tree/ptree.hpp>
@@ -56,10 +57,39 @@ class global
     //This is because global gets passed to all modules and a rogue module could do something dumb
     //const doesn't save us as we actually do want to modify things
     friend class core;
+    friend class SnowFreeTest; // sets the timestep length
+    friend class GlobalTest; // advances the date
+
+public:
+    /**
+     * Calendar fields of a timestep, decomposed once when the timestep advances so that the per-face date accessors
+     * are plain loads
+     */
+    struct calendar
+    {
+        int year;
+        int month; // [1,12]
+        int day;   // [1,31]
+        int hour;
+        int minute;
+        int second;
+        int day_of_year; // [1,366]
+        double fractional_hour; // hour + minute/60 + second/3600
+        uint64_t epoch_seconds; // seconds since 1970-01-01 00:00
+    };
 
 private:
     boost::posix_time::ptime _current_date;
 
+    // _current_date, and _current_date + _utc_offset, decomposed
+    calendar _calendar;
+    calendar _utc_calendar;
+
+    /**
+     * Advances the current date, updating the cached calendars. The only way the date should be changed.
+     */
+    void set_current_date(const boost::posix_time::ptime& date);
+
     int _dt; //seconds
     bool _is_geographic;
     bool _is_point_mode;
@@ -88,6 +118,21 @@ public:
     boost::posix_time::ptime posix_time();
     uint64_t posix_time_int();
 
+    /**
+     * All the calendar fields of the current timestep, in model time
+     */
+    const calendar& now();
+
+    /**
+     * All the calendar fields of the current timestep in UTC, i.e., offset by UTC_offset
+     */
+    const calendar& now_utc();
+
+    /**
+     * Decomposes a date. Special values (e.g., not_a_date_time) give all zeros
+     */
+    static calendar to_calendar(const boost::posix_time::ptime& date);
+
     size_t timestep_counter; // the timestep we are on, start = 0
 
 
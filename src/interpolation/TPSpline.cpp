@@ -178,6 +178,28 @@ double thin_plate_spline::operator()(std::vector< boost::tuple<double,double,dou
     return z0;
 }
 
+std::vector<double> thin_plate_spline::weights(std::vector< boost::tuple<double,double,double> > sample_points, boost::tuple<double,double,double>& query_point)
+{
+    // the weight of sample k is the spline through 1 at sample k and 0 everywhere else
+    bool reuse = reuse_LU;
+    reuse_LU = true;
+    uninit_lu_decomp = true;
+
+    std::vector<double> w(sample_points.size(), 0.0);
+    for (size_t k = 0; k < sample_points.size(); k++)
+    {
+        for (size_t i = 0; i < sample_points.size(); i++)
+            sample_points[i].get<2>() = i == k ? 1.0 : 0.0;
+
+        w[k] = (*this)(sample_points, query_point);
+    }
+
+    reuse_LU = reuse;
+    uninit_lu_decomp = true;
+
+    return w;
+}
+
 thin_plate_spline::thin_plate_spline(size_t sz, std::map<std::string,std::string> config )
 : thin_plate_spline()
 {
@@ -194,7 +216,6 @@ thin_plate_spline::thin_plate_spline(size_t sz, std::map<std::string,std::string
         if(config["reuse_LU"] == "true")
             reuse_LU = true;
     }
-    reuse_LU = false;
 }
 
 thin_plate_spline::thin_plate_spline()
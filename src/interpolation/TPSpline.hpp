@@ -60,6 +60,15 @@ public:
     */
     double operator()(std::vector< boost::tuple<double,double,double> >& sample_points, boost::tuple<double,double,double>& query_point);
 
+    /**
+     * The spline is linear in the sample values, so the interpolated value at query_point is a weighted sum of them.
+     * Returns these weights, which only depend on the sample and query point locations.
+     * \param sample_points Sample point locations. The values are ignored
+     * \param query_point Tuple of x,y,z value that is the point to interpolate to
+     * \return One weight per sample point
+     */
+    std::vector<double> weights(std::vector< boost::tuple<double,double,double> > sample_points, boost::tuple<double,double,double>& query_point);
+
     bool reuse_LU;
 private:
     typedef Eigen::Matrix<double,Eigen::Dynamic,1> VectorXd;
@@ -0,0 +1,101 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+#pragma once
+
+#include "TPSpline.hpp"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include <boost/tuple/tuple.hpp>
+
+/**
+ * \class neighbor_stencil
+ *
+ * Smooths a face value with a thin plate spline through the values of the face's (up to) three edge neighbours,
+ * evaluated at the face centre. The spline is linear in the neighbour values and the mesh geometry does not change,
+ * so the spline is reduced once to three fixed weights and each smoothing is then a weighted sum of the neighbours.
+ * Ghost neighbours must have had the variable communicated before calling apply.
+ */
+class neighbor_stencil
+{
+public:
+    /**
+     * Computes the weights for this face
+     * @param face mesh_elem
+     */
+    template<typename Face>
+    void init(Face& face)
+    {
+        std::vector<boost::tuple<double, double, double> > xy;
+        std::vector<int> idx;
+        for (int j = 0; j < 3; j++)
+        {
+            auto neigh = face->neighbor(j);
+            if (neigh != nullptr)
+            {
+                xy.push_back(boost::make_tuple(neigh->get_x(), neigh->get_y(), 0.0));
+                idx.push_back(j);
+            }
+        }
+
+        _w = {0, 0, 0};
+        _has_neighbors = !xy.empty();
+
+        if (_has_neighbors)
+        {
+            thin_plate_spline tps;
+            auto query = boost::make_tuple(face->get_x(), face->get_y(), face->get_z());
+            auto w = tps.weights(xy, query);
+
+            for (size_t k = 0; k < idx.size(); k++)
+                _w[idx[k]] = w[k];
+        }
+    }
+
+    /**
+     * Smoothed value of the variable at this face. If the face has no neighbours, the face's own value is returned.
+     * @param face mesh_elem
+     * @param variable Variable hash, use _s
+     */
+    template<typename Face>
+    double apply(Face& face, uint64_t variable) const
+    {
+        if (!_has_neighbors)
+            return (*face)[variable];
+
+        double value = 0;
+        for (int j = 0; j < 3; j++)
+        {
+            auto neigh = face->neighbor(j);
+            if (neigh != nullptr)
+                value += _w[j] * (*neigh)[variable];
+        }
+        return value;
+    }
+
+private:
+    std::array<double, 3> _w = {0, 0, 0}; // per neighbour index, 0 for missing neighbours
+    bool _has_neighbors = false;
+};
@@ -0,0 +1,207 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <limits>
+
+namespace math
+{
+    /**
+     * Approximate exp, log and pow for physics kernels. Unlike libm these are inline and free of branches and
+     * selects, only min/max and integer bit operations, so a loop calling them vectorizes even for the baseline
+     * x86-64 target, e.g., the #pragma omp simd layer loop in modules/PBSM3D_profile.cpp.
+     *
+     * Maximum error against libm, measured over the ranges in tests/test_fast_math.cpp:
+     *  - exp: 1 ulp. Underflows gradually to 0 below -708 and overflows to inf above 709.78, as libm.
+     *  - log: 1 ulp for any positive x, including subnormals. log(+0) = -inf, log(inf) = inf, log(x < 0) = NaN,
+     *    and unlike libm log(-0) = NaN.
+     *  - pow: computed as exp(y log x), so the error grows with |y log x|: 2 ulp for |y log x| <= 1, and at most
+     *    2 + 2 |y log x| ulp beyond that. Only x >= 0 is supported and pow(0, 0) = NaN. Use ipow for integer exponents.
+     *
+     * NaN inputs give NaN. Requires IEEE rounding; do not build with -ffast-math, which breaks the rounding trick.
+     * Scalar calls are slower than libm, so only use these in loops that vectorize; libm remains the default.
+     */
+    namespace fast
+    {
+        namespace detail
+        {
+            // 1.5 * 2^52: adding it rounds a double of magnitude < 2^51 to an integer held in the low mantissa bits
+            constexpr double round_shift = 6755399441055744.0;
+
+            constexpr double log2e = 1.4426950408889634074;
+            // ln 2 split so that n * ln2_hi is exact for the n used here
+            constexpr double ln2_hi = 6.93147180369123816490e-01;
+            constexpr double ln2_lo = 1.90821492927058770002e-10;
+
+            // x - sqrt(1/2) in the bits, so that the mantissa ends up in [sqrt(1/2), sqrt(2))
+            constexpr uint64_t log_offset = 0x3FF0000000000000ull - 0x3FE6A09E667F3BCDull;
+
+            /**
+             * 2^n for an integer valued n, |n| <= 1022
+             */
+            inline double exp2i(double n)
+            {
+                uint64_t i = std::bit_cast<uint64_t>(n + round_shift) - std::bit_cast<uint64_t>(round_shift);
+                return std::bit_cast<double>((i + 1023) << 52);
+            }
+
+            /**
+             * An integer held as two's complement in a uint64 to double, |i| < 2^51
+             */
+            inline double to_double(uint64_t i)
+            {
+                return std::bit_cast<double>(std::bit_cast<uint64_t>(round_shift) + i) - round_shift;
+            }
+        }
+
+        /**
+         * exp(x), max 1 ulp
+         */
+        inline double exp(double x)
+        {
+            using namespace detail;
+
+            // beyond these the result is 0 or inf anyway. The bounds are offset by 0 x so that they are not
+            // constants, otherwise GCC folds them through the clamped path and the select becomes a branch that cannot
+            // be vectorized without -fno-trapping-math. Infinities pass through and are fixed below
+            double zero = 0.0 * x;
+            double xc = std::min(std::max(x, zero - 746.0), zero + 710.0);
+
+            // x = n ln2 + r, |r| <= ln2 / 2
+            double n = (xc * log2e + round_shift) - round_shift;
+            double r = (xc - n * ln2_hi) - n * ln2_lo;
+
+            // Taylor series to r^13, truncation error < 1e-18 relative on |r| <= ln2/2
+            double p = 1.0 / 6227020800.0;
+            p = p * r + 1.0 / 479001600.0;
+            p = p * r + 1.0 / 39916800.0;
+            p = p * r + 1.0 / 3628800.0;
+            p = p * r + 1.0 / 362880.0;
+            p = p * r + 1.0 / 40320.0;
+            p = p * r + 1.0 / 5040.0;
+            p = p * r + 1.0 / 720.0;
+            p = p * r + 1.0 / 120.0;
+            p = p * r + 1.0 / 24.0;
+            p = p * r + 1.0 / 6.0;
+            p = p * r + 0.5;
+            p = p * r * r + r; // exp(r) = 1 + r + r^2 p, adding 1 last
+            p = p + 1.0;
+
+            // 2^n in two halves so that each is a normal number. The first multiply is exact and the second rounds
+            // into the subnormals or overflows to inf as needed
+            double n1 = (n * 0.5 + round_shift) - round_shift;
+            double result = p * exp2i(n1) * exp2i(n - n1);
+
+            // exp(inf) = inf, exp(-inf) = 0
+            uint64_t bits = std::bit_cast<uint64_t>(x);
+            uint64_t v = (bits << 1) ^ 0xFFE0000000000000ull;
+            uint64_t inf = 0 - (((v - 1) & ~v) >> 63);
+            uint64_t positive = (bits >> 63) - 1;
+            return std::bit_cast<double>((std::bit_cast<uint64_t>(result) & ~inf) |
+                                         (inf & positive & 0x7FF0000000000000ull));
+        }
+
+        /**
+         * Natural log, max 1 ulp for x > 0
+         */
+        inline double log(double x)
+        {
+            using namespace detail;
+
+            // scale subnormals by 2^54 into the normal range. sub is 1 if the exponent field is 0
+            uint64_t bits = std::bit_cast<uint64_t>(x);
+            uint64_t sub = ((bits >> 52) - 1) >> 63;
+            double xs = x * std::bit_cast<double>((1023 + 54 * sub) << 52);
+            bits = std::bit_cast<uint64_t>(xs);
+
+            // x = 2^k m, m in [sqrt(1/2), sqrt(2))
+            uint64_t u = bits + log_offset;
+            double k = to_double((u >> 52) - 1023 - 54 * sub);
+            double m = std::bit_cast<double>(bits - (u & 0xFFF0000000000000ull) + 0x3FF0000000000000ull);
+
+            // log(m) = 2 atanh(s), s = (m - 1) / (m + 1), |s| < 0.1716. m - 1 is exact
+            double f = m - 1.0;
+            double s = f / (m + 1.0);
+            double s2 = s * s;
+
+            double p = 2.0 / 23.0;
+            p = p * s2 + 2.0 / 21.0;
+            p = p * s2 + 2.0 / 19.0;
+            p = p * s2 + 2.0 / 17.0;
+            p = p * s2 + 2.0 / 15.0;
+            p = p * s2 + 2.0 / 13.0;
+            p = p * s2 + 2.0 / 11.0;
+            p = p * s2 + 2.0 / 9.0;
+            p = p * s2 + 2.0 / 7.0;
+            p = p * s2 + 2.0 / 5.0;
+            p = p * s2 + 2.0 / 3.0;
+
+            // 2s = f - s f, which keeps the largest term exact
+            double logm = f - (s * f - s * s2 * p);
+
+            double result = k * ln2_hi + (logm + k * ln2_lo);
+
+            // special values without selects: +inf and NaN pass through, +0 gives -inf, negatives give NaN. As in exp,
+            // these are written so that neither side of the min is folded to a constant
+            constexpr double max = std::numeric_limits<double>::max();
+            result += x - std::min(x, max);
+            result += std::min(max - 1.0 / xs, 0.0);
+            uint64_t negative = 0 - (std::bit_cast<uint64_t>(x) >> 63);
+            return std::bit_cast<double>(std::bit_cast<uint64_t>(result) | (negative & 0x7FF8000000000000ull));
+        }
+
+        /**
+         * x^y for x >= 0, see the error bound above
+         */
+        inline double pow(double x, double y)
+        {
+            return exp(y * log(x));
+        }
+
+        /**
+         * x^N by repeated squaring, evaluated at compile time into at most 2 log2(N) multiplies
+         */
+        template<int N>
+        constexpr double ipow(double x)
+        {
+            if constexpr (N < 0)
+                return 1.0 / ipow<-N>(x);
+            else if constexpr (N == 0)
+                return 1.0;
+            else if constexpr (N == 1)
+                return x;
+            else if constexpr (N % 2 == 0)
+            {
+                double h = ipow<N / 2>(x);
+                return h * h;
+            }
+            else
+                return x * ipow<N - 1>(x);
+        }
+    }
+}
@@ -0,0 +1,262 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "exception.hpp"
+#include "utility/xxh64.hpp"
+
+/**
+ * Per-face values by name, one contiguous array per name over the faces of a compact_mesh. Replaces the per-face
+ * variablestorage, which built a perfect hash for every face, with a single name lookup shared by all faces.
+ * Missing values are -9999.
+ */
+class face_table
+{
+  public:
+    /**
+     * Sets the stored names. Names that were already stored keep their values, new ones are set to -9999, and the rest
+     * are dropped. Not thread safe; the existing arrays do not move, so column() pointers to kept names stay valid.
+     * @param names
+     * @param nfaces
+     */
+    void init(const std::set<std::string>& names, size_t nfaces)
+    {
+        std::vector<std::string> keep_names;
+        std::vector<std::vector<double>> keep_columns;
+        for (auto& name : names)
+        {
+            keep_names.push_back(name);
+            int i = index(hash_of(name));
+            if (i >= 0 && _columns[i].size() == nfaces)
+                keep_columns.push_back(std::move(_columns[i]));
+            else
+                keep_columns.emplace_back(nfaces, -9999);
+        }
+
+        _names = std::move(keep_names);
+        _columns = std::move(keep_columns);
+        _nfaces = nfaces;
+
+        _index.clear();
+        for (size_t i = 0; i < _names.size(); i++)
+            _index[hash_of(_names[i])] = i;
+    }
+
+    /**
+     * Reorders the faces: face i takes the values of face from[i], or -9999 where from[i] < 0
+     */
+    void permute(const std::vector<int>& from)
+    {
+        for (auto& column : _columns)
+        {
+            std::vector<double> values(from.size(), -9999);
+            for (size_t i = 0; i < from.size(); i++)
+            {
+                if (from[i] >= 0)
+                    values[i] = column[from[i]];
+            }
+            column = std::move(values);
+        }
+        _nfaces = from.size();
+    }
+
+    bool has(const uint64_t& hash) const
+    {
+        return _index.find(hash) != _index.end();
+    }
+
+    /**
+     * Value of face i. Throws if the name is not stored
+     */
+    double& at(const uint64_t& hash, size_t i)
+    {
+        auto itr = _index.find(hash);
+        if (itr == _index.end())
+        {
+            CHM_THROW_EXCEPTION(module_error, "Variable " + std::to_string(hash) + " does not exist.");
+        }
+        return _columns[itr->second][i];
+    }
+
+    double& at(const std::string& name, size_t i)
+    {
+        auto itr = _index.find(hash_of(name));
+        if (itr == _index.end())
+        {
+            CHM_THROW_EXCEPTION(module_error, "Variable " + name + " does not exist.");
+        }
+        return _columns[itr->second][i];
+    }
+
+    /**
+     * The values of every face, or nullptr if the name is not stored
+     */
+    double* column(const uint64_t& hash)
+    {
+        int i = index(hash);
+        return i >= 0 ? _columns[i].data() : nullptr;
+    }
+
+    const std::vector<std::string>& names() const
+    {
+        return _names;
+    }
+
+    /// Number of names stored
+    size_t size() const
+    {
+        return _names.size();
+    }
+
+  private:
+    static uint64_t hash_of(const std::string& name)
+    {
+        return xxh64::hash(name.c_str(), name.length());
+    }
+
+    int index(const uint64_t& hash) const
+    {
+        auto itr = _index.find(hash);
+        return itr != _index.end() ? static_cast<int>(itr->second) : -1;
+    }
+
+    std::vector<std::string> _names;
+    std::vector<std::vector<double>> _columns; // [name][face]
+    std::unordered_map<uint64_t, size_t> _index;
+    size_t _nfaces = 0;
+};
+
+/**
+ * Index based mesh topology, geometry and face data, built by triangulation::build_compact_mesh once the mesh is loaded
+ * and partitioned. This is the only runtime copy of the face geometry and of the face variables, parameters and
+ * initial conditions: the face accessors (center, slope, area, operator[], parameter(), etc.) read them from here
+ * rather than storing them per face. Nothing here depends on CGAL, so runtime code can walk flat arrays instead of
+ * chasing face and vertex handles, and can use them from block kernels. The CGAL triangulation is still used for
+ * loading, geometric queries, and the neighbour handles of the face API. Module data (face_info) and face vectors
+ * remain on the faces, as they are per-module types rather than values.
+ *
+ * Faces are indexed by local face index first, identical to triangulation::face(i), followed by this rank's ghost
+ * faces. Per-face quantities are stored one array per quantity, and per-edge/per-vertex quantities as [face][3] with
+ * the edge/vertex varying fastest. Edge j is opposite vertex j and shared with neighbor j, matching the CGAL face.
+ */
+class compact_mesh
+{
+  public:
+    /**
+     * Neighbor index of an edge without a neighbor on this rank. For a local face this is only the domain boundary, as
+     * every neighbor of a local face is held as a ghost, unless point mode pruned the faces. Ghost faces also have these
+     * towards faces beyond the ghost region.
+     */
+    static constexpr int no_neighbor = -1;
+
+    /// Number of local faces
+    size_t size_faces() const
+    {
+        return _num_local;
+    }
+
+    /// Number of local and ghost faces
+    size_t size() const
+    {
+        return global_id.size();
+    }
+
+    size_t size_vertex() const
+    {
+        return vx.size();
+    }
+
+    /// Index of vertex j of face i
+    int vertex(size_t i, int j) const
+    {
+        return tri_vertex[3 * i + j];
+    }
+
+    /// Index of the face across edge j of face i, or no_neighbor
+    int neighbor(size_t i, int j) const
+    {
+        return tri_neighbor[3 * i + j];
+    }
+
+    bool has_neighbor(size_t i, int j) const
+    {
+        return tri_neighbor[3 * i + j] >= 0;
+    }
+
+    /// Distance between the centroids of face i and neighbor j (m)
+    double neighbor_dist(size_t i, int j) const
+    {
+        return neighbor_distance[3 * i + j];
+    }
+
+    /// Length of edge j of face i (m)
+    double edge_length(size_t i, int j) const
+    {
+        return edge_len[3 * i + j];
+    }
+
+    // Vertices
+    std::vector<double> vx;
+    std::vector<double> vy;
+    std::vector<double> vz;
+
+    // [face][3]
+    std::vector<int> tri_vertex;
+    std::vector<int> tri_neighbor;
+    std::vector<double> edge_len;      // (m)
+    std::vector<double> edge_normal_x; // outward unit normal of the edge
+    std::vector<double> edge_normal_y;
+    std::vector<double> neighbor_distance; // centroid to centroid distance across the edge (m), 0 without a neighbor
+
+    // Per-face
+    std::vector<double> x; // centroid
+    std::vector<double> y;
+    std::vector<double> z;
+    std::vector<double> area;   // (m^2)
+    std::vector<double> slope;  // (rad)
+    std::vector<double> aspect; // (rad), North = 0, CW
+    std::vector<double> nx;     // unit normal
+    std::vector<double> ny;
+    std::vector<double> nz;
+    std::vector<size_t> global_id;
+    std::vector<int> owner;
+    std::vector<char> is_ghost;
+
+    // Per-face data, [name][face]. Kept across rebuilds, following each face to its new index
+    face_table variables;
+    face_table parameters;
+    face_table initial_conditions;
+
+  private:
+    friend class triangulation;
+
+    size_t _num_local = 0;
+};
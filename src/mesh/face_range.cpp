@@ -0,0 +1,147 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+
+#include "face_range.hpp"
+
+face_range::face_range(triangulation& domain)
+    : _domain(domain), _begin(0), _end(0), _ncolumns(0)
+{
+}
+
+void face_range::set(size_t begin, size_t end)
+{
+    _begin = begin;
+    _end = end;
+    _ncolumns = 0;
+}
+
+void face_range::commit()
+{
+    size_t n = size();
+    for (size_t c = 0; c < _ncolumns; ++c)
+    {
+        auto& col = _columns[c];
+        if (!col.write)
+            continue;
+
+        double* const* ptr = col.pointers->data() + _begin;
+        for (size_t k = 0; k < n; ++k)
+        {
+            if (ptr[k])
+                *ptr[k] = col.values[k];
+        }
+        col.write = false;
+    }
+}
+
+mesh_elem face_range::face(size_t k)
+{
+    return _domain.face(_begin + k);
+}
+
+const double* face_range::in(const uint64_t& variable)
+{
+    return get(variable, false, true, false);
+}
+
+double* face_range::out(const uint64_t& variable)
+{
+    return get(variable, false, false, true);
+}
+
+double* face_range::inout(const uint64_t& variable)
+{
+    return get(variable, false, true, true);
+}
+
+bool face_range::has_parameter(const uint64_t& parameter) const
+{
+    return _domain.parameter_column(parameter) != nullptr;
+}
+
+const double* face_range::parameter(const uint64_t& parameter)
+{
+    return get(parameter, true, true, false);
+}
+
+double* face_range::parameter_out(const uint64_t& parameter)
+{
+    return get(parameter, true, false, true);
+}
+
+const double* face_range::z()
+{
+    return _domain.compact().z.data() + _begin;
+}
+
+double* face_range::get(const uint64_t& hash, bool is_parameter, bool gather, bool write)
+{
+    size_t n = size();
+
+    for (size_t c = 0; c < _ncolumns; ++c)
+    {
+        auto& col = _columns[c];
+        if (col.hash == hash && col.is_parameter == is_parameter)
+        {
+            // e.g., out() then in(). The array still holds the previous block's values, so gather it now
+            if (gather && !col.gathered)
+                gather_column(col);
+
+            col.write = col.write || write;
+            return col.values.data();
+        }
+    }
+
+    auto pointers = is_parameter ? _domain.parameter_column(hash) : _domain.variable_column(hash);
+    if (!pointers)
+    {
+        CHM_THROW_EXCEPTION(module_error, std::string(is_parameter ? "Parameter " : "Variable ") + std::to_string(hash) +
+                                              " has no face column and is not available to block kernels.");
+    }
+
+    if (_ncolumns == _columns.size())
+        _columns.emplace_back();
+
+    auto& col = _columns[_ncolumns++];
+    col.hash = hash;
+    col.is_parameter = is_parameter;
+    col.write = write;
+    col.pointers = pointers;
+    col.gathered = false;
+    col.values.resize(n);
+
+    if (gather)
+        gather_column(col);
+
+    return col.values.data();
+}
+
+void face_range::gather_column(column& col)
+{
+    size_t n = size();
+    double* const* ptr = col.pointers->data() + _begin;
+    for (size_t k = 0; k < n; ++k)
+        col.values[k] = ptr[k] ? *ptr[k] : -9999.;
+    col.gathered = true;
+}
@@ -0,0 +1,130 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+
+#pragma once
+
+#include "triangulation.hpp"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * A contiguous block [begin, end) of local face indices that a block kernel, module_base::run(face_range&), works on.
+ *
+ * Variables and parameters are handed to the kernel as contiguous per-block arrays, index k being face begin+k, so
+ * that the kernel body is a plain loop the compiler can vectorize. Inputs are gathered from the faces when first
+ * requested. Outputs are scattered back to the faces by commit(), which core calls after the kernel returns.
+ * Gathering and scattering go through the pointer tables from triangulation::init_face_columns, so each variable is
+ * resolved once per block and not once per face.
+ *
+ * A face_range is not thread safe; core keeps one per thread and reuses it, along with its buffers, for every block.
+ */
+class face_range
+{
+  public:
+    face_range(triangulation& domain);
+
+    /**
+     * Starts a new block. Any outputs of the previous block must already have been committed.
+     */
+    void set(size_t begin, size_t end);
+
+    /**
+     * Writes the output arrays back to the faces
+     */
+    void commit();
+
+    size_t begin() const { return _begin; }
+    size_t end() const { return _end; }
+    size_t size() const { return _end - _begin; }
+
+    /**
+     * The k-th face of the block, for anything that is not available as an array
+     */
+    mesh_elem face(size_t k);
+
+    /**
+     * Values of a variable for the faces of this block. Use _s for compile-time hash.
+     * Throws if the variable has no face column.
+     */
+    const double* in(const uint64_t& variable);
+
+    /**
+     * Array for a variable that is written back to the faces on commit. The values are not gathered, so the kernel
+     * must set every entry. Use inout() to update a variable in place. A later in() or inout() of the same variable
+     * returns the same array, gathered from the faces at that point, so ask for it before writing to the array.
+     */
+    double* out(const uint64_t& variable);
+
+    /**
+     * As out(), but the array starts with the faces' current values
+     */
+    double* inout(const uint64_t& variable);
+
+    /**
+     * True if init_face_columns built a column for this parameter
+     */
+    bool has_parameter(const uint64_t& parameter) const;
+
+    /**
+     * Values of a parameter for the faces of this block. Faces without the parameter read as -9999.
+     * Throws if the parameter has no face column.
+     */
+    const double* parameter(const uint64_t& parameter);
+
+    /**
+     * Array for a parameter that is written back to the faces on commit. The kernel must set every entry.
+     */
+    double* parameter_out(const uint64_t& parameter);
+
+    /**
+     * Face elevations (m) for this block
+     */
+    const double* z();
+
+  private:
+    struct column
+    {
+        uint64_t hash;
+        bool is_parameter;
+        bool write;
+        bool gathered; // values hold this block's face values, not a previous block's
+        const std::vector<double*>* pointers;
+        std::vector<double> values;
+    };
+
+    // Returns the array for the variable, gathering it if it is new to this block and gather is true
+    double* get(const uint64_t& hash, bool is_parameter, bool gather, bool write);
+
+    // Reads the column's values for this block from the faces
+    void gather_column(column& col);
+
+    triangulation& _domain;
+    size_t _begin;
+    size_t _end;
+
+    // The first _ncolumns are in use by this block. The rest keep their allocations for later blocks
+    std::vector<column> _columns;
+    size_t _ncolumns;
+};
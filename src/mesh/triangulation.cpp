@@ -27,6 +27,9 @@ triangulation::triangulation()
     _terrain_deformed=false;
     _min_z =  999999;
     _max_z = -999999;
+    _distributed_load = false;
+    _max_ghost_distance = 100.0;
+    _vtu_size = 0;
 
 #ifdef USE_SPARSEHASH
     data.set_empty_key("");
@@ -90,6 +93,16 @@ void triangulation::write_ghost_neighbors_to_vtu(bool write_ghost_neighbors)
     _write_ghost_neighbors_to_vtu = write_ghost_neighbors;
 }
 
+void triangulation::distributed_load(bool distributed)
+{
+    _distributed_load = distributed;
+}
+
+void triangulation::max_ghost_distance(double distance)
+{
+    _max_ghost_distance = distance;
+}
+
 std::set<std::string> triangulation::parameters()
 {
     return _parameters;
@@ -354,85 +367,47 @@ void triangulation::from_json(pt::ptree &mesh)
 
         i++;
     }
-    //loop over parameter name
-
+    // The parameters and initial conditions are stored in the compact mesh, which is built once the faces are in
+    // their final order. Hold the values until then, in the order of the faces they are for
+    std::vector<mesh_elem> value_faces = _faces;
+    std::vector<std::pair<std::string, std::vector<double>>> parameter_values;
+    std::vector<std::pair<std::string, std::vector<double>>> ic_values;
 
     try
     {
-        // build up the entire list of parameters so we can use this to init the per-face parameter
-        // storage later
-
-        std::set<std::string> blacklist; // holds any parameters that have 0 length, eg "area": [],
         for (auto &itr : mesh.get_child("parameters"))
         {
             // we could have an item like this
             // "area": [],
             // and we need to ensure we *don't* load those
             std::string name = itr.first.data();
-            size_t i=0;
-            for (auto &jtr : itr.second)
-            {
-                //just count the first couple items, make sure it's non zero
-                if(i > 1)
-                    break;
-                ++i;
-            }
-
-            if(i == 0)
+            if(itr.second.empty())
             {
-                blacklist.insert(name);
                 SPDLOG_WARN("Parameter " + name + " is zero length and will be ignored.");
-            } else {
-                _parameters.insert(name);
+                continue;
             }
 
-        }
-
-        // init the storage
-#pragma omp parallel for
-        for (size_t i = 0; i < size_faces(); i++)
-        {
-             _faces.at(i)->init_parameters(_parameters);
-        }
-
-
-        for (auto &itr : mesh.get_child("parameters"))
-        {
-            i = 0; // reset evertime we get a new parameter set
-            auto name = itr.first.data();
-
-            if(blacklist.find(name) != blacklist.end())
-                continue; // skip blacklisted ones, as we don't want to use these
+            _parameters.insert(name);
 
             SPDLOG_DEBUG("Applying parameter: {}",name);
 
+            std::vector<double> values;
+            values.reserve(value_faces.size());
             for (auto &jtr : itr.second)
             {
-                try
-                {
-                    auto face = _faces.at(i);
-                    auto value = jtr.second.get_value<double>();
-                    face->parameter(name) = value;
-                    i++;
-                }catch(std::out_of_range& e)
-                {
-                    SPDLOG_ERROR("Something is wrong with the parameter file. There are more parameter elements than triangulation elements" );
-                    CHM_THROW_EXCEPTION(mesh_error, "Something is wrong with the parameter file. There are more parameter elements than triangulation elements");
-                }
+                values.push_back(jtr.second.get_value<double>());
+            }
 
+            if(values.size() > value_faces.size())
+            {
+                SPDLOG_ERROR("Something is wrong with the parameter file. There are more parameter elements than triangulation elements" );
+                CHM_THROW_EXCEPTION(mesh_error, "Something is wrong with the parameter file. There are more parameter elements than triangulation elements");
             }
+            parameter_values.emplace_back(name, std::move(values));
         }
     }catch(pt::ptree_bad_path& e)
     {
         // we don't have this section, no worries
-        // but we still need to build up the face storage as we may have parameters from a module
-        // init the storage, which builds the mphf
-#pragma omp parallel for
-        for (size_t i = 0; i < size_faces(); i++)
-        {
-             _faces.at(i)->init_parameters(_parameters);
-        }
-
     }
 
     std::set<std::string> ics;
@@ -440,18 +415,22 @@ void triangulation::from_json(pt::ptree &mesh)
     {
         for (auto &itr : mesh.get_child("initial_conditions"))
         {
-            i=0; // reset evertime we get a new parameter set
             auto name = itr.first.data();
             SPDLOG_DEBUG("Applying IC: {}",name);
+
+            std::vector<double> values;
             for (auto &jtr : itr.second)
             {
-                auto face = _faces.at(i);
-                double value = jtr.second.get_value<double>();
-                face->set_initial_condition(name,value);
-                i++;
+                values.push_back(jtr.second.get_value<double>());
+            }
+
+            if(values.size() > value_faces.size())
+            {
+                CHM_THROW_EXCEPTION(mesh_error, "There are more initial condition elements than triangulation elements");
             }
 
             ics.insert(name);
+            ic_values.emplace_back(name, std::move(values));
         }
     }catch(pt::ptree_bad_path& e)
     {
@@ -495,19 +474,26 @@ void triangulation::from_json(pt::ptree &mesh)
 
     _build_dDtree();
 
+    build_compact_mesh();
 
+    // even without the section, as modules may add parameters
+    _compact.parameters.init(_parameters, _compact.size());
+    _compact.initial_conditions.init(ics, _compact.size());
+
+    for (auto& itr : parameter_values)
+    {
+        auto& values = itr.second;
 #pragma omp parallel for
-    for (size_t i = 0; i < _faces.size(); i++)
+        for (size_t i = 0; i < values.size(); i++)
+            value_faces[i]->parameter(itr.first) = values[i];
+    }
+    for (auto& itr : ic_values)
     {
-        auto f = _faces.at(i); // ensure we access like this as json mode is generally non MPI unless we are partitioning
-        //init these
-        f->slope();
-        f->aspect();
-        f->center();
-        f->normal();
+        auto& values = itr.second;
+#pragma omp parallel for
+        for (size_t i = 0; i < values.size(); i++)
+            value_faces[i]->set_initial_condition(itr.first, values[i]);
     }
-
-
 }
 
 void triangulation::to_hdf5(std::string filename_base)
@@ -721,16 +707,9 @@ group_info(hid_t loc_id, const char *name, const H5L_info_t *linfo, void *opdata
     return 0;
 }
 
-void triangulation::load_mesh_from_h5(const std::string& mesh_filename)
+void triangulation::read_mesh_h5_attributes(H5File& file)
 {
-    // Turn off the auto-printing when failure occurs so that we can
-    // handle the errors appropriately
-    Exception::dontPrint();
-
-    // Open an existing file and dataset.
-    H5File file(mesh_filename, H5F_ACC_RDONLY);
-
-// check the mesh version first
+    // check the mesh version first
     {
         std::string v;
         try
@@ -748,10 +727,6 @@ void triangulation::load_mesh_from_h5(const std::string& mesh_filename)
 
     }
 
-    std::vector<std::array<double, 3>> vertex;
-    std::vector<std::array<int, 3>> elem;
-    std::vector<std::array<int, 3>> neigh;
-
     {
         // Read the proj4
         H5::DataSpace dataspace(1, &proj4_dims);
@@ -828,62 +803,123 @@ void triangulation::load_mesh_from_h5(const std::string& mesh_filename)
     {
         CHM_THROW_EXCEPTION(mesh_error, "CHM requires partitioned meshes built using the metis method");
     }
+}
 
+/**
+ * All the values of a 1D dataset, from read_h5_all
+ */
+template<typename T>
+struct h5_values
+{
+    const T* data = nullptr;
+    size_t size = 0;
+
+    std::vector<T> local;
+#ifdef USE_MPI
+    // if set, the node's first rank reads the dataset into shared memory for every rank on the node
+    const boost::mpi::communicator* node = nullptr;
+    node_shared::array<T> shared;
+#endif
+};
+
+/**
+ * Reads all of a 1D dataset into values
+ */
+template<typename T>
+static void read_h5_all(H5::H5File& file, const std::string& name, const H5::DataType& type, h5_values<T>& values)
+{
+    auto read = [&](T* buf) { file.openDataSet(name).read(buf, type); };
+
+#ifdef USE_MPI
+    if (values.node)
+    {
+        hsize_t n = 0;
+        if (values.node->rank() == 0)
+            file.openDataSet(name).getSpace().getSimpleExtentDims(&n, NULL);
+
+        values.shared.allocate(*values.node, n, read);
+        values.data = values.shared.data();
+        values.size = values.shared.size();
+        return;
+    }
+#endif
+
+    hsize_t n = 0;
+    file.openDataSet(name).getSpace().getSimpleExtentDims(&n, NULL);
+    values.local.resize(n);
+    read(values.local.data());
+    values.data = values.local.data();
+    values.size = n;
+}
+
+void triangulation::load_mesh_from_h5(const std::string& mesh_filename)
+{
+    // Turn off the auto-printing when failure occurs so that we can
+    // handle the errors appropriately
+    Exception::dontPrint();
+
+    // Open an existing file and dataset.
+    H5File file(mesh_filename, H5F_ACC_RDONLY);
+
+    // version, projection, partition info
+    read_mesh_h5_attributes(file);
+
+#ifdef USE_MPI
+    // Every rank reads the whole mesh to partition it. Ranks on the same node share one copy of the datasets, read
+    // by the node's first rank. Declared first so that it outlives the shared windows below
+    auto node = node_shared::communicator(_comm_world);
+#endif
+
+    h5_values<std::array<double, 3>> vertex;
+    h5_values<std::array<int, 3>> elem;
+    h5_values<std::array<int, 3>> neigh;
+    h5_values<int> global_id;
+    h5_values<int> owner; //what MPIrank owns each triangle,
+
+#ifdef USE_MPI
+    if (node.size() > 1)
     {
-        H5::DataSet dataset = file.openDataSet("/mesh/cell_global_id");
-        H5::DataSpace dataspace = dataset.getSpace();
-        hsize_t nelem;
-        int ndims = dataspace.getSimpleExtentDims(&nelem, NULL);
-        _global_IDs.resize(nelem);
-        dataset.read(_global_IDs.data(), PredType::NATIVE_INT);
+        vertex.node = elem.node = neigh.node = global_id.node = owner.node = &node;
     }
+#endif
+
+    // read straight from the (possibly shared) buffer, _global_IDs is only set once the local faces are known
+    read_h5_all(file, "/mesh/cell_global_id", PredType::NATIVE_INT, global_id);
 
-    std::vector<int> owner; //what MPIrank owns each triangle,
     {
         // if we have a h5 that isn't partitioned (ie mesh <v3.0.0) then we are entirely owned by rank 0
         if(_version.to_string() == "1.0.0" ||
             _version.to_string() == "1.2.0" ||
             _version.to_string() == "2.0.0")
         {
-            owner.resize(_global_IDs.size(), 0);
+            owner.local.resize(global_id.size, 0);
+            owner.data = owner.local.data();
+            owner.size = owner.local.size();
         }
         else
         {
-            H5::DataSet dataset = file.openDataSet("/mesh/owner");
-            H5::DataSpace dataspace = dataset.getSpace();
-            hsize_t nelem;
-            int ndims = dataspace.getSimpleExtentDims(&nelem, NULL);
-            owner.resize(nelem);
-            dataset.read(owner.data(), PredType::NATIVE_INT);
+            read_h5_all(file, "/mesh/owner", PredType::NATIVE_INT, owner);
         }
 
     }
 
     {
-        // Open the vertices dataset
-        DataSet dataset = file.openDataSet("/mesh/vertex");
-        DataSpace dataspace = dataset.getSpace();
-
-        hsize_t nvert;
-        int ndims = dataspace.getSimpleExtentDims(&nvert, NULL);
-
-        // Ensure enough space in the vector
-        vertex.resize(nvert);
-        // Default args read all of the dataspace
-        dataset.read(vertex.data(), vertex_t);
+        read_h5_all(file, "/mesh/vertex", vertex_t, vertex);
+        size_t nvert = vertex.size;
 
         for (size_t i = 0; i < nvert; i++)
         {
 
-            Point_3 pt(vertex[i][0], vertex[i][1], vertex[i][2]); // x y z
-            _max_z = std::max(_max_z, vertex[i][2]);
-            _min_z = std::min(_min_z, vertex[i][2]);
+            auto& v = vertex.data[i];
+            Point_3 pt(v[0], v[1], v[2]); // x y z
+            _max_z = std::max(_max_z, v[2]);
+            _min_z = std::min(_min_z, v[2]);
 
-            _bounding_box.x_max = std::max(_bounding_box.x_max, vertex[i][0]);
-            _bounding_box.x_min = std::min(_bounding_box.x_min, vertex[i][0]);
+            _bounding_box.x_max = std::max(_bounding_box.x_max, v[0]);
+            _bounding_box.x_min = std::min(_bounding_box.x_min, v[0]);
 
-            _bounding_box.y_max = std::max(_bounding_box.y_max, vertex[i][1]);
-            _bounding_box.y_min = std::min(_bounding_box.y_min, vertex[i][1]);
+            _bounding_box.y_max = std::max(_bounding_box.y_max, v[1]);
+            _bounding_box.y_min = std::min(_bounding_box.y_min, v[1]);
 
             Vertex_handle Vh = this->create_vertex();
             Vh->set_point(pt);
@@ -902,28 +938,26 @@ void triangulation::load_mesh_from_h5(const std::string& mesh_filename)
     }
 
     {
-        DataSet dataset = file.openDataSet("/mesh/elem");
-        DataSpace dataspace = dataset.getSpace();
-
-        hsize_t nelem;
-        int ndims = dataspace.getSimpleExtentDims(&nelem, NULL);
+        read_h5_all(file, "/mesh/elem", elem_t, elem);
+        size_t nelem = elem.size;
 
-        // Ensure enough space in the vector
-        elem.resize(nelem);
-        // Default args read all of the dataspace
-        dataset.read(elem.data(), elem_t);
+        if (owner.size != nelem)
+        {
+            CHM_THROW_EXCEPTION(config_error,
+                "Expected: " + std::to_string(nelem) + " owners, got: " + std::to_string(owner.size));
+        }
 
         for (size_t i = 0; i < nelem; i++)
         {
 
-            auto vert1 = _vertexes.at(elem[i][0]); // 0 indexing
-            auto vert2 = _vertexes.at(elem[i][1]);
-            auto vert3 = _vertexes.at(elem[i][2]);
+            auto vert1 = _vertexes.at(elem.data[i][0]); // 0 indexing
+            auto vert2 = _vertexes.at(elem.data[i][1]);
+            auto vert3 = _vertexes.at(elem.data[i][2]);
 
             auto face = this->create_face(vert1, vert2, vert3);
             // get the global ID from file, so-as to support either pre partitioned or non partitioned meshes
-            face->cell_global_id = _global_IDs.at(i);
-            face->owner = owner.at(i);
+            face->cell_global_id = global_id.data[i];
+            face->owner = owner.data[i];
 
             // this local id will include local ids for ghosts. However, that will need to be reset once partition
             // splits out the ghosts
@@ -932,7 +966,7 @@ void triangulation::load_mesh_from_h5(const std::string& mesh_filename)
             // if we load from a partition, we need a way of linking the non contiguous global ids with the local ids
             if(_mesh_is_from_partition)
             {
-                _global_to_locally_owned_index_map[_global_IDs.at(i)] = i;
+                _global_to_locally_owned_index_map[global_id.data[i]] = i;
             }
 
             if (_is_geographic)
@@ -959,23 +993,15 @@ void triangulation::load_mesh_from_h5(const std::string& mesh_filename)
 
     {
 
-        DataSet dataset = file.openDataSet("/mesh/neighbor");
-        DataSpace dataspace = dataset.getSpace();
-
-        hsize_t nelem;
-        int ndims = dataspace.getSimpleExtentDims(&nelem, NULL);
+        read_h5_all(file, "/mesh/neighbor", neighbor_t, neigh);
+        size_t nelem = neigh.size;
 
-        if( elem.size() != nelem)
+        if( elem.size != nelem)
         {
             CHM_THROW_EXCEPTION(config_error,
-                "Expected: " + std::to_string(elem.size()) + " neighborlists, got: " + std::to_string(nelem));
+                "Expected: " + std::to_string(elem.size) + " neighborlists, got: " + std::to_string(nelem));
         }
 
-        // Ensure enough space in the vector
-        neigh.resize(nelem);
-        // Default args read all of the dataspace
-        dataset.read(neigh.data(), neighbor_t);
-
         SPDLOG_DEBUG("Building face neighbors");
 
         for (size_t i=0;i<nelem;i++)
@@ -983,11 +1009,11 @@ void triangulation::load_mesh_from_h5(const std::string& mesh_filename)
 
             auto face = _faces.at(i);
 
-            // LOG_DEBUG << neigh[i][0] << " " << neigh[i][1] << " " << neigh[i][2];
+            // LOG_DEBUG << neigh.data[i][0] << " " << neigh.data[i][1] << " " << neigh.data[i][2];
 
-            int neigh_i_0_idx = neigh[i][0];
-            int neigh_i_1_idx = neigh[i][1];
-            int neigh_i_2_idx = neigh[i][2];
+            int neigh_i_0_idx = neigh.data[i][0];
+            int neigh_i_1_idx = neigh.data[i][1];
+            int neigh_i_2_idx = neigh.data[i][2];
 
 //            // if we are loading from a partition, convert these to local ids
             if(_mesh_is_from_partition)
@@ -1007,9 +1033,9 @@ void triangulation::load_mesh_from_h5(const std::string& mesh_filename)
             }
 
             //-1 is now the no neighbor value
-            Face_handle face0 =  neigh.at(i)[0] != -1 ?_faces.at( neigh_i_0_idx) : nullptr;
-            Face_handle face1 =  neigh.at(i)[1] != -1 ?_faces.at( neigh_i_1_idx) : nullptr;
-            Face_handle face2 =  neigh.at(i)[2] != -1 ?_faces.at( neigh_i_2_idx) : nullptr;
+            Face_handle face0 =  neigh.data[i][0] != -1 ?_faces.at( neigh_i_0_idx) : nullptr;
+            Face_handle face1 =  neigh.data[i][1] != -1 ?_faces.at( neigh_i_1_idx) : nullptr;
+            Face_handle face2 =  neigh.data[i][2] != -1 ?_faces.at( neigh_i_2_idx) : nullptr;
 
             if( face0 != nullptr && face0->cell_global_id == face->cell_global_id)
             {
@@ -1034,6 +1060,401 @@ void triangulation::load_mesh_from_h5(const std::string& mesh_filename)
         }
     }
 }
+/**
+ * Reads the rows ids (sorted, unique) of a 1D dataset into buf. Contiguous runs are read with a single hyperslab,
+ * scattered rows use a point selection so that only the requested rows are pulled from disk.
+ */
+static void read_h5_rows(H5::DataSet& dataset, const H5::DataType& type, const std::vector<hsize_t>& ids, void* buf)
+{
+    if(ids.empty())
+        return;
+
+    H5::DataSpace filespace = dataset.getSpace();
+    hsize_t count = ids.size();
+
+    if(ids.back() - ids.front() + 1 == count)
+    {
+        hsize_t offset = ids.front();
+        filespace.selectHyperslab(H5S_SELECT_SET, &count, &offset);
+    }
+    else
+    {
+        filespace.selectElements(H5S_SELECT_SET, count, ids.data());
+    }
+
+    H5::DataSpace memspace(1, &count);
+    dataset.read(buf, type, memspace, filespace);
+}
+
+void triangulation::distributed_ghost_region(int first, int last, double max_distance,
+                                             const std::function<void(const std::vector<int>&)>& fetch,
+                                             const std::function<std::array<int, 3>(int)>& neighbors,
+                                             const std::function<Point_3(int)>& center,
+                                             std::set<int>& ghost_neighbors,
+                                             std::set<int>& ghost_faces)
+{
+    auto is_owned = [&](int global_id) {
+        return global_id >= first && global_id <= last;
+    };
+
+    std::vector<int> owned_ids(last - first + 1);
+    std::iota(owned_ids.begin(), owned_ids.end(), first);
+    fetch(owned_ids);
+
+    // Same criteria as determine_local_boundary_faces: a neighbour owned by another rank, or no neighbour at all
+    std::vector<int> boundary_faces;
+    for (auto id : owned_ids)
+    {
+        bool is_boundary = false;
+        for (auto n : neighbors(id))
+        {
+            if (n == -1)
+            {
+                is_boundary = true;
+            }
+            else if (!is_owned(n))
+            {
+                ghost_neighbors.insert(n);
+                is_boundary = true;
+            }
+        }
+        if (is_boundary)
+            boundary_faces.push_back(id);
+    }
+
+    // Same criteria as determine_process_ghost_faces_by_distance: every face reachable from a boundary face through
+    // faces whose centre is within max_distance of that boundary face's centre. Each boundary face keeps its own
+    // search, but the searches advance together so that a level is fetched for all of them at once.
+    struct search
+    {
+        Point_3 center;
+        std::unordered_set<int> tested;
+        std::vector<int> frontier;
+        std::vector<int> candidates;
+    };
+
+    std::vector<search> searches;
+    searches.reserve(boundary_faces.size());
+    for (auto b : boundary_faces)
+    {
+        searches.push_back({center(b), {b}, {b}, {}});
+    }
+
+    bool active = !searches.empty();
+    while (active)
+    {
+        std::vector<int> level;
+        for (auto& s : searches)
+        {
+            s.candidates.clear();
+            for (auto f : s.frontier)
+            {
+                for (auto n : neighbors(f))
+                {
+                    if (n != -1 && s.tested.insert(n).second)
+                        s.candidates.push_back(n);
+                }
+            }
+            level.insert(level.end(), s.candidates.begin(), s.candidates.end());
+        }
+        fetch(level);
+
+        active = false;
+        for (auto& s : searches)
+        {
+            s.frontier.clear();
+            for (auto c : s.candidates)
+            {
+                if (math::gis::distance(s.center, center(c)) > max_distance)
+                    continue;
+
+                s.frontier.push_back(c);
+                if (!is_owned(c))
+                    ghost_faces.insert(c);
+            }
+            active = active || !s.frontier.empty();
+        }
+    }
+}
+
+void triangulation::load_distributed_mesh_from_h5(const std::string& mesh_filename)
+{
+    // Unlike load_mesh_from_h5, each rank only reads the faces it owns under the equal-count split of partition_mesh(),
+    // plus the ghost region. The ghost region is grown level-by-level from the rank boundary and each level is fetched
+    // from the file with one selection. This keeps the per-rank memory proportional to the local problem size
+    // without requiring the partition tool to be run first.
+
+#ifdef USE_MPI
+    Exception::dontPrint();
+    H5File file(mesh_filename, H5F_ACC_RDONLY);
+
+    read_mesh_h5_attributes(file);
+
+    if(_mesh_is_from_partition)
+    {
+        CHM_THROW_EXCEPTION(mesh_error, "Distributed mesh loading requires a non-partitioned h5 mesh. Use the .partition file instead.");
+    }
+
+    int my_rank = _comm_world.rank();
+
+    DataSet elem_dataset = file.openDataSet("/mesh/elem");
+    DataSet neigh_dataset = file.openDataSet("/mesh/neighbor");
+    DataSet vertex_dataset = file.openDataSet("/mesh/vertex");
+    DataSet global_id_dataset = file.openDataSet("/mesh/cell_global_id");
+
+    hsize_t nelem;
+    elem_dataset.getSpace().getSimpleExtentDims(&nelem, NULL);
+    _num_global_faces = nelem;
+
+    {
+        hsize_t nneigh;
+        neigh_dataset.getSpace().getSimpleExtentDims(&nneigh, NULL);
+        if( nneigh != nelem)
+        {
+            CHM_THROW_EXCEPTION(config_error,
+                                "Expected: " + std::to_string(nelem) + " neighborlists, got: " + std::to_string(nneigh));
+        }
+    }
+
+    // Same split as partition_mesh() so that results are identical to the full load
+    _num_faces_in_partition.resize(_comm_world.size(), _num_global_faces / _comm_world.size());
+    for (unsigned int i = 0; i < _num_global_faces % _comm_world.size(); ++i)
+    {
+        _num_faces_in_partition[i]++;
+    }
+
+    size_t face_start_idx = 0;
+    for (int i = 0; i < my_rank; ++i)
+    {
+        face_start_idx += _num_faces_in_partition[i];
+    }
+    size_t num_local = _num_faces_in_partition[my_rank];
+
+    global_cell_start_idx = face_start_idx;
+    global_cell_end_idx = face_start_idx + num_local - 1;
+
+    std::vector<hsize_t> owned_ids(num_local);
+    std::iota(owned_ids.begin(), owned_ids.end(), face_start_idx);
+
+    // The runtime partition works on file order, so the global ids need to be the identity on our range.
+    // This holds for every mesh written by the conversion and permutation tools.
+    {
+        std::vector<int> gid(num_local);
+        read_h5_rows(global_id_dataset, PredType::NATIVE_INT, owned_ids, gid.data());
+        for (size_t i = 0; i < num_local; ++i)
+        {
+            if (gid[i] != static_cast<int>(face_start_idx + i))
+            {
+                CHM_THROW_EXCEPTION(mesh_error, "Distributed mesh loading requires cell_global_id to match the face order in the h5 file. "
+                                                "Disable distributed_load or pre-partition the mesh.");
+            }
+        }
+    }
+
+    // Topology and face centres for every face touched while building the ghost region
+    struct face_record
+    {
+        std::array<int, 3> elem;
+        std::array<int, 3> neigh;
+        Point_3 center;
+    };
+    std::unordered_map<int, face_record> records;
+    std::unordered_map<int, std::array<double, 3>> vertex_coords;
+
+    // Read the topology and vertices for any face ids not yet seen, in one selection per dataset
+    auto fetch = [&](const std::vector<int>& requested)
+    {
+        std::vector<hsize_t> ids;
+        for (auto id : requested)
+        {
+            if (records.find(id) == records.end())
+                ids.push_back(id);
+        }
+        std::sort(ids.begin(), ids.end());
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+        if(ids.empty())
+            return;
+
+        std::vector<std::array<int, 3>> elem(ids.size());
+        std::vector<std::array<int, 3>> neigh(ids.size());
+        read_h5_rows(elem_dataset, elem_t, ids, elem.data());
+        read_h5_rows(neigh_dataset, neighbor_t, ids, neigh.data());
+
+        std::vector<hsize_t> vids;
+        for (size_t i = 0; i < ids.size(); ++i)
+        {
+            for (auto n : neigh[i])
+            {
+                if (n != -1 && (n < 0 || n >= static_cast<int>(nelem)))
+                {
+                    CHM_THROW_EXCEPTION(config_error, "Face " + std::to_string(ids[i]) + " has out of bound neighbors.");
+                }
+            }
+
+            for (auto v : elem[i])
+            {
+                if (vertex_coords.find(v) == vertex_coords.end())
+                    vids.push_back(v);
+            }
+        }
+        std::sort(vids.begin(), vids.end());
+        vids.erase(std::unique(vids.begin(), vids.end()), vids.end());
+
+        std::vector<std::array<double, 3>> vertex(vids.size());
+        read_h5_rows(vertex_dataset, vertex_t, vids, vertex.data());
+        for (size_t i = 0; i < vids.size(); ++i)
+        {
+            vertex_coords[vids[i]] = vertex[i];
+        }
+
+        for (size_t i = 0; i < ids.size(); ++i)
+        {
+            auto& v0 = vertex_coords.at(elem[i][0]);
+            auto& v1 = vertex_coords.at(elem[i][1]);
+            auto& v2 = vertex_coords.at(elem[i][2]);
+
+            // matches face::center()
+            Point_3 center = CGAL::centroid(Point_3(v0[0], v0[1], v0[2]),
+                                            Point_3(v1[0], v1[1], v1[2]),
+                                            Point_3(v2[0], v2[1], v2[2]));
+
+            records[ids[i]] = {elem[i], neigh[i], center};
+        }
+    };
+
+    std::set<int> ghost_neighbors;
+    std::set<int> ghost_faces;
+    distributed_ghost_region(global_cell_start_idx, global_cell_end_idx, _max_ghost_distance,
+                             fetch,
+                             [&](int id) { return records.at(id).neigh; },
+                             [&](int id) { return records.at(id).center; },
+                             ghost_neighbors, ghost_faces);
+
+    SPDLOG_DEBUG("MPI Process {} read {} of {} faces from file for {} local faces, {} ghosts and {} ghost neighbors",
+                 my_rank, records.size(), _num_global_faces, num_local, ghost_faces.size(), ghost_neighbors.size());
+
+    // Build the triangulation for the owned faces and the ghosts only. Owned faces first then the ghosts, both
+    // sorted by global id, the same layout as a pre-partitioned mesh. As with the full load, a ghost neighbour further
+    // than _max_ghost_distance from every boundary face is a face of the triangulation but is not in _ghost_faces.
+    std::vector<int> face_ids(owned_ids.begin(), owned_ids.end());
+    {
+        std::set<int> ghosts(ghost_faces);
+        ghosts.insert(ghost_neighbors.begin(), ghost_neighbors.end());
+        face_ids.insert(face_ids.end(), ghosts.begin(), ghosts.end());
+    }
+
+    std::set<int> vertex_ids;
+    for (auto id : face_ids)
+    {
+        for (auto v : records.at(id).elem)
+            vertex_ids.insert(v);
+    }
+
+    std::unordered_map<int, Delaunay::Vertex_handle> vertex_handles;
+    for (auto vid : vertex_ids)
+    {
+        auto& v = vertex_coords.at(vid);
+        Point_3 pt(v[0], v[1], v[2]);
+
+        _max_z = std::max(_max_z, v[2]);
+        _min_z = std::min(_min_z, v[2]);
+
+        _bounding_box.x_max = std::max(_bounding_box.x_max, v[0]);
+        _bounding_box.x_min = std::min(_bounding_box.x_min, v[0]);
+
+        _bounding_box.y_max = std::max(_bounding_box.y_max, v[1]);
+        _bounding_box.y_min = std::min(_bounding_box.y_min, v[1]);
+
+        Vertex_handle Vh = this->create_vertex();
+        Vh->set_point(pt);
+        Vh->set_id(_vertexes.size());
+        _vertexes.push_back(Vh);
+        vertex_handles[vid] = Vh;
+    }
+    _num_vertex = _vertexes.size();
+
+    // release the search caches before the faces are created
+    vertex_coords.clear();
+
+    std::unordered_map<int, mesh_elem> global_to_face;
+    for (size_t i = 0; i < face_ids.size(); ++i)
+    {
+        int id = face_ids[i];
+        auto& rec = records.at(id);
+
+        auto vert1 = vertex_handles.at(rec.elem[0]);
+        auto vert2 = vertex_handles.at(rec.elem[1]);
+        auto vert3 = vertex_handles.at(rec.elem[2]);
+
+        auto face = this->create_face(vert1, vert2, vert3);
+        face->cell_global_id = id;
+        face->cell_local_id = i;
+
+        if (_is_geographic)
+        {
+            face->_is_geographic = true;
+        }
+
+        face->_debug_ID = -(i + 1);
+        face->_debug_name = std::to_string(i);
+        face->_domain = this;
+
+        vert1->set_face(face);
+        vert2->set_face(face);
+        vert3->set_face(face);
+
+        if (i < num_local)
+        {
+            face->is_ghost = false;
+            face->ghost_type = GHOST_TYPE::NONE;
+            face->owner = my_rank;
+
+            _local_faces.push_back(face);
+            _global_to_local_faces_index_map[id] = i;
+        }
+        else
+        {
+            bool is_neigh = ghost_neighbors.find(id) != ghost_neighbors.end();
+
+            face->is_ghost = true;
+            face->ghost_type = is_neigh ? GHOST_TYPE::NEIGH : GHOST_TYPE::DIST;
+            face->owner = determine_owner_of_global_index(id, _num_faces_in_partition);
+
+            if (ghost_faces.find(id) != ghost_faces.end())
+                _ghost_faces.push_back(face);
+            if (is_neigh)
+                _ghost_neighbors.push_back(face);
+        }
+
+        _global_to_locally_owned_index_map[id] = i;
+        global_to_face[id] = face;
+        _faces.push_back(face);
+    }
+
+    // Neighbours that were not loaded are beyond the ghost region, and only occur on the outer ghosts
+    for (size_t i = 0; i < face_ids.size(); ++i)
+    {
+        auto& rec = records.at(face_ids[i]);
+
+        Face_handle neighbors[3];
+        for (int j = 0; j < 3; ++j)
+        {
+            auto itr = rec.neigh[j] != -1 ? global_to_face.find(rec.neigh[j]) : global_to_face.end();
+            neighbors[j] = itr != global_to_face.end() ? itr->second : nullptr;
+        }
+
+        _faces[i]->set_neighbors(neighbors[0], neighbors[1], neighbors[2]);
+    }
+
+    _global_IDs.assign(face_ids.begin(), face_ids.begin() + num_local);
+    _num_faces = _local_faces.size();
+
+    SPDLOG_DEBUG("MPI Process {}: start {}, end {}, number {}",
+                 my_rank, global_cell_start_idx, global_cell_end_idx, _local_faces.size());
+#endif
+}
+
 void triangulation::_build_dDtree()
 {
     SPDLOG_DEBUG("Building dD tree");
@@ -1182,9 +1603,18 @@ void triangulation::from_hdf5(const std::string& mesh_filename,
                               bool delay_param_ic_load
 			      )
 {
+    // only a non-partitioned mesh can be read distributed, and only worthwhile with more than one rank
+    bool distributed = false;
+#ifdef USE_MPI
+    distributed = _distributed_load && _comm_world.size() > 1;
+#endif
+
     try
     {
-        load_mesh_from_h5(mesh_filename);
+        if(distributed)
+            load_distributed_mesh_from_h5(mesh_filename);
+        else
+            load_mesh_from_h5(mesh_filename);
     }
     // catch failure caused by the H5File operations
     catch (FileIException& e)
@@ -1197,12 +1627,20 @@ void triangulation::from_hdf5(const std::string& mesh_filename,
         e.printErrorStack();
     }
 
+#ifdef USE_MPI
+    // Only the file read buffers are shared, each rank still builds its own copy of the full mesh. So this is not
+    // the change in peak memory, which is dominated by the mesh
+    if (node_shared::saved_bytes() > 0)
+        SPDLOG_INFO("Mesh datasets were read once for this node instead of once per rank, {:.1f} MiB of read buffers not duplicated",
+                    node_shared::saved_bytes() / (1024.0 * 1024.0));
+#endif
+
     // if we are partitioned, just load it from file
     if(_mesh_is_from_partition)
     {
         load_partition_from_mesh(mesh_filename);
     }
-    else
+    else if(!distributed)
     {
         // otherwise, compute it
         partition_mesh();
@@ -1212,7 +1650,7 @@ void triangulation::from_hdf5(const std::string& mesh_filename,
         determine_process_ghost_faces_nearest_neighbors();
 
         // TODO: Need to auto-determine how far to look based on module setups
-        determine_process_ghost_faces_by_distance(100.0);
+        determine_process_ghost_faces_by_distance(_max_ghost_distance);
 #endif
     }
 
@@ -1225,6 +1663,7 @@ void triangulation::from_hdf5(const std::string& mesh_filename,
 #endif // USE_MPI
 
     _build_dDtree();
+    build_compact_mesh();
 
     // load param
     if(!delay_param_ic_load)
@@ -1259,38 +1698,22 @@ void triangulation::load_hdf5_parameters( const std::vector<std::string>& param_
                 // std::cout << "Here: " << name << "\n";
             }
 
-            if(_mesh_is_from_partition)
-            {
-// init the parameter storage on each face
-// as we are using a pre-partitioned mesh, _faces holds local+ghosts, so can do it in one go which is
-// faster
-#pragma omp parallel for
-                for (size_t i = 0; i < _faces.size(); i++)
-                {
-                    _faces.at(i)->init_parameters(_parameters);
-                }
-            }
-            else
-            {
-// if we are not reading from a partitioned file, we need to ensure we do the local faces + ghosts
-// separetely
-// init the parameter storage on each face
-#pragma omp parallel for
-                for (size_t i = 0; i < _num_faces; i++)
-                {
-                    face(i)->init_parameters(_parameters);
-                }
+            // the parameter storage of the local faces and ghosts, in the compact mesh. Parameters from earlier
+            // files keep their values
+            _compact.parameters.init(_parameters, _compact.size());
 
-// init the parameter storage for the ghost regions
-#pragma omp parallel for
-                for (size_t i = 0; i < _ghost_faces.size(); i++)
-                {
-                    _ghost_faces.at(i)->init_parameters(_parameters);
-                }
-            }
             // Data buffer for reading from file (before packing into faces)
             std::vector<double> data(_mesh_is_from_partition ? _faces.size() : _num_faces);
 
+            // file positions of the ghosts, in _ghost_faces order, for the non-partitioned read
+            std::vector<hsize_t> ghost_ids;
+            if(!_mesh_is_from_partition)
+            {
+                ghost_ids.resize(_ghost_faces.size());
+                std::transform(_ghost_faces.begin(), _ghost_faces.end(), ghost_ids.begin(),
+                               [](mesh_elem e) { return static_cast<hsize_t>(e->cell_global_id); });
+            }
+
             // Read all of the parameters from file and store them in the faces
             for (auto const& name : pars->names)
             {
@@ -1327,7 +1750,8 @@ void triangulation::load_hdf5_parameters( const std::vector<std::string>& param_
 #pragma omp parallel for
                     for (size_t i = 0; i < _faces.size(); i++)
                     {
-                        _faces.at(i)->parameter(name) = data.at(i);
+                        if (_faces.at(i)->_compact_index >= 0)
+                            _faces.at(i)->parameter(name) = data.at(i);
                     }
                 }
                 else
@@ -1342,23 +1766,21 @@ void triangulation::load_hdf5_parameters( const std::vector<std::string>& param_
                     SPDLOG_DEBUG(" Applying {} for ghost regions {} elements):",
                                   name,  _ghost_faces.size(), name);
 
-                    // Read parameters for each ghost face individually
-                    hsize_t one = 1;
-                    // Do NOT do this loop in parallel (internal state of HDF5)
-                    for (size_t i = 0; i < _ghost_faces.size(); i++)
+                    if(!_ghost_faces.empty())
                     {
-                        auto face = _ghost_faces.at(i);
-                        // when we are reading from a paritioned file, the ghosts will be below the non ghosts
-                        hsize_t global_id = _mesh_is_from_partition ? _local_faces.size() + i : face->cell_global_id;
-
-                        // Position and size in file
-                        dataspace.selectHyperslab(H5S_SELECT_SET, &one, &global_id);
-                        // Position and size in variable
-                        memspace.selectHyperslab(H5S_SELECT_SET, &one, &zero);
-
-                        double value;
-                        dataset.read(&value, PredType::NATIVE_DOUBLE, memspace, dataspace);
-                        face->parameter(name) = value;
+                        // Read the scattered ghost values in one go with a point selection
+                        hsize_t nghost = ghost_ids.size();
+                        dataspace.selectElements(H5S_SELECT_SET, nghost, ghost_ids.data());
+                        DataSpace ghost_memspace(1, &nghost);
+
+                        std::vector<double> ghost_data(nghost);
+                        dataset.read(ghost_data.data(), PredType::NATIVE_DOUBLE, ghost_memspace, dataspace);
+
+#pragma omp parallel for
+                        for (size_t i = 0; i < _ghost_faces.size(); i++)
+                        {
+                            _ghost_faces.at(i)->parameter(name) = ghost_data[i];
+                        }
                     }
                 }
             }
@@ -1379,6 +1801,8 @@ void triangulation::load_hdf5_parameters( const std::vector<std::string>& param_
 
     } // end of param_filenames loop
 
+    // geographic meshes provide the face areas as a parameter
+    update_compact_area();
 }
 
 void triangulation::reorder_faces(std::vector<size_t> permutation)
@@ -1605,14 +2029,17 @@ void triangulation::partition_mesh()
     for (size_t local_ind = 0; local_ind < _local_faces.size(); ++local_ind)
     {
         size_t offset_idx = global_cell_start_idx + local_ind;
-        _global_to_locally_owned_index_map[_global_IDs.at(offset_idx)] = local_ind;
 
-        _faces.at(_global_IDs.at(offset_idx))->is_ghost = false;
-        _faces.at(_global_IDs.at(offset_idx))->owner = my_rank;
+        // load_mesh_from_h5 set each face's cell_global_id from the file in file order
+        int global_id = _faces.at(offset_idx)->cell_global_id;
+        _global_to_locally_owned_index_map[global_id] = local_ind;
+
+        _faces.at(global_id)->is_ghost = false;
+        _faces.at(global_id)->owner = my_rank;
 
         //this was set in from_h5 but needs to be reset to not include any of the ghosts
-        _faces.at(_global_IDs.at(offset_idx))->cell_local_id = local_ind;
-        _local_faces.at(local_ind) = _faces.at(_global_IDs.at(offset_idx));
+        _faces.at(global_id)->cell_local_id = local_ind;
+        _local_faces.at(local_ind) = _faces.at(global_id);
     }
 
     // _global_IDs must contain (in the same order) cell_global_id for the faces
@@ -1965,6 +2392,26 @@ void triangulation::setup_nearest_neighbor_communication()
 
 }
 
+std::map<int, size_t> triangulation::ghost_send_sizes()
+{
+    std::map<int, size_t> sizes;
+#ifdef USE_MPI
+    for (auto& itr : local_faces_to_send)
+        sizes[itr.first] = itr.second.size();
+#endif
+    return sizes;
+}
+
+std::map<int, size_t> triangulation::ghost_recv_sizes()
+{
+    std::map<int, size_t> sizes;
+#ifdef USE_MPI
+    for (auto& itr : ghost_faces_to_recv)
+        sizes[itr.first] = itr.second.size();
+#endif
+    return sizes;
+}
+
 void triangulation::print_ghost_neighbor_info()
 {
   // Simple text file output, separate files for each MPI rank
@@ -2326,6 +2773,166 @@ mesh_elem triangulation::face(size_t i)
 #endif
 }
 
+void triangulation::build_compact_mesh()
+{
+    std::vector<mesh_elem> faces;
+    faces.reserve(size_faces() + _ghost_faces.size());
+    for (size_t i = 0; i < size_faces(); i++)
+        faces.push_back(face(i));
+    faces.insert(faces.end(), _ghost_faces.begin(), _ghost_faces.end());
+
+    size_t n = faces.size();
+
+    // the face data is indexed by the compact index, so it follows each face to its new index, e.g., after
+    // reorder_faces or prune_faces. Faces that are new get -9999
+    std::vector<int> old_index(n);
+    for (size_t i = 0; i < n; i++)
+        old_index[i] = faces[i]->_compact_index;
+
+    // faces read their geometry from the compact mesh, so have them compute it from the vertices while it is rebuilt.
+    // Includes faces that were in the last compact mesh but are not anymore, e.g., after prune_faces
+    for (auto f = this->faces_begin(); f != this->faces_end(); ++f)
+        f->_compact_index = -1;
+
+    auto variables = std::move(_compact.variables);
+    auto parameters = std::move(_compact.parameters);
+    auto initial_conditions = std::move(_compact.initial_conditions);
+
+    _compact = compact_mesh();
+    auto& c = _compact;
+    c._num_local = size_faces();
+
+    c.variables = std::move(variables);
+    c.parameters = std::move(parameters);
+    c.initial_conditions = std::move(initial_conditions);
+    c.variables.permute(old_index);
+    c.parameters.permute(old_index);
+    c.initial_conditions.permute(old_index);
+    _variable_columns.clear();
+    _parameter_columns.clear();
+
+    // handles are only used to look up indexes, key on the address of what they point to
+    std::unordered_map<const void*, int> face_index;
+    face_index.reserve(n);
+    for (size_t i = 0; i < n; i++)
+        face_index[&*faces[i]] = static_cast<int>(i);
+
+    std::unordered_map<const void*, int> vertex_index;
+    c.tri_vertex.resize(3 * n);
+    c.tri_neighbor.resize(3 * n);
+    for (size_t i = 0; i < n; i++)
+    {
+        auto f = faces[i];
+        for (int j = 0; j < 3; j++)
+        {
+            auto v = f->vertex(j);
+            auto vitr = vertex_index.find(&*v);
+            if (vitr == vertex_index.end())
+            {
+                vitr = vertex_index.emplace(&*v, static_cast<int>(c.vx.size())).first;
+                c.vx.push_back(v->point().x());
+                c.vy.push_back(v->point().y());
+                c.vz.push_back(v->point().z());
+            }
+            c.tri_vertex[3 * i + j] = vitr->second;
+
+            auto neigh = f->neighbor(j);
+            auto nitr = neigh != nullptr ? face_index.find(&*neigh) : face_index.end();
+            c.tri_neighbor[3 * i + j] = nitr != face_index.end() ? nitr->second : compact_mesh::no_neighbor;
+        }
+    }
+
+    c.edge_len.resize(3 * n);
+    c.edge_normal_x.resize(3 * n);
+    c.edge_normal_y.resize(3 * n);
+    c.neighbor_distance.resize(3 * n);
+    c.x.resize(n);
+    c.y.resize(n);
+    c.z.resize(n);
+    c.area.resize(n);
+    c.slope.resize(n);
+    c.aspect.resize(n);
+    c.nx.resize(n);
+    c.ny.resize(n);
+    c.nz.resize(n);
+    c.global_id.resize(n);
+    c.owner.resize(n);
+    c.is_ghost.resize(n);
+
+    // computed by the faces so that it is identical to what they returned before the compact mesh was built
+#pragma omp parallel for
+    for (size_t i = 0; i < n; i++)
+    {
+        auto f = faces[i];
+        for (int j = 0; j < 3; j++)
+        {
+            c.edge_len[3 * i + j] = f->edge_length(j);
+            auto m = f->edge_unit_normal(j);
+            c.edge_normal_x[3 * i + j] = m.x();
+            c.edge_normal_y[3 * i + j] = m.y();
+        }
+
+        c.x[i] = f->get_x();
+        c.y[i] = f->get_y();
+        c.z[i] = f->get_z();
+        c.area[i] = f->get_area();
+        c.slope[i] = f->slope();
+        c.aspect[i] = f->aspect();
+        auto normal = f->normal();
+        c.nx[i] = normal.x();
+        c.ny[i] = normal.y();
+        c.nz[i] = normal.z();
+        c.global_id[i] = f->cell_global_id;
+        c.owner[i] = f->owner;
+        c.is_ghost[i] = i >= c._num_local;
+    }
+
+    // separate pass as it needs the neighbors' centroids
+#pragma omp parallel for
+    for (size_t i = 0; i < n; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            int neigh = c.tri_neighbor[3 * i + j];
+            c.neighbor_distance[3 * i + j] =
+                neigh != compact_mesh::no_neighbor
+                    ? math::gis::distance(Point_3(c.x[i], c.y[i], c.z[i]), Point_3(c.x[neigh], c.y[neigh], c.z[neigh]))
+                    : 0;
+        }
+    }
+
+    for (size_t i = 0; i < n; i++)
+    {
+        faces[i]->_domain = this;
+        faces[i]->_compact_index = static_cast<int>(i);
+    }
+
+    SPDLOG_DEBUG("Compact mesh has {} faces ({} ghosts) and {} vertices", n, n - c._num_local, c.vx.size());
+}
+
+const compact_mesh& triangulation::compact() const
+{
+    return _compact;
+}
+
+compact_mesh& triangulation::compact()
+{
+    return _compact;
+}
+
+void triangulation::update_compact_area()
+{
+    size_t nlocal = _compact.size_faces();
+
+#pragma omp parallel for
+    for (size_t i = 0; i < _compact.size(); i++)
+    {
+        auto f = i < nlocal ? face(i) : _ghost_faces.at(i - nlocal);
+        if (f->has_parameter("area"_s))
+            _compact.area[i] = f->parameter("area"_s);
+    }
+}
+
 const std::vector<int>& triangulation::get_global_IDs() const
 {
   return _global_IDs;
@@ -2438,6 +3045,9 @@ void triangulation::init_vtkUnstructured_Grid(std::vector<std::string> output_va
     //assume that all the faces have the same number of variables and the same types of variables
     //by this point this should be a fair assumption
 
+    data.clear();
+    vectors.clear();
+
     auto variables = output_variables.size() == 0 ? this->face(0)->variables() : output_variables;
     for(auto& v: variables)
     {
@@ -2496,6 +3106,64 @@ void triangulation::init_vtkUnstructured_Grid(std::vector<std::string> output_va
         vectors[v]->SetNumberOfComponents(3);
     }
 
+    // Size every array up front and keep pointers to their storage so update_vtk_data can write to them directly
+    _vtu_size = this->size_faces() + (_write_ghost_neighbors_to_vtu ? _ghost_faces.size() : 0);
+    _vtu_output_variables = output_variables;
+
+    _vtu_global_id->SetNumberOfTuples(_vtu_size);
+    _vtu_global_id_values = _vtu_global_id->GetPointer(0);
+    _vtk_unstructuredGrid->GetCellData()->AddArray(_vtu_global_id);
+
+    for(auto& m : data)
+    {
+        m.second->SetNumberOfTuples(_vtu_size);
+        _vtk_unstructuredGrid->GetCellData()->AddArray(m.second);
+    }
+
+    _vtu_vectors.clear();
+    for(auto& m : vectors)
+    {
+        m.second->SetNumberOfTuples(_vtu_size);
+        _vtu_vectors.push_back({m.first, xxh64::hash(m.first.c_str(), m.first.length()), m.second->GetPointer(0)});
+        _vtk_unstructuredGrid->GetCellData()->AddArray(m.second);
+    }
+
+    for(auto& m : vertex_data)
+    {
+        _vtk_unstructuredGrid->GetPointData()->AddArray(m.second);
+    }
+
+    auto resolve = [&](const std::string& name, const std::string& source) -> output_buffer
+    {
+        return {name, xxh64::hash(source.c_str(), source.length()), data[name]->GetPointer(0)};
+    };
+
+    _vtu_variables.clear();
+    for(auto& v: variables)
+        _vtu_variables.push_back(resolve(v, v));
+
+    _vtu_parameters.clear();
+    _vtu_ics.clear();
+    _vtu_geometry = {};
+    if(_write_parameters_to_vtu)
+    {
+        for (auto &v: this->face(0)->parameters())
+            _vtu_parameters.push_back(resolve("[param] " + v, v));
+
+        for (auto &v: this->face(0)->initial_conditions())
+            _vtu_ics.push_back(resolve("[ic] " + v, v));
+
+        _vtu_geometry.elevation = data["Elevation"]->GetPointer(0);
+        _vtu_geometry.slope = data["Slope"]->GetPointer(0);
+        _vtu_geometry.aspect = data["Aspect"]->GetPointer(0);
+        _vtu_geometry.area = data["Area"]->GetPointer(0);
+        _vtu_geometry.is_ghost = data["is_ghost"]->GetPointer(0);
+        _vtu_geometry.ghost_type = data["ghost_type"]->GetPointer(0);
+#ifdef USE_MPI
+        _vtu_geometry.owner = data["owner"]->GetPointer(0);
+#endif
+    }
+
     // Global vertex ids -> only need to be set here, get written in the writer
 //    vertex_data["global_id"] = vtkSmartPointer<vtkFloatArray>::New();
 //    vertex_data["global_id"]->SetName("global_id");
@@ -2507,13 +3175,9 @@ void triangulation::init_vtkUnstructured_Grid(std::vector<std::string> output_va
 
 void triangulation::init_timeseries(std::set< std::string > variables)
 {
-    #pragma omp parallel for
-    for (size_t it = 0; it < size_faces(); it++)
-    {
-        auto face = this->face(it);
-        face->init_time_series(variables);
-    }
+    _variable_columns.clear();
 
+    _compact.variables.init(variables, _compact.size());
 }
 
 void triangulation::init_vectors(std::set<std::string>& variables)
@@ -2553,16 +3217,21 @@ void triangulation::prune_faces(std::vector<Face_handle>& faces)
 
     _num_faces = _num_global_faces = _faces.size(); //number of global faces
 
+    build_compact_mesh();
 }
 void triangulation::init_face_data(std::set< std::string >& timeseries,
                     std::set< std::string >& vectors,
                     std::set< std::string >& module_data)
 {
+    _variable_columns.clear();
+
+    // the variables of the local faces and ghosts
+    _compact.variables.init(timeseries, _compact.size());
+
     #pragma omp parallel for
         for (size_t it = 0; it < size_faces(); it++)
         {
             auto face = this->face(it);
-            face->init_time_series(timeseries);
             face->init_module_data(module_data);
             face->init_vectors(vectors);
         }
@@ -2575,175 +3244,210 @@ void triangulation::init_face_data(std::set< std::string >& timeseries,
         {
             auto face = _ghost_faces.at(it);
             face->init_module_data(module_data);
-            face->init_time_series(timeseries);
             face->init_vectors(vectors);
         }
 }
 
-void triangulation::update_vtk_data(std::vector<std::string> output_variables)
+void triangulation::init_face_columns(const std::set<std::string>& variables, const std::set<std::string>& parameters)
 {
-    //if we haven't inited yet, do so.
-    if(!_vtk_unstructuredGrid || _terrain_deformed)
-    {
-        this->init_vtkUnstructured_Grid(output_variables);
-    }
+    _variable_columns.clear();
+    _parameter_columns.clear();
 
-    auto variables = output_variables.size() == 0 ? this->face(0)->variables() : output_variables;
-    auto params = this->face(0)->parameters();
-    auto ics = this->face(0)->initial_conditions();
-    auto vecs = this->face(0)->vectors();
+    size_t nfaces = size_faces();
+    if (nfaces == 0)
+        return;
 
-    for (size_t i = 0; i < this->size_faces(); i++)
+    for (auto& v : variables)
     {
-        mesh_elem fit = this->face(i);
-
-        for (auto &v: variables)
+        uint64_t hash = xxh64::hash(v.c_str(), v.length());
+        if (!this->face(0)->has(hash))
         {
-            double d = (*fit)[v];
-            if(d == -9999.)
-            {
-                d = nan("");
-            }
+            SPDLOG_DEBUG("{} is not stored on the faces, no column built", v);
+            continue;
+        }
 
-            data[v]->InsertTuple1(i,d);
+        auto& column = _variable_columns[hash];
+        column.resize(nfaces);
+
+        #pragma omp parallel for
+        for (size_t i = 0; i < nfaces; i++)
+        {
+            auto face = this->face(i);
+            column[i] = &(*face)[hash];
         }
+    }
 
-        //this is mandatory now
-        _vtu_global_id->InsertTuple1(i, fit->cell_global_id);
+    for (auto& p : parameters)
+    {
+        uint64_t hash = xxh64::hash(p.c_str(), p.length());
+        auto& column = _parameter_columns[hash];
+        column.resize(nfaces);
 
-        if(_write_parameters_to_vtu)
+        #pragma omp parallel for
+        for (size_t i = 0; i < nfaces; i++)
         {
-            for (auto &v: params)
-            {
-                double d = fit->parameter(v);
-                if (d == -9999.)
-                {
-                    d = nan("");
-                }
-                data["[param] " + v]->InsertTuple1(i, d);
-            }
+            auto face = this->face(i);
+            column[i] = face->has_parameter(hash) ? &face->parameter(hash) : nullptr;
+        }
+    }
 
-            for (auto &v: ics)
-            {
-                double d = fit->get_initial_condition(v);
-                if (d == -9999.)
-                {
-                    d = nan("");
-                }
-                data["[ic] " + v]->InsertTuple1(i, d);
-            }
+    SPDLOG_DEBUG("Built {} variable and {} parameter face columns", _variable_columns.size(), _parameter_columns.size());
+}
 
-            data["Elevation"]->InsertTuple1(i,fit->get_z());
-            data["Slope"]->InsertTuple1(i,fit->slope());
-            data["Aspect"]->InsertTuple1(i,fit->aspect());
-            data["Area"]->InsertTuple1(i,fit->get_area());
-	    data["is_ghost"]->InsertTuple1(i,fit->is_ghost);
-            data["ghost_type"]->InsertTuple1(i,fit->ghost_type);
+const std::vector<double*>* triangulation::variable_column(const uint64_t& hash) const
+{
+    auto itr = _variable_columns.find(hash);
+    return itr == _variable_columns.end() ? nullptr : &itr->second;
+}
 
-#ifdef USE_MPI
-	    data["owner"]->InsertTuple1(i,_comm_world.rank());
-#endif
-        }
-        for(auto& v: vecs)
-        {
-            Vector_3 d = fit->face_vector(v);
+const std::vector<double*>* triangulation::parameter_column(const uint64_t& hash) const
+{
+    auto itr = _parameter_columns.find(hash);
+    return itr == _parameter_columns.end() ? nullptr : &itr->second;
+}
 
-            vectors[v]->InsertTuple3(i,d.x(),d.y(),d.z());
-        }
+void triangulation::update_snow_free(size_t block_size)
+{
+    size_t nfaces = size_faces();
+    size_t nblocks = (nfaces + block_size - 1) / block_size;
 
+    _snow_free_block_size = block_size;
+    _snow_free_blocks.assign(nblocks, 0);
 
+    if (nfaces == 0)
+        return;
+
+    bool has_depth = this->face(0)->has("snowdepthavg"_s);
+
+    #pragma omp parallel for
+    for (size_t b = 0; b < nblocks; b++)
+    {
+        bool all = true;
+        for (size_t i = b * block_size; i < std::min(nfaces, (b + 1) * block_size); i++)
+        {
+            auto face = this->face(i);
+            face->snow_free = (*face)["swe"_s] <= 0 && (!has_depth || (*face)["snowdepthavg"_s] <= 0);
+            all = all && face->snow_free;
+        }
+        _snow_free_blocks[b] = all;
     }
+}
 
-    if(_write_ghost_neighbors_to_vtu)
+bool triangulation::snow_free_block(size_t begin, size_t end) const
+{
+    if (_snow_free_block_size == 0 || begin % _snow_free_block_size != 0)
+        return false;
+
+    size_t b = begin / _snow_free_block_size;
+    if (b >= _snow_free_blocks.size() || end != std::min(_num_faces, begin + _snow_free_block_size))
+        return false;
+
+    return _snow_free_blocks[b];
+}
+
+void triangulation::update_vtk_data(std::vector<std::string> output_variables)
+{
+    //if we haven't inited yet, do so.
+    if(!_vtk_unstructuredGrid || _terrain_deformed || output_variables != _vtu_output_variables)
     {
+        this->init_vtkUnstructured_Grid(output_variables);
+    }
 
-    /* Ghost neighbors */
-    for (size_t i = 0; i < _ghost_faces.size(); i++)
+    size_t nlocal = this->size_faces();
+#ifdef USE_MPI
+    int rank = _comm_world.rank();
+#endif
+
+    auto nan_missing = [](double d) -> float
     {
-        mesh_elem fit = _ghost_faces[i];
+        return d == -9999. ? nan("") : d;
+    };
 
-	size_t insert_offset = i + this->size_faces();
+    // Each tile of faces is filled one array at a time, so every array is written contiguously while the tile's
+    // faces stay in cache. The ghost faces, if written, follow the local faces.
+    const size_t tile_size = 1024;
+    size_t ntiles = (_vtu_size + tile_size - 1) / tile_size;
 
+#pragma omp parallel
+    {
+        std::vector<mesh_elem> tile; // this thread's faces for the current tile
+        tile.reserve(tile_size);
 
-        for (auto &v: variables)
+#pragma omp for schedule(dynamic)
+        for (size_t t = 0; t < ntiles; t++)
         {
-            double d = -9999;
-            if(fit->ghost_type == GHOST_TYPE::NEIGH)
-                d = (*fit)[v];
+            size_t begin = t * tile_size;
+            size_t end = std::min(_vtu_size, begin + tile_size);
+
+            tile.clear();
+            for (size_t i = begin; i < end; i++)
+                tile.push_back(i < nlocal ? this->face(i) : _ghost_faces[i - nlocal]);
 
-            if(d == -9999.)
+            for (auto& f : _vtu_variables)
             {
-                d = nan("");
-            }
+                for (size_t i = begin; i < end; i++)
+                {
+                    auto& fit = tile[i - begin];
 
-            data[v]->InsertTuple1(insert_offset,d);
-        }
+                    // only the neighbour ghosts have their variables communicated
+                    double d = -9999.;
+                    if (i < nlocal || fit->ghost_type == GHOST_TYPE::NEIGH)
+                        d = (*fit)[f.hash];
 
-        _vtu_global_id->InsertTuple1(insert_offset,fit->cell_global_id);
+                    f.values[i] = nan_missing(d);
+                }
+            }
 
-        if(_write_parameters_to_vtu)
-        {
-            for (auto &v: params)
+            //this is mandatory now
+            for (size_t i = begin; i < end; i++)
+                _vtu_global_id_values[i] = tile[i - begin]->cell_global_id;
+
+            if (_write_parameters_to_vtu)
             {
-                double d = fit->parameter(v);
-                if (d == -9999.)
+                for (auto& f : _vtu_parameters)
+                    for (size_t i = begin; i < end; i++)
+                        f.values[i] = nan_missing(tile[i - begin]->parameter(f.hash));
+
+                for (auto& f : _vtu_ics)
+                    for (size_t i = begin; i < end; i++)
+                        f.values[i] = nan_missing(tile[i - begin]->get_initial_condition(f.hash));
+
+                for (size_t i = begin; i < end; i++)
                 {
-                    d = nan("");
+                    auto& fit = tile[i - begin];
+                    _vtu_geometry.elevation[i] = fit->get_z();
+                    _vtu_geometry.slope[i] = fit->slope();
+                    _vtu_geometry.aspect[i] = fit->aspect();
+                    _vtu_geometry.area[i] = fit->get_area();
+                    _vtu_geometry.is_ghost[i] = fit->is_ghost;
+                    _vtu_geometry.ghost_type[i] = fit->ghost_type;
+#ifdef USE_MPI
+                    _vtu_geometry.owner[i] = i < nlocal ? rank : fit->owner;
+#endif
                 }
-                data["[param] " + v]->InsertTuple1(insert_offset, d);
             }
 
-            for (auto &v: ics)
+            for (auto& f : _vtu_vectors)
             {
-                double d = fit->get_initial_condition(v);
-                if (d == -9999.)
+                for (size_t i = begin; i < end; i++)
                 {
-                    d = nan("");
+                    Vector_3 d = tile[i - begin]->face_vector(f.hash);
+                    f.values[3 * i] = d.x();
+                    f.values[3 * i + 1] = d.y();
+                    f.values[3 * i + 2] = d.z();
                 }
-                data["[ic] " + v]->InsertTuple1(insert_offset, d);
             }
-
-            data["Elevation"]->InsertTuple1(insert_offset,fit->get_z());
-            data["Slope"]->InsertTuple1(insert_offset,fit->slope());
-            data["Aspect"]->InsertTuple1(insert_offset,fit->aspect());
-            data["Area"]->InsertTuple1(insert_offset,fit->get_area());
-	    data["is_ghost"]->InsertTuple1(insert_offset,fit->is_ghost);
-            data["ghost_type"]->InsertTuple1(insert_offset,fit->ghost_type);
-
-	    data["owner"]->InsertTuple1(insert_offset,fit->owner);
         }
-        for(auto& v: vecs)
-        {
-            Vector_3 d = fit->face_vector(v);
-
-            vectors[v]->InsertTuple3(insert_offset,d.x(),d.y(),d.z());
-        }
-
-
-    }
-
-    } // if write ghosts
-
-    _vtk_unstructuredGrid->GetCellData()->AddArray(_vtu_global_id);
-
-    for(auto& m : vectors)
-    {
-        _vtk_unstructuredGrid->GetCellData()->AddArray(m.second);
-
     }
 
-
+    // the buffers were written behind vtk's back
+    _vtu_global_id->Modified();
     for(auto& m : data)
-    {
-        _vtk_unstructuredGrid->GetCellData()->AddArray(m.second);
-    }
-
-    for(auto& m : vertex_data)
-    {
-        _vtk_unstructuredGrid->GetPointData()->AddArray(m.second);
-    }
-
+        m.second->Modified();
+    for(auto& m : vectors)
+        m.second->Modified();
 }
+
 void triangulation::write_vtu(std::string file_name)
 {
     //this now needs to be called from outside these functions
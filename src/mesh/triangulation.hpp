@@ -59,6 +59,7 @@ inline int omp_get_max_threads() { return 1;}
 
 #include <iostream>
 #include <algorithm>
+#include <numeric>
 #include <fstream>
 #include <cmath>
 #include <vector>
@@ -67,6 +68,8 @@ inline int omp_get_max_threads() { return 1;}
 #include <stack>
 #include <fstream>
 #include <utility>
+#include <functional>
+#include <array>
 #include <random> // for send/recv tag generation
 
 
@@ -130,7 +133,10 @@ namespace pt = boost::property_tree;
 #include <boost/serialization/vector.hpp>
 #endif
 
+#include "utility/node_shared.hpp"
+
 #include "vertex.hpp"
+#include "compact_mesh.hpp"
 #include "timeseries.hpp"
 #include "math/coordinates.hpp"
 #include "utility/xxh64.hpp"
@@ -215,24 +221,24 @@ public:
     ~face();
 
     /**
-    * Aspect of the face. North = 0, CW . Calculated on first use, subsequent usages will not recalculate
+    * Aspect of the face. North = 0, CW . Read from the compact_mesh once it is built, computed from the vertices before that
     * \return Face aspect [rad]
     */
     double aspect();
 
     /**
-    * Slope of the face. Calculated on first use, subsequent usages will not recalculate
+    * Slope of the face. Read from the compact_mesh once it is built, computed from the vertices before that
     * \return slope [rad]
     */
     double slope();
 
     /**
-    * Normalized face normal. Calculated on first use, subsequent usages will not recalculate
+    * Normalized face normal. Read from the compact_mesh once it is built, computed from the vertices before that
     */
     Vector_3 normal();
 
     /**
-    * Center of the face as defined by a centroid. Calculated on first use, subsequent usages will not recalculate
+    * Center of the face as defined by a centroid. Read from the compact_mesh once it is built, computed from the vertices before that
     */
     Point_3 center();
 
@@ -292,7 +298,14 @@ public:
     /**
     * Returns the face's vector of stations
     */
-  std::vector<std::shared_ptr<station>>& stations();
+  const std::vector<std::shared_ptr<station>>& stations();
+
+    /**
+    * Sets the face's station list. Faces that resolve to the same set of stations share a single list
+    * so the memory and interpolation setup cost is bounded by the number of unique station sets.
+    * @param stations
+    */
+  void set_stations(std::shared_ptr<std::vector<std::shared_ptr<station>>> stations);
 
     /**
     * Checks if a point x,y is within the face
@@ -341,12 +354,7 @@ public:
      * @return
      */
     Vector_3 face_vector(const std::string& variable);
-
-    /**
-    * Initializes  this faces variable storage
-    * \param variables Names of the variables to add
-    */
-    void init_time_series(std::set<std::string>& variables);
+    Vector_3 face_vector(const uint64_t& hash);
 
     /**
     * Initializes  this faces vector storage
@@ -354,12 +362,6 @@ public:
     */
     void init_vectors(std::set<std::string>& variables);
 
-    /**
-        * Initializes  this face's parameter storage
-        * \param variables Names of the variables to add
-    */
-    void init_parameters(std::set<std::string>& parameters);
-
     /**
     * Initializes this face's module data storage
     * \param variables Names of the modules that will store data
@@ -479,6 +481,7 @@ public:
 
     void set_initial_condition(std::string key,double value);
     double get_initial_condition(std::string key);
+    double get_initial_condition(const uint64_t& hash);
 
     /**
      * Returns a vector of names of all intial conditions
@@ -499,6 +502,9 @@ public:
     bool is_ghost=true;
     int ghost_type;
 
+    // set at the end of each timestep if the face has no snow, see triangulation::update_snow_free
+    bool snow_free=false;
+
     int  owner;  // MPI process that owns the face
 
 private:
@@ -507,12 +513,12 @@ private:
     OGRSpatialReference _face_utm_srs; // will hold the crs of the face,
 
 
-    double _slope;
-    double _azimuth;
-    double _area;
-    double _x;
-    double _y;
-    double _z;
+    // index of this face in the domain's compact_mesh, which holds its geometry and data, or -1 before that is built
+    int _compact_index;
+
+    // the domain's compact_mesh, for this face's variables, parameters and initial conditions. Throws if the face is
+    // not in it
+    compact_mesh& compact_data();
 
 
     //hold a pointer *back* to the triangulation. This let's use query triangles at distance X, etc
@@ -520,21 +526,15 @@ private:
     //const so we can't modify the domain via this as thar be dragons
     triangulation* _domain;
 
-    boost::shared_ptr<Point_3> _center;
-    boost::shared_ptr<Vector_3> _normal;
-
-
-    variablestorage<double> _variables;
-    variablestorage<double> _parameters;
 
     variablestorage< std::unique_ptr<face_info>> _module_face_data;
-    variablestorage<double> _initial_conditions;
     variablestorage< Vector_3> _module_face_vectors; //holds vector components, currently no checks on anything. Proceed with caution.
 
     boost::shared_ptr<timeseries> _data;
     timeseries::iterator _itr;
 
-    std::vector<std::shared_ptr<station>> _stations;
+    // possibly shared with other faces, see set_stations
+    std::shared_ptr< std::vector<std::shared_ptr<station>> > _stations;
 
     std::shared_ptr<station> _nearest_station;
 
@@ -575,6 +575,7 @@ typedef CGAL::Fuzzy_sphere<Traits> Fuzzy_circle;
 class triangulation
 : public Delaunay
 {
+    friend class TriangulationTest; // compares the distributed ghost region with the full mesh one
 public:
     triangulation();
     ~triangulation();
@@ -699,6 +700,18 @@ public:
    */
   void ghost_to_neighbors_communicate_variable(const uint64_t& var);
 
+  /**
+   * Number of locally owned faces sent to each partner rank in a ghost_neighbors_communicate_variable exchange
+   * @return key=partner rank, value=number of faces
+   */
+  std::map<int, size_t> ghost_send_sizes();
+
+  /**
+   * Number of ghost faces received from each partner rank in a ghost_neighbors_communicate_variable exchange
+   * @return key=partner rank, value=number of faces
+   */
+  std::map<int, size_t> ghost_recv_sizes();
+
     /**
     * Figures out which faces are required in the ghost region of an MPI process.
     * \param max_distance the maximum distance needed for communication
@@ -803,6 +816,25 @@ public:
     */
     mesh_elem face(size_t i);
 
+    /**
+     * Builds the index based copy of the local and ghost faces, see compact_mesh. Called at the end of loading and by
+     * prune_faces, so is always in step with face(i).
+     */
+    void build_compact_mesh();
+
+    /**
+     * The index based topology, geometry and face data of this rank's faces. Index i is face(i). The face data arrays
+     * may be written through the non-const overload.
+     */
+    const compact_mesh& compact() const;
+    compact_mesh& compact();
+
+    /**
+     * Takes the face areas from the area parameter, for the faces that have it. Geographic meshes provide their areas
+     * this way, and parameters are loaded after the compact mesh is built.
+     */
+    void update_compact_area();
+
     /**
     * Returns the vector of locally owned global IDs
     * - "locally owned" = this rank is responsible for their data
@@ -859,6 +891,40 @@ public:
                   std::set< std::string >& vectors,
                   std::set< std::string >& module_data);
 
+    /**
+     * Builds, for each of the given variables and parameters, a table of pointers into the storage of every local face,
+     * in local face order. These back face_range, so that block kernels gather and scatter a variable without a hash
+     * lookup per face. Must be called after the face data is initialized and is invalidated if it is reinitialized.
+     * Variables not stored on the faces are skipped. Faces without a parameter get a nullptr entry.
+     * @param variables
+     * @param parameters
+     */
+    void init_face_columns(const std::set<std::string>& variables, const std::set<std::string>& parameters);
+
+    /// Per-face pointers to a variable, or nullptr if init_face_columns did not build it
+    /// @param hash
+    const std::vector<double*>* variable_column(const uint64_t& hash) const;
+
+    /// Per-face pointers to a parameter, or nullptr if init_face_columns did not build it
+    /// @param hash
+    const std::vector<double*>* parameter_column(const uint64_t& hash) const;
+
+    /**
+     * Sets the snow_free flag of every local face from its current swe, and snowdepthavg if it is stored on the faces:
+     * a face is snow free if neither is positive. Core calls this at the end of each timestep. Also flags every block
+     * of block_size faces, in local face order, in which all faces are snow free, see snow_free_block.
+     * @param block_size
+     */
+    void update_snow_free(size_t block_size);
+
+    /**
+     * True if the faces [begin, end) are one of the blocks of the last update_snow_free and all ended that timestep
+     * snow free. False for any other range.
+     * @param begin
+     * @param end
+     */
+    bool snow_free_block(size_t begin, size_t end) const;
+
     /**
      * Prunes the internal vector that holds faces to only hold a subset. Does not actually remove the faces from the
      * triangulation. Cannot be used with MPI ranks >1 and outside point mode.
@@ -906,6 +972,17 @@ public:
      */
     void write_ghost_neighbors_to_vtu(bool write_ghost_neighbors);
 
+    /**
+     * In MPI mode, have each rank read only its own faces and ghost region from a non-partitioned h5 mesh instead
+     * of loading the entire mesh and discarding most of it.
+     */
+    void distributed_load(bool distributed);
+
+    /**
+     * Distance (m) from the rank boundary out to which faces are ghosted when the mesh is partitioned at runtime
+     */
+    void max_ghost_distance(double distance);
+
     /**
      * Returns the set of parameters available on the triangulation
      * @return
@@ -1017,6 +1094,40 @@ protected:
      */
     void load_mesh_from_h5(const std::string& mesh_filename);
 
+    /**
+     * Loads only the locally owned faces and the ghost region of a non-partitioned h5 mesh. The partition is the
+     * same equal split used by partition_mesh(). Replaces load_mesh_from_h5 + partition_mesh + ghost determination.
+     * @param mesh_filename
+     */
+    void load_distributed_mesh_from_h5(const std::string& mesh_filename);
+
+    /**
+     * Ghost region of the owned global id range [first, last]. The same sets as determine_local_boundary_faces,
+     * determine_process_ghost_faces_nearest_neighbors and determine_process_ghost_faces_by_distance give on a full mesh,
+     * but only needs the topology of the faces it visits. The search is breadth first from all boundary faces at once,
+     * so fetch is called once for the owned faces and then once per level.
+     * @param first First owned global id
+     * @param last Last owned global id
+     * @param max_distance Same as determine_process_ghost_faces_by_distance
+     * @param fetch Makes neighbors and center available for the given ids. May contain duplicates and ids already fetched
+     * @param neighbors The 3 neighbour global ids of a fetched face, -1 if there is no neighbour
+     * @param center Centre of a fetched face
+     * @param ghost_neighbors [out] Ghosts that neighbour an owned face
+     * @param ghost_faces [out] Ghosts within max_distance of a boundary face. Not necessarily a superset of ghost_neighbors
+     */
+    static void distributed_ghost_region(int first, int last, double max_distance,
+                                         const std::function<void(const std::vector<int>&)>& fetch,
+                                         const std::function<std::array<int, 3>(int)>& neighbors,
+                                         const std::function<Point_3(int)>& center,
+                                         std::set<int>& ghost_neighbors,
+                                         std::set<int>& ghost_faces);
+
+    /**
+     * Reads the /mesh attributes (version, projection, partition info) common to all h5 loaders
+     * @param file
+     */
+    void read_mesh_h5_attributes(H5::H5File& file);
+
     void determine_ghost_owners();
 
     /**
@@ -1055,11 +1166,50 @@ protected:
         std::map<std::string, vtkSmartPointer<vtkFloatArray> > vertex_data;
 #endif
 
+    // The output arrays above, resolved once in init_vtkUnstructured_Grid so that update_vtk_data can fill
+    // their raw buffers in parallel over tiles of faces without looking up arrays or variables by name
+    struct output_buffer
+    {
+        std::string name;
+        uint64_t hash;  // hash of the face variable, parameter, or initial condition this is filled from
+        float* values;  // _vtu_size values, 3 per face for vectors
+    };
+    std::vector<std::string> _vtu_output_variables; // the output_variables the arrays were made for
+    std::vector<output_buffer> _vtu_variables;
+    std::vector<output_buffer> _vtu_parameters;
+    std::vector<output_buffer> _vtu_ics;
+    std::vector<output_buffer> _vtu_vectors;
+    struct
+    {
+        float* elevation;
+        float* slope;
+        float* aspect;
+        float* area;
+        float* is_ghost;
+        float* ghost_type;
+        float* owner;
+    } _vtu_geometry;
+    unsigned long* _vtu_global_id_values;
+    size_t _vtu_size;
+
+    // from init_face_columns, key is the variable or parameter hash
+    std::map<uint64_t, std::vector<double*>> _variable_columns;
+    std::map<uint64_t, std::vector<double*>> _parameter_columns;
+
+    // from update_snow_free, one flag per block of _snow_free_block_size faces
+    std::vector<char> _snow_free_blocks;
+    size_t _snow_free_block_size = 0;
+
     //should we write parameters to the vtu file?
     bool _write_parameters_to_vtu;
     //should we write ghost neighbor faces to the vtu file?
     bool _write_ghost_neighbors_to_vtu;
 
+    //read only the local + ghost region of a non-partitioned h5 mesh
+    bool _distributed_load;
+    //ghost region radius when partitioning at runtime
+    double _max_ghost_distance;
+
     // min and max elevations
     double _min_z;
     double _max_z;
@@ -1132,6 +1282,8 @@ protected:
 
     std::vector<int> _global_IDs;
 
+    compact_mesh _compact;
+
   std::vector< std::shared_ptr<station> > _stations;
 
   std::string _partition_method;
@@ -1279,9 +1431,20 @@ private:
 };
 
 template < class Gt, class Fb>
-std::vector<std::shared_ptr<station>>& face<Gt, Fb>::stations()
+const std::vector<std::shared_ptr<station>>& face<Gt, Fb>::stations()
 {
-    return _stations;
+    static const std::vector<std::shared_ptr<station>> empty;
+
+    if(!_stations)
+        return empty;
+
+    return *_stations;
+}
+
+template < class Gt, class Fb>
+void face<Gt, Fb>::set_stations(std::shared_ptr<std::vector<std::shared_ptr<station>>> stations)
+{
+    _stations = stations;
 }
 
 template < class Gt, class Fb>
@@ -1290,61 +1453,78 @@ std::shared_ptr<station>& face<Gt, Fb>::nearest_station()
     return _nearest_station;
 }
 
+template < class Gt, class Fb>
+compact_mesh& face<Gt, Fb>::compact_data()
+{
+    if (_compact_index < 0)
+    {
+        CHM_THROW_EXCEPTION(module_error, "Face data is not available, the face is not part of the compact mesh.");
+    }
+    return _domain->compact();
+}
+
 template < class Gt, class Fb>
 bool face<Gt, Fb>::has_parameter(const std::string& variable)
 {
-    return _parameters.has(variable);
+    return has_parameter(xxh64::hash(variable.c_str(), variable.length()));
 }
 
 template < class Gt, class Fb>
 bool face<Gt, Fb>::has_parameter(const uint64_t& hash)
 {
-    return _parameters.has(hash);
-
+    return _compact_index >= 0 && _domain->compact().parameters.has(hash);
 }
 
 template < class Gt, class Fb >
 double& face<Gt, Fb>::parameter(const std::string& variable)
 {
-    return _parameters[variable];
+    return compact_data().parameters.at(variable, _compact_index);
 };
 
 template < class Gt, class Fb >
 double& face<Gt, Fb>::parameter(const uint64_t& hash)
 {
-    return _parameters[hash];
-
-
+    return compact_data().parameters.at(hash, _compact_index);
 };
 
 template < class Gt, class Fb >
 bool face<Gt, Fb>::has_initial_condition(std::string key)
 {
-    return _initial_conditions.has(key);
+    return _compact_index >= 0 && _domain->compact().initial_conditions.has(xxh64::hash(key.c_str(), key.length()));
 }
 
 template < class Gt, class Fb >
 void face<Gt, Fb>::set_initial_condition(std::string key, double value)
 {
-    _initial_conditions[key] = value;
+    compact_data().initial_conditions.at(key, _compact_index) = value;
 }
 
 template < class Gt, class Fb >
 double face<Gt, Fb>::get_initial_condition(std::string key)
 {
-    return _initial_conditions[key];
+    return compact_data().initial_conditions.at(key, _compact_index);
+};
+
+template < class Gt, class Fb >
+double face<Gt, Fb>::get_initial_condition(const uint64_t& hash)
+{
+    return compact_data().initial_conditions.at(hash, _compact_index);
 };
 
 template < class Gt, class Fb >
 std::vector<std::string>  face<Gt, Fb>::parameters()
 {
-    return _parameters.variables();
+    if (_compact_index < 0)
+        return {};
+    return _domain->compact().parameters.names();
 };
 
 template < class Gt, class Fb >
 std::vector<std::string>  face<Gt, Fb>::initial_conditions()
 {
-    return _initial_conditions.variables();
+    if (_compact_index < 0)
+        return {};
+    return _domain->compact().initial_conditions.names();
 };
 
 template < class Gt, class Fb >
@@ -1361,12 +1541,8 @@ face<Gt, Fb>::~face()
 template < class Gt, class Fb >
 face<Gt, Fb>::face()
 {
-    _slope = -1;
-    _azimuth = -1;
+    _compact_index = -1;
     _data = boost::make_shared<timeseries>();
-    _center = NULL;
-    _normal = NULL;
-    _area = -1.;
     _is_geographic = false;
 
 
@@ -1379,12 +1555,8 @@ face<Gt, Fb>::face(Vertex_handle v0,
                    Vertex_handle v2)
         : Fb(v0, v1, v2)
 {
-    _slope = -1;
-    _azimuth = -1;
+    _compact_index = -1;
     _data = boost::make_shared<timeseries>();
-    _center = NULL;
-    _normal = NULL;
-    _area = -1.;
     _is_geographic = false;
 
 }
@@ -1398,12 +1570,8 @@ face<Gt, Fb>::face(Vertex_handle v0,
                    Face_handle n2)
         : Fb(v0, v1, v2, n0, n1, n2)
 {
-    _slope = -1;
-    _azimuth = -1;
+    _compact_index = -1;
     _data = boost::make_shared<timeseries>();
-    _center = NULL;
-    _normal = NULL;
-    _area = -1.;
     _is_geographic = false;
 
 }
@@ -1420,12 +1588,8 @@ face<Gt, Fb>::face(Vertex_handle v0,
                    bool c2)
         : Fb(v0, v1, v2, n0, n1, n2)
 {
-    _slope = -1;
-    _azimuth = -1;
+    _compact_index = -1;
     _data = boost::make_shared<timeseries>();
-    _center = NULL;
-    _normal = NULL;
-    _area = -1.;
     _is_geographic = false;
 
 
@@ -1434,21 +1598,22 @@ face<Gt, Fb>::face(Vertex_handle v0,
 template < class Gt, class Fb>
 double face<Gt, Fb>::aspect()
 {
-    if (_azimuth == -1)
-    {
-        if(!_normal)
-            this->normal();
-
-        _azimuth = math::gis::cartesian_to_bearing(Vector_2((*_normal)[0],(*_normal)[1])) * M_PI/180.; //need in radians
-
-    }
+    if (_compact_index >= 0)
+        return _domain->compact().aspect[_compact_index];
 
-    return _azimuth;
+    auto n = this->normal();
+    return math::gis::cartesian_to_bearing(Vector_2(n[0],n[1])) * M_PI/180.; //need in radians
 }
 
 template < class Gt, class Fb>
 Vector_2 face<Gt, Fb>::edge_unit_normal(int i)
 {
+    if (_compact_index >= 0)
+    {
+        auto& c = _domain->compact();
+        return Vector_2(c.edge_normal_x[3 * _compact_index + i], c.edge_normal_y[3 * _compact_index + i]);
+    }
+
     auto e = edge(i);
     auto e1 = edge( (i+1) % 3);
 
@@ -1499,6 +1664,9 @@ Point_2 face<Gt, Fb>::edge_midpoint(int i)
 template < class Gt, class Fb>
 double face<Gt, Fb>::edge_length(int i)
 {
+    if (_compact_index >= 0)
+        return _domain->compact().edge_length(_compact_index, i);
+
     auto e = edge(i);
 
     return CGAL::sqrt(e.squared_length());
@@ -1507,26 +1675,23 @@ double face<Gt, Fb>::edge_length(int i)
 template < class Gt, class Fb>
 double face<Gt, Fb>::slope()
 {
-    if (_slope == -1)
-    {
-        if(!_normal)
-            this->normal();
+    if (_compact_index >= 0)
+        return _domain->compact().slope[_compact_index];
 
-        //z surface normal
-        arma::vec n(3);
-        n(0) = 0.0; //x
-        n(1) = 0.0; //y
-        n(2) = 1.0;
+    auto face_normal = this->normal();
 
-        arma::vec normal(3);
-        normal(0) = (*_normal)[0];
-        normal(1) = (*_normal)[1];
-        normal(2) = (*_normal)[2];
+    //z surface normal
+    arma::vec n(3);
+    n(0) = 0.0; //x
+    n(1) = 0.0; //y
+    n(2) = 1.0;
 
-        _slope = acos(arma::norm_dot(normal, n));
-    }
+    arma::vec normal(3);
+    normal(0) = face_normal[0];
+    normal(1) = face_normal[1];
+    normal(2) = face_normal[2];
 
-    return _slope;
+    return acos(arma::norm_dot(normal, n));
 }
 
 template < class Gt, class Fb>
@@ -1555,44 +1720,41 @@ const typename face<Gt, Fb>::Face_handle face<Gt, Fb>::find_closest_face(double
 template < class Gt, class Fb>
 Vector_3 face<Gt, Fb>::normal()
 {
-    if(!_normal)
+    if (_compact_index >= 0)
     {
-        if(_is_geographic)
-        {
+        auto& c = _domain->compact();
+        return Vector_3(c.nx[_compact_index], c.ny[_compact_index], c.nz[_compact_index]);
+    }
 
-//            OGRSpatialReference monUtm;
-//
-//            OGRSpatialReference monGeo;
-//            monGeo.SetWellKnownGeogCS("WGS84");
+    if(_is_geographic)
+    {
 
+//        OGRSpatialReference monUtm;
+//
+//        OGRSpatialReference monGeo;
+//        monGeo.SetWellKnownGeogCS("WGS84");
 
-            CGAL::Point_3<K> v0(this->vertex(0)->point()[0]*100000., this->vertex(0)->point()[1]*100000.,this->vertex(0)->point()[2]);
-            CGAL::Point_3<K> v1(this->vertex(1)->point()[0]*100000., this->vertex(1)->point()[1]*100000.,this->vertex(1)->point()[2]);
-            CGAL::Point_3<K> v2(this->vertex(2)->point()[0]*100000., this->vertex(2)->point()[1]*100000.,this->vertex(2)->point()[2]);
 
-            _normal = boost::make_shared<Vector_3>(CGAL::unit_normal(v0, v1, v2));
+        CGAL::Point_3<K> v0(this->vertex(0)->point()[0]*100000., this->vertex(0)->point()[1]*100000.,this->vertex(0)->point()[2]);
+        CGAL::Point_3<K> v1(this->vertex(1)->point()[0]*100000., this->vertex(1)->point()[1]*100000.,this->vertex(1)->point()[2]);
+        CGAL::Point_3<K> v2(this->vertex(2)->point()[0]*100000., this->vertex(2)->point()[1]*100000.,this->vertex(2)->point()[2]);
 
-        }
-        else
-            _normal = boost::make_shared<Vector_3>(CGAL::unit_normal(this->vertex(0)->point(), this->vertex(1)->point(), this->vertex(2)->point()));
+        return CGAL::unit_normal(v0, v1, v2);
     }
 
-    return *_normal;
+    return CGAL::unit_normal(this->vertex(0)->point(), this->vertex(1)->point(), this->vertex(2)->point());
 }
 
 template < class Gt, class Fb>
 Point_3 face<Gt, Fb>::center()
 {
-    if (!_center)
+    if (_compact_index >= 0)
     {
-        _center = boost::make_shared<Point_3>(CGAL::centroid(this->vertex(0)->point(), this->vertex(1)->point(), this->vertex(2)->point()));
-        _x=_center->x();
-        _y=_center->y();
-        _z=_center->z();
+        auto& c = _domain->compact();
+        return Point_3(c.x[_compact_index], c.y[_compact_index], c.z[_compact_index]);
     }
-    //return CGAL::centroid(this->vertex(0)->point(), this->vertex(1)->point(), this->vertex(2)->point());
-    return *_center;
 
+    return CGAL::centroid(this->vertex(0)->point(), this->vertex(1)->point(), this->vertex(2)->point());
 }
 template < class Gt, class Fb>
 bool face<Gt, Fb>::contains(Point_3 p)
@@ -1629,34 +1791,34 @@ bool face<Gt, Fb>::contains(double x, double y)
 template < class Gt, class Fb>
 std::vector<std::string> face<Gt, Fb>::variables()
 {
-
-    return _variables.variables();
+    if (_compact_index < 0)
+        return {};
+    return _domain->compact().variables.names();
 }
 
 
 template < class Gt, class Fb>
 bool face<Gt, Fb>::has(const std::string& variable)
 {
-    return _variables.has(variable);
-
+    return has(xxh64::hash(variable.c_str(), variable.length()));
 };
 
 template < class Gt, class Fb>
 bool face<Gt, Fb>::has(const uint64_t& hash)
 {
-    return _variables.has(hash);
+    return _compact_index >= 0 && _domain->compact().variables.has(hash);
 }
 
 template < class Gt, class Fb>
 double& face<Gt, Fb>::operator[](const uint64_t& hash)
 {
-     return _variables[hash];
+     return compact_data().variables.at(hash, _compact_index);
 }
 
 template < class Gt, class Fb>
 double& face<Gt, Fb>::operator[](const std::string& variable)
 {
-    return _variables[variable];
+    return compact_data().variables.at(variable, _compact_index);
 }
 
 template < class Gt, class Fb >
@@ -1710,10 +1872,10 @@ Vector_3 face<Gt, Fb>::face_vector(const std::string& variable)
 };
 
 template < class Gt, class Fb>
-void face<Gt, Fb>::init_time_series(std::set<std::string>& variables)
+Vector_3 face<Gt, Fb>::face_vector(const uint64_t& hash)
 {
-    _variables.init(variables);
-}
+    return _module_face_vectors[hash];
+};
 
 template < class Gt, class Fb>
 void face<Gt, Fb>::init_vectors(std::set<std::string>& variables)
@@ -1721,13 +1883,6 @@ void face<Gt, Fb>::init_vectors(std::set<std::string>& variables)
     _module_face_vectors.init(variables);
 }
 
-template < class Gt, class Fb>
-void face<Gt, Fb>::init_parameters(std::set<std::string>& parameters)
-{
-
-    _parameters.init(parameters);
-}
-
 template < class Gt, class Fb>
 void face<Gt, Fb>::init_module_data(std::set<std::string>& modules)
 {
@@ -1761,29 +1916,28 @@ void face<Gt, Fb>::to_file(std::string fname)
 template < class Gt, class Fb>
 double face<Gt, Fb>::get_x()
 {
-    if(!_center)
-        this->center();
+    if (_compact_index >= 0)
+        return _domain->compact().x[_compact_index];
 
-    return _x;
+    return this->center().x();
 }
 
 template < class Gt, class Fb>
 double face<Gt, Fb>::get_y()
 {
-    if(!_center)
-        this->center();
+    if (_compact_index >= 0)
+        return _domain->compact().y[_compact_index];
 
-
-    return _y;
+    return this->center().y();
 }
 
 template < class Gt, class Fb>
 double face<Gt, Fb>::get_z()
 {
-    if(!_center)
-        this->center();
+    if (_compact_index >= 0)
+        return _domain->compact().z[_compact_index];
 
-    return _z;
+    return this->center().z();
 }
 template < class Gt, class Fb>
 boost::shared_ptr<timeseries> face<Gt, Fb>::get_underlying_timeseries()
@@ -1836,30 +1990,20 @@ void face<Gt, Fb>::set_face_vector(const std::string& variable, Vector_3 v)
 template < class Gt, class Fb>
 double face<Gt, Fb>::get_area()
 {
-    if(_area == -1)
-    {
-        // supports geographic
-        if(has_parameter("area"_s))
-        {
-            _area = parameter("area"_s);
-        }
-        else
-        {
-
-            auto& pa = this->vertex(0)->point();
-            auto& pb = this->vertex(1)->point();
-            auto& pc = this->vertex(2)->point();
-
+    if (_compact_index >= 0)
+        return _domain->compact().area[_compact_index];
 
-            //same way it's done in mesher for consistency
-            typename Fb::Geom_traits traits;
-            _area = CGAL::to_double(traits.compute_area_2_object()(pa, pb, pc));
-
-        }
-    }
+    // supports geographic
+    if(has_parameter("area"_s))
+        return parameter("area"_s);
 
+    auto& pa = this->vertex(0)->point();
+    auto& pb = this->vertex(1)->point();
+    auto& pc = this->vertex(2)->point();
 
-    return _area;
+    //same way it's done in mesher for consistency
+    typename Fb::Geom_traits traits;
+    return CGAL::to_double(traits.compute_area_2_object()(pa, pb, pc));
 }
 template < class Gt, class Fb>
 double face<Gt, Fb>::get_subgrid_z(Point_2 query)
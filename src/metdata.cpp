@@ -23,6 +23,16 @@
 
 #include "metdata.hpp"
 
+#include "timer.hpp"
+
+#include <gdal_priv.h>
+#include <cpl_conv.h>
+
+#include <boost/filesystem.hpp>
+
+#include <atomic>
+#include <limits>
+
 metdata::metdata(std::string mesh_proj4)
 {
     _nc = nullptr;
@@ -53,15 +63,7 @@ void metdata::load_from_netcdf(const std::string& path, const triangulation::bou
     _use_netcdf = true;
     _nc = std::make_unique<netcdf>();
 
-    // make a copy of the filters and track what they provide
-    for(auto& itr : filters)
-    {
-        _netcdf_filters[itr.first] = itr.second;
-        for(auto& p : itr.second->provides())
-        {
-            _provides_from_nc_filters.insert(p);
-        }
-    }
+    set_grid_filters(filters);
 
     // spatial reference conversions to ensure the virtual station coordinates are the same as the meshes'
     OGRSpatialReference insrs, outsrs;
@@ -204,6 +206,466 @@ void metdata::load_from_netcdf(const std::string& path, const triangulation::bou
     _current_ts = _start_time;
 }
 
+void metdata::set_grid_filters(std::map<std::string, boost::shared_ptr<filter_base> >& filters)
+{
+    // make a copy of the filters and track what they provide
+    for(auto& itr : filters)
+    {
+        _netcdf_filters[itr.first] = itr.second;
+        for(auto& p : itr.second->provides())
+        {
+            _provides_from_nc_filters.insert(p);
+        }
+    }
+}
+
+void metdata::load_from_grib2(const std::string& path, const triangulation::bounding_box* box,
+                              std::map<std::string, boost::shared_ptr<filter_base> > filters,
+                              std::map<std::string, std::string> variables)
+{
+    if(_mesh_proj4 == "")
+    {
+        CHM_THROW_EXCEPTION(forcing_error, "Met loader not initialized with proj4 string");
+    }
+
+    SPDLOG_DEBUG("Found GRIB2 forcing");
+
+    timer c;
+    c.tic();
+
+    set_grid_filters(filters);
+
+    // HRDPS fields, as used by tools/NWP_forcing
+    std::map<std::string, std::string> defaults = {
+        {"t", "TMP:2-HTGL"},
+        {"rh", "RH:2-HTGL"},
+        {"u", "WIND:10-HTGL"},
+        {"vw_dir", "WDIR:10-HTGL"},
+        {"p", "PRATE:0-SFC"},
+        {"press", "PRES:0-SFC"},
+        {"Qsi", "DSWRF:0-SFC"},
+        {"Qli", "DLWRF:0-SFC"},
+        {"elevation", "HGT:0-SFC"}};
+
+    for (auto& itr : variables)
+        defaults[itr.first] = itr.second;
+
+    // ELEMENT:LEVEL -> CHM variable
+    std::map<std::string, std::string> messages;
+    for (auto& itr : defaults)
+        messages[itr.second] = itr.first;
+
+    std::vector<boost::filesystem::path> files;
+    if (boost::filesystem::is_directory(path))
+    {
+        for (auto& entry : boost::filesystem::directory_iterator(path))
+        {
+            auto ext = entry.path().extension().string();
+            if (ext == ".grib2" || ext == ".grb2")
+                files.push_back(entry.path());
+        }
+        std::sort(files.begin(), files.end());
+    }
+    else
+    {
+        files.push_back(path);
+    }
+
+    if (files.empty())
+    {
+        CHM_THROW_EXCEPTION(forcing_error, "No GRIB2 files found in " + path);
+    }
+
+    GDALAllRegister();
+
+    // GDAL otherwise converts K to C itself, the conversions below expect the units as they are in the file
+    CPLSetConfigOption("GRIB_NORMALIZE_UNITS", "NO");
+
+    // a GRIB2 message that is needed
+    struct message
+    {
+        size_t file;
+        int band;
+        std::string variable;
+        time_t time;
+    };
+    std::vector<message> found;
+
+    int xsize = 0, ysize = 0;
+    double gt[6];
+    OGRSpatialReference insrs;
+
+    // Find the messages and check that all the files are on the same grid
+    for (size_t f = 0; f < files.size(); f++)
+    {
+        auto* ds = static_cast<GDALDataset*>(GDALOpen(files[f].string().c_str(), GA_ReadOnly));
+        if (!ds)
+        {
+            CHM_THROW_EXCEPTION(forcing_error, "Unable to open GRIB2 file " + files[f].string());
+        }
+
+        double file_gt[6];
+        ds->GetGeoTransform(file_gt);
+
+        if (f == 0)
+        {
+            xsize = ds->GetRasterXSize();
+            ysize = ds->GetRasterYSize();
+            std::copy(file_gt, file_gt + 6, gt);
+
+            if (!ds->GetSpatialRef())
+            {
+                GDALClose(ds);
+                CHM_THROW_EXCEPTION(forcing_error, "GRIB2 file " + files[f].string() + " has no spatial reference");
+            }
+            insrs = *ds->GetSpatialRef();
+        }
+        else if (ds->GetRasterXSize() != xsize || ds->GetRasterYSize() != ysize ||
+                 !std::equal(gt, gt + 6, file_gt, [](double a, double b) { return std::fabs(a - b) < 1e-6 * std::max(1.0, std::fabs(a)); }))
+        {
+            GDALClose(ds);
+            CHM_THROW_EXCEPTION(forcing_error, "GRIB2 file " + files[f].string() + " is not on the same grid as " + files[0].string());
+        }
+
+        for (int b = 1; b <= ds->GetRasterCount(); b++)
+        {
+            auto* band = ds->GetRasterBand(b);
+            auto element = band->GetMetadataItem("GRIB_ELEMENT");
+            auto level = band->GetMetadataItem("GRIB_SHORT_NAME");
+            auto valid = band->GetMetadataItem("GRIB_VALID_TIME");
+            if (!element || !level || !valid)
+                continue;
+
+            auto itr = messages.find(std::string(element) + ":" + level);
+            if (itr == messages.end())
+                continue;
+
+            // older GDAL has this as "  1479700800 sec UTC"
+            found.push_back({f, b, itr->second, static_cast<time_t>(std::stoll(valid))});
+        }
+
+        GDALClose(ds);
+    }
+
+    // stored variables, elevation is only used for the stations
+    std::vector<std::string> names;
+    for (auto& itr : defaults)
+    {
+        if (itr.first == "elevation")
+            continue;
+
+        bool present = std::any_of(found.begin(), found.end(), [&](const message& m) { return m.variable == itr.first; });
+        if (present)
+            names.push_back(itr.first);
+        else
+            SPDLOG_WARN("No GRIB2 messages for {} ({})", itr.first, itr.second);
+    }
+
+    auto elevation = std::find_if(found.begin(), found.end(), [](const message& m) { return m.variable == "elevation"; });
+    if (elevation == found.end())
+    {
+        CHM_THROW_EXCEPTION(forcing_error, "The GRIB2 files do not have the surface height field " + defaults["elevation"]);
+    }
+    if (names.empty())
+    {
+        CHM_THROW_EXCEPTION(forcing_error, "The GRIB2 files do not have any of the forcing variables");
+    }
+
+    std::vector<time_t> times;
+    for (auto& m : found)
+    {
+        if (m.variable != "elevation")
+            times.push_back(m.time);
+    }
+    std::sort(times.begin(), times.end());
+    times.erase(std::unique(times.begin(), times.end()), times.end());
+
+    if (times.size() < 2)
+    {
+        CHM_THROW_EXCEPTION(forcing_error, "The GRIB2 files need at least 2 timesteps");
+    }
+
+    time_t dt = times[1] - times[0];
+    for (size_t t = 1; t < times.size(); t++)
+    {
+        if (times[t] - times[t - 1] != dt)
+        {
+            CHM_THROW_EXCEPTION(forcing_error, "The GRIB2 files are not at a constant timestep");
+        }
+    }
+
+    // Grid cell centres in the mesh coordinate system
+    OGRSpatialReference outsrs;
+    insrs.SetAxisMappingStrategy(OAMS_TRADITIONAL_GIS_ORDER);
+    outsrs.SetAxisMappingStrategy(OAMS_TRADITIONAL_GIS_ORDER);
+    if (outsrs.importFromProj4(_mesh_proj4.c_str()))
+    {
+        CHM_THROW_EXCEPTION(forcing_error, "Failure importing mesh proj4 string");
+    }
+
+    size_t ncells_grid = static_cast<size_t>(xsize) * ysize;
+    std::vector<double> cx(ncells_grid), cy(ncells_grid);
+    for (int y = 0; y < ysize; y++)
+    {
+        for (int x = 0; x < xsize; x++)
+        {
+            size_t index = x + y * static_cast<size_t>(xsize);
+            cx[index] = gt[0] + (x + 0.5) * gt[1] + (y + 0.5) * gt[2];
+            cy[index] = gt[3] + (x + 0.5) * gt[4] + (y + 0.5) * gt[5];
+        }
+    }
+
+    auto coordTrans = OGRCreateCoordinateTransformation(&insrs, &outsrs);
+    if (!coordTrans)
+    {
+        CHM_THROW_EXCEPTION(forcing_error, "Error creating CRS transform in Met loader");
+    }
+    std::vector<int> ok(ncells_grid);
+    coordTrans->Transform(ncells_grid, cx.data(), cy.data(), nullptr, ok.data());
+    OGRCoordinateTransformation::DestroyCT(coordTrans);
+
+    // Only the region covering the cells in the bounding box is read
+    std::vector<char> inside(ncells_grid);
+    size_t x0 = SIZE_MAX, x1 = 0, y0 = SIZE_MAX, y1 = 0;
+    for (size_t index = 0; index < ncells_grid; index++)
+    {
+        inside[index] = ok[index] && (!box || (cx[index] <= box->x_max && cx[index] >= box->x_min &&
+                                               cy[index] <= box->y_max && cy[index] >= box->y_min));
+        if (!inside[index])
+            continue;
+
+        x0 = std::min(x0, index % xsize);
+        x1 = std::max(x1, index % xsize);
+        y0 = std::min(y0, index / xsize);
+        y1 = std::max(y1, index / xsize);
+    }
+
+    if (x0 == SIZE_MAX)
+    {
+        CHM_THROW_EXCEPTION(forcing_error, "No GRIB2 grid cells are within the mesh bounding box");
+    }
+
+    auto& g = _grib2;
+    g.variables = names;
+    g.x = x0;
+    g.y = y0;
+    g.nx = x1 - x0 + 1;
+    g.ny = y1 - y0 + 1;
+    g.start = boost::posix_time::from_time_t(times[0]);
+
+    size_t ncells = g.nx * g.ny;
+    size_t nvars = names.size();
+
+    std::vector<float> z(ncells);
+
+    // reads the region of a message into out, nodata as NaN
+    auto read = [&](const message& m, float* out)
+    {
+        auto* ds = static_cast<GDALDataset*>(GDALOpen(files[m.file].string().c_str(), GA_ReadOnly));
+        if (!ds)
+            return false;
+
+        auto* band = ds->GetRasterBand(m.band);
+        bool good = band->RasterIO(GF_Read, g.x, g.y, g.nx, g.ny, out, g.nx, g.ny, GDT_Float32, 0, 0) == CE_None;
+
+        int has_nodata = 0;
+        double nodata = band->GetNoDataValue(&has_nodata);
+        if (has_nodata)
+        {
+            for (size_t i = 0; i < ncells; i++)
+            {
+                if (out[i] == static_cast<float>(nodata))
+                    out[i] = std::nanf("");
+            }
+        }
+
+        GDALClose(ds);
+        return good;
+    };
+
+    if (!read(*elevation, z.data()))
+    {
+        CHM_THROW_EXCEPTION(forcing_error, "Unable to read " + files[elevation->file].string());
+    }
+
+    std::map<std::string, size_t> var_index;
+    for (size_t v = 0; v < nvars; v++)
+        var_index[names[v]] = v;
+
+    // later files win if a message is repeated
+    std::map<std::pair<size_t, size_t>, size_t> slots; // (time, variable) -> found
+    for (size_t i = 0; i < found.size(); i++)
+    {
+        if (found[i].variable == "elevation")
+            continue;
+
+        size_t t = std::lower_bound(times.begin(), times.end(), found[i].time) - times.begin();
+        slots[{t, var_index[found[i].variable]}] = i;
+    }
+    std::vector<std::pair<std::pair<size_t, size_t>, size_t>> reads(slots.begin(), slots.end());
+
+    size_t first = grib2_first_timestep(names);
+
+    // reads and converts every timestep into all
+    size_t nvalues = times.size() * nvars * ncells;
+    auto fill = [&](float* all)
+    {
+        std::fill(all, all + nvalues, std::nanf(""));
+
+        // GDAL datasets are not shared between threads, so the reads are independent
+        std::atomic<bool> failed{false};
+#pragma omp parallel for schedule(dynamic)
+        for (size_t r = 0; r < reads.size(); r++)
+        {
+            size_t t = reads[r].first.first;
+            size_t v = reads[r].first.second;
+            if (!read(found[reads[r].second], &all[(t * nvars + v) * ncells]))
+                failed = true;
+        }
+        if (failed)
+        {
+            CHM_THROW_EXCEPTION(forcing_error, "Unable to read the GRIB2 files");
+        }
+
+        size_t missing = convert_grib2(all, names, times.size(), ncells, dt);
+        if (missing > 0)
+        {
+            SPDLOG_WARN("{} GRIB2 values are missing and have been set to -9999", missing);
+        }
+    };
+
+#ifdef USE_MPI
+    if (g.share && g.node.size() > 1)
+    {
+        g.shared.allocate(g.node, nvalues, fill);
+        g.data = g.shared.data();
+
+        if (g.node.rank() == 0)
+            SPDLOG_INFO("GRIB2 forcing values are held once for the {} ranks on this node, {:.1f} MiB not duplicated",
+                        g.node.size(), nvalues * sizeof(float) * (g.node.size() - 1) / (1024.0 * 1024.0));
+    }
+    else
+#endif
+    {
+        g.values.resize(nvalues);
+        fill(g.values.data());
+        g.data = g.values.data();
+    }
+
+    _variables.clear();
+    _variables.insert(names.begin(), names.end());
+    _variables.insert(_provides_from_nc_filters.begin(), _provides_from_nc_filters.end());
+
+    _stations.clear();
+    for (size_t y = g.y; y < g.y + g.ny; y++)
+    {
+        for (size_t x = g.x; x < g.x + g.nx; x++)
+        {
+            size_t index = x + y * xsize;
+            double elev = z[(y - g.y) * g.nx + (x - g.x)];
+
+            if (!inside[index] || std::isnan(elev))
+                continue;
+
+            auto s = std::make_shared<station>(std::to_string(index), cx[index], cy[index], elev, _variables);
+            s->_nc_x = x;
+            s->_nc_y = y;
+
+            _stations.push_back(s);
+            _dD_tree.insert(boost::make_tuple(Kernel::Point_2(s->x(), s->y()), s));
+        }
+    }
+    _nstations = _stations.size();
+
+    if (_nstations == 0)
+    {
+        CHM_THROW_EXCEPTION(forcing_error, "All GRIB2 grid cells within the bounding box have a missing elevation");
+    }
+
+    g.enable = true;
+
+    _dt = boost::posix_time::seconds(dt);
+    _start_time = boost::posix_time::from_time_t(times[first]);
+    _end_time = boost::posix_time::from_time_t(times.back());
+    _n_timesteps = times.size() - first;
+    _current_ts = _start_time;
+
+    SPDLOG_INFO("Read {} GRIB2 files: {} variables, {} timesteps, {} stations from a {} x {} region of the {} x {} grid in {} s",
+                files.size(), nvars, _n_timesteps, _nstations, g.nx, g.ny, xsize, ysize, c.toc<s>());
+}
+
+size_t metdata::grib2_first_timestep(const std::vector<std::string>& variables)
+{
+    bool accumulated = std::any_of(variables.begin(), variables.end(),
+                                   [](const std::string& name) { return name == "Qsi" || name == "Qli"; });
+    return accumulated ? 1 : 0;
+}
+
+size_t metdata::convert_grib2(float* values, const std::vector<std::string>& variables, size_t ntimes, size_t ncells,
+                              time_t dt)
+{
+    size_t nvars = variables.size();
+
+    // Unit conversions, as in tools/NWP_forcing/GRIB2_to_Netcdf.py
+    for (size_t v = 0; v < nvars; v++)
+    {
+        auto& name = variables[v];
+        auto at = [&](size_t t) { return &values[(t * nvars + v) * ncells]; };
+
+        if (name == "Qsi" || name == "Qli")
+        {
+            // accumulated J/m^2 -> W/m^2. The first timestep is unknown. Backwards in time so that the previous
+            // timestep is still the accumulation
+            for (size_t t = ntimes - 1; t > 0; t--)
+            {
+                float* cur = at(t);
+                const float* prev = at(t - 1);
+                for (size_t i = 0; i < ncells; i++)
+                {
+                    cur[i] = (cur[i] - prev[i]) / dt;
+                    if (name == "Qsi" && cur[i] < 0)
+                        cur[i] = 0;
+                }
+            }
+            continue;
+        }
+
+        double scale = 1;
+        double offset = 0;
+        if (name == "t")
+            offset = -273.15; // K -> C
+        else if (name == "p")
+            scale = dt; // kg/(m^2 s) -> mm per timestep
+        else if (name == "press")
+            scale = 0.01; // Pa -> hPa
+        else
+            continue;
+
+        for (size_t t = 0; t < ntimes; t++)
+        {
+            float* cur = at(t);
+            for (size_t i = 0; i < ncells; i++)
+                cur[i] = cur[i] * scale + offset;
+        }
+    }
+
+    // missing values
+    size_t missing = 0;
+    for (size_t t = grib2_first_timestep(variables); t < ntimes; t++)
+    {
+        for (size_t k = 0; k < nvars * ncells; k++)
+        {
+            float& value = values[t * nvars * ncells + k];
+            if (std::isnan(value))
+            {
+                value = -9999;
+                ++missing;
+            }
+        }
+    }
+    return missing;
+}
+
 void metdata::load_from_ascii(std::vector<ascii_metdata> stations, int utc_offset)
 {
     if(_mesh_proj4 == "")
@@ -387,6 +849,10 @@ bool metdata::is_netcdf()
 {
     return _use_netcdf;
 }
+bool metdata::is_grib2()
+{
+    return _grib2.enable;
+}
 void metdata::subset(boost::posix_time::ptime start, boost::posix_time::ptime end)
 {
     if( _dt.total_seconds() == 0)
@@ -494,6 +960,10 @@ bool metdata::next()
     {
         has_next = next_nc();
     }
+    else if(_grib2.enable)
+    {
+        has_next = next_grib2();
+    }
     else
     {
         has_next = next_ascii();
@@ -503,6 +973,15 @@ bool metdata::next()
     return has_next;
 }
 
+bool metdata::next_time_only()
+{
+    if(!is_first_timestep)
+        _current_ts = _current_ts + _dt;
+
+    is_first_timestep = false;
+    return _current_ts <= _end_time;
+}
+
 bool metdata::next_ascii()
 {
 
@@ -557,6 +1036,19 @@ bool metdata::next_nc()
     }
 
 
+#ifdef USE_MPI
+    if(_io_aggregation.enable)
+    {
+        next_nc_aggregated();
+        return true;
+    }
+#endif
+
+    // don't use the stations variable map as it'll contain anything inserted by a filter which won't exist in the nc file
+    auto names = _nc->get_variable_names();
+    std::vector<std::string> variables(names.begin(), names.end());
+    std::vector<double> values(variables.size());
+
     //The call to netCDF isn't thread safe. It is protected by a critical section but it's costly, and not running this
     // in parallel is about 2x faster  #pragma omp parallel for
     for(size_t i = 0; i < nstations();i++)
@@ -567,26 +1059,191 @@ bool metdata::next_nc()
         if(!s)
             continue;
 
-        s->set_posix(_current_ts);
-
-        // don't use the stations variable map as it'll contain anything inserted by a filter which won't exist in the nc file
-        for (auto &v: _nc->get_variable_names() )
+        for (size_t v = 0; v < variables.size(); v++)
         {
-            double d = _nc->get_var(v, _current_ts, s->_nc_x, s->_nc_y);
-            (*s)[v] = d;
-
+            values[v] = _nc->get_var(variables[v], _current_ts, s->_nc_x, s->_nc_y);
         }
 
-        // run all the filters for this station
-        for (auto& f : _netcdf_filters)
+        set_nc_station(s, variables, values.data(), 1);
+    }
+
+    return true;
+
+}
+
+bool metdata::next_grib2()
+{
+    if(_current_ts > _end_time)
+    {
+        return false;
+    }
+
+    auto& g = _grib2;
+    size_t t = (_current_ts - g.start).total_seconds() / _dt.total_seconds();
+    size_t nvars = g.variables.size();
+    size_t ncells = g.nx * g.ny;
+    const float* step = g.data + t * nvars * ncells;
+
+    std::vector<double> values(nvars);
+    for (auto& s : _stations)
+    {
+        size_t cell = (s->_nc_y - g.y) * g.nx + (s->_nc_x - g.x);
+        for (size_t v = 0; v < nvars; v++)
+            values[v] = step[v * ncells + cell];
+
+        set_nc_station(s, g.variables, values.data(), 1);
+    }
+
+    return true;
+}
+
+void metdata::set_nc_station(std::shared_ptr<station>& s, const std::vector<std::string>& variables, const double* values,
+                             size_t stride)
+{
+    s->set_posix(_current_ts);
+
+    for (size_t v = 0; v < variables.size(); v++)
+    {
+        (*s)[variables[v]] = values[v * stride];
+    }
+
+    // run all the filters for this station
+    for (auto& f : _netcdf_filters)
+    {
+        f.second->process(s);
+    }
+}
+
+#ifdef USE_MPI
+void metdata::share_grib2(const boost::mpi::communicator& comm)
+{
+    _grib2.share = true;
+    _grib2.node = node_shared::communicator(comm);
+}
+
+void metdata::init_io_aggregation(const boost::mpi::communicator& comm, int ranks_per_aggregator)
+{
+    if(!_use_netcdf)
+        return;
+
+    auto& agg = _io_aggregation;
+
+    if (ranks_per_aggregator <= 0)
+    {
+        agg.group = node_shared::communicator(comm);
+    }
+    else
+    {
+        agg.group = comm.split(comm.rank() / ranks_per_aggregator);
+    }
+
+    auto names = _nc->get_variable_names();
+    agg.variables.assign(names.begin(), names.end());
+    size_t nvars = agg.variables.size();
+
+    // grid index of each of our stations, in the order they are filled
+    size_t xsize = _nc->get_xsize();
+    std::vector<size_t> index;
+    index.reserve(_nstations);
+    for (auto& s : _stations)
+    {
+        if (!s)
+            CHM_THROW_EXCEPTION(forcing_error, "Forcing I/O aggregation requires the NaN stations to be pruned");
+        index.push_back(s->_nc_x + s->_nc_y * xsize);
+    }
+
+    agg.recv.resize(nvars * index.size());
+
+    if (agg.group.rank() != 0)
+    {
+        boost::mpi::gather(agg.group, index, 0);
+
+        // from here on only the aggregator reads the file
+        _nc.reset();
+        agg.enable = true;
+        return;
+    }
+
+    std::vector<std::vector<size_t>> member_index;
+    boost::mpi::gather(agg.group, index, member_index, 0);
+
+    // smallest region of the grid that covers all the group's stations
+    size_t x0 = SIZE_MAX, x1 = 0, y0 = SIZE_MAX, y1 = 0;
+    size_t total = 0;
+    for (auto& m : member_index)
+    {
+        for (auto idx : m)
         {
-            f.second->process(s);
+            x0 = std::min(x0, idx % xsize);
+            x1 = std::max(x1, idx % xsize);
+            y0 = std::min(y0, idx / xsize);
+            y1 = std::max(y1, idx / xsize);
         }
+        total += m.size();
     }
 
-    return true;
+    agg.x = total > 0 ? x0 : 0;
+    agg.y = total > 0 ? y0 : 0;
+    agg.nx = total > 0 ? x1 - x0 + 1 : 0;
+    agg.ny = total > 0 ? y1 - y0 + 1 : 0;
+
+    agg.offsets.resize(member_index.size());
+    agg.counts.resize(member_index.size());
+    agg.displs.resize(member_index.size());
+
+    int displ = 0;
+    for (size_t r = 0; r < member_index.size(); r++)
+    {
+        for (auto idx : member_index[r])
+            agg.offsets[r].push_back((idx / xsize - agg.y) * agg.nx + (idx % xsize - agg.x));
+
+        agg.counts[r] = static_cast<int>(nvars * member_index[r].size());
+        agg.displs[r] = displ;
+        displ += agg.counts[r];
+    }
+    agg.send.resize(displ);
+
+    SPDLOG_INFO("Forcing I/O aggregator for {} ranks, {} stations, reading a {} x {} region of the {} x {} grid",
+                agg.group.size(), total, agg.nx, agg.ny, xsize, _nc->get_ysize());
+
+    agg.enable = true;
+}
+
+void metdata::next_nc_aggregated()
+{
+    auto& agg = _io_aggregation;
+    size_t nvars = agg.variables.size();
+
+    if (agg.group.rank() == 0)
+    {
+        for (size_t v = 0; v < nvars && agg.nx > 0; v++)
+        {
+            auto region = _nc->get_var(agg.variables[v], _current_ts, agg.x, agg.y, agg.nx, agg.ny);
+            const double* values = region.data();
+
+            for (size_t r = 0; r < agg.offsets.size(); r++)
+            {
+                auto& offsets = agg.offsets[r];
+                double* send = agg.send.data() + agg.displs[r] + v * offsets.size();
 
+                for (size_t j = 0; j < offsets.size(); j++)
+                    send[j] = values[offsets[j]];
+            }
+        }
+
+        boost::mpi::scatterv(agg.group, agg.send.data(), agg.counts, agg.displs, agg.recv.data(), static_cast<int>(agg.recv.size()), 0);
+    }
+    else
+    {
+        boost::mpi::scatterv(agg.group, agg.recv.data(), static_cast<int>(agg.recv.size()), 0);
+    }
+
+    for (size_t i = 0; i < _nstations; i++)
+    {
+        set_nc_station(_stations[i], agg.variables, agg.recv.data() + i, _nstations);
+    }
 }
+#endif
 
 std::vector< std::shared_ptr<station> > metdata::get_stations_in_radius(double x, double y, double radius )
 {
@@ -621,6 +1278,74 @@ std::vector< std::shared_ptr<station> > metdata::nearest_station(double x, doubl
 
 }
 
+std::vector< std::shared_ptr<station> > metdata::nearest_station_in_radius(double x, double y, unsigned int N, double radius, unsigned int min_N)
+{
+    Kernel::Point_2 query(x,y);
+    Incremental_search search(_dD_tree, query);
+
+    // the search returns squared distances
+    double radius2 = radius * radius;
+
+    std::vector< std::shared_ptr<station> > stations;
+    stations.reserve(N);
+    for (auto itr = search.begin(); itr != search.end() && stations.size() < N; ++itr)
+    {
+        if (itr->second > radius2 && stations.size() >= min_N)
+            break;
+
+        stations.push_back( boost::get<1>(itr->first));
+    }
+    return stations;
+}
+
+std::vector< std::shared_ptr<station> > metdata::quadrant_stations(double x, double y, unsigned int N, double radius, unsigned int min_N)
+{
+    Kernel::Point_2 query(x,y);
+    Incremental_search search(_dD_tree, query);
+
+    // Without a radius, a quadrant with no stations, e.g., at the edge of the domain, would otherwise walk every
+    // station. So quadrants that are still not full past this multiple of the distance to the 4N-th nearest station,
+    // which is what an unbalanced search would have returned, are left as they are
+    constexpr double max_distance_factor = 3;
+
+    // the search returns squared distances
+    double max_distance2 = radius > 0 ? radius * radius : std::numeric_limits<double>::infinity();
+
+    std::array<unsigned int, 4> count = {0, 0, 0, 0};
+    unsigned int full_quadrants = 0;
+    size_t searched = 0;
+
+    std::vector< std::shared_ptr<station> > stations;
+    stations.reserve(4 * N);
+    for (auto itr = search.begin(); itr != search.end() && full_quadrants < 4; ++itr)
+    {
+        if (++searched == 4 * N)
+            max_distance2 = std::min(max_distance2, max_distance_factor * max_distance_factor * itr->second);
+
+        bool outside = itr->second > max_distance2;
+
+        // everything beyond this point is also outside, so we're done once we have the minimum
+        if (outside && stations.size() >= min_N)
+            break;
+
+        auto& s = boost::get<1>(itr->first);
+        double dx = s->x() - x;
+        double dy = s->y() - y;
+
+        // 0: NE, 1: NW, 2: SW, 3: SE
+        size_t q = dy >= 0 ? (dx >= 0 ? 0 : 1) : (dx < 0 ? 2 : 3);
+
+        // outside we are only topping up to min_N, so ignore the quadrant balancing
+        if (!outside && count[q] >= N)
+            continue;
+
+        stations.push_back(s);
+        if (++count[q] == N)
+            ++full_quadrants;
+    }
+    return stations;
+}
+
 void metdata::prune_stations(std::unordered_set<std::string>& station_ids)
 {
     _stations.erase(
@@ -30,6 +30,7 @@
 #include <CGAL/Fuzzy_sphere.h>
 #include <CGAL/Search_traits_2.h>
 #include <CGAL/Orthogonal_k_neighbor_search.h>
+#include <CGAL/Orthogonal_incremental_neighbor_search.h>
 #include <CGAL/Splitters.h>
 #include <CGAL/Euclidean_distance.h>
 
@@ -38,11 +39,19 @@
 #include <set>
 #include <unordered_set>
 #include <vector>
+#include <array>
 
 //boost includes
 #include <boost/function.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp> // for boost::posix
 
+#ifdef USE_MPI
+#include <boost/mpi.hpp>
+#include <boost/serialization/vector.hpp>
+
+#include "utility/node_shared.hpp"
+#endif
+
 //Gdal includes
 #include <ogr_spatialref.h>
 
@@ -105,6 +114,35 @@ class metdata
     /// @param filters
     void load_from_netcdf(const std::string& path,  const triangulation::bounding_box* box = nullptr, std::map<std::string, boost::shared_ptr<filter_base> > filters = {});
 
+    /// Loads GRIB2 forcing, such as the HRDPS, directly via GDAL. All files must be on the same grid and are
+    /// expected to be one forecast cycle. Only the grid cells within the bounding box are read, and all their
+    /// timesteps are held in memory. Grid cells become stations in the same way as for netcdf, and the same unit
+    /// conversions as the NWP_forcing tools are applied. Times are UTC+0.
+    /// @param path A GRIB2 file, or a directory of .grib2/.grb2 files
+    /// @param box
+    /// @param filters
+    /// @param variables CHM variable name -> "ELEMENT:LEVEL" of the GRIB2 messages, e.g., t -> TMP:2-HTGL. Overrides
+    /// the HRDPS defaults. "elevation" sets the surface height field.
+    void load_from_grib2(const std::string& path, const triangulation::bounding_box* box = nullptr,
+                         std::map<std::string, boost::shared_ptr<filter_base> > filters = {},
+                         std::map<std::string, std::string> variables = {});
+
+    /// The first GRIB2 timestep that is known for these variables, where forcing starts. This is 1 if any are
+    /// accumulated, as then the first timestep cannot be differenced, otherwise 0.
+    /// @param variables CHM variable names
+    static size_t grib2_first_timestep(const std::vector<std::string>& variables);
+
+    /// Applies the GRIB2 unit conversions to values as read by load_from_grib2, and sets missing (NaN) values from
+    /// grib2_first_timestep onwards to -9999.
+    /// @param values [time][variable][cell], ntimes * variables.size() * ncells values
+    /// @param variables CHM variable names, in the order they are stored
+    /// @param ntimes
+    /// @param ncells
+    /// @param dt Timestep in seconds
+    /// @return Number of missing values
+    static size_t convert_grib2(float* values, const std::vector<std::string>& variables, size_t ntimes, size_t ncells,
+                                time_t dt);
+
     /// Loads the standard ascii timeseries. Needs to be in UTC+0
     /// @param path
     /// @param filters
@@ -131,6 +169,34 @@ class metdata
      */
     std::vector< std::shared_ptr<station> > nearest_station(double x, double y,unsigned int N=1);
 
+    /**
+     * Returns up to the N nearest stations to x,y that are within the search radius (meters).
+     * In sparse regions where fewer than min_N stations lie within the radius, the min_N nearest stations are returned
+     * regardless of distance so that interpolants always have enough support.
+     * @param x
+     * @param y
+     * @param N Maximum number of stations to return
+     * @param radius Search radius (meters)
+     * @param min_N Minimum number of stations to return, ignoring the radius if required
+     * @return
+     */
+    std::vector< std::shared_ptr<station> > nearest_station_in_radius(double x, double y, unsigned int N, double radius, unsigned int min_N=1);
+
+    /**
+     * Returns up to N stations from each of the four quadrants (NE, NW, SW, SE) centered on x,y, nearest first. This
+     * avoids an interpolant being dominated by a cluster of stations on one side of the point. Stations farther than
+     * 3 times the distance to the 4N-th nearest station are not considered, nor if radius > 0 those farther than the
+     * radius, so a quadrant can have fewer than N. If this results in fewer than min_N stations, the nearest stations
+     * are used to make up the difference.
+     * @param x
+     * @param y
+     * @param N Maximum number of stations per quadrant
+     * @param radius Search radius (meters). Values <= 0 disable the radius.
+     * @param min_N Minimum number of stations to return, ignoring the radius if required
+     * @return
+     */
+    std::vector< std::shared_ptr<station> > quadrant_stations(double x, double y, unsigned int N, double radius=-1, unsigned int min_N=1);
+
     /// Return a list of stations for a point x,y corresponding to a search radius, or nearest station
     boost::function< std::vector< std::shared_ptr<station> > ( double, double) > get_stations;
 
@@ -158,6 +224,12 @@ class metdata
      */
     bool is_netcdf();
 
+    /**
+     * True if GRIB2 files were loaded
+     * @return
+     */
+    bool is_grib2();
+
     /// Subsets all timeseries to begin at [start, end]. For ascii, the underlying timeseries is modified.
     /// For nc, internal offsets are computed to start, end.
     /// This updates the internal start and end times, as well as resets the current time to be = start
@@ -182,10 +254,33 @@ class metdata
     /// @return False if no more timesteps
     bool next();
 
+    /// Advances to the next timestep without reading or filtering any forcing, for when nothing reads the stations,
+    /// e.g., replaying cached interpolated forcing. Must not be mixed with next() during a run.
+    /// @return False if no more timesteps
+    bool next_time_only();
+
     /// Removes a subset of stations from the  station list
     /// @param stations The set of station IDs to remove
     void prune_stations(std::unordered_set<std::string>& station_ids);
 
+#ifdef USE_MPI
+    /// Switches netcdf forcing to aggregated reads. The ranks are split into groups, and the first rank of each
+    /// group reads the region of the forcing grid that covers its group's stations, one read per variable per
+    /// timestep, and scatters each rank its stations' values. The other ranks do not read the forcing file after this.
+    /// Collective over comm. Must be called once the stations have been pruned to those each rank needs.
+    /// @param comm
+    /// @param ranks_per_aggregator Number of ranks per group, 0 for one group per shared memory node
+    void init_io_aggregation(const boost::mpi::communicator& comm, int ranks_per_aggregator);
+
+    /// Makes load_from_grib2 hold the forcing values once per shared memory node instead of once per rank. The
+    /// node's first rank reads and converts them, and the other ranks map the same memory. As every rank reads the
+    /// region covering the whole mesh, this divides the largest forcing allocation by the number of ranks per node.
+    /// Collective over comm, and load_from_grib2 and the destructor then become collective over each node. The
+    /// destructor must run before MPI is finalized.
+    /// @param comm
+    void share_grib2(const boost::mpi::communicator& comm);
+#endif
+
     /**
     * List all (including module provided) variables. If ascii files are loaded, this includes variables present in one 1 met file.
     * \return set containing a list of variable names
@@ -211,6 +306,67 @@ class metdata
     /// Advances 1 timestep in the netcdf files
     bool next_nc();
 
+    /// Copies the filters that are run on every gridded (netcdf or GRIB2) station each timestep
+    void set_grid_filters(std::map<std::string, boost::shared_ptr<filter_base> >& filters);
+
+    /// Advances 1 timestep in the GRIB2 data
+    bool next_grib2();
+
+    struct
+    {
+        bool enable = false;
+
+        // CHM variable names, in the order they are stored
+        std::vector<std::string> variables;
+
+        // region of the grid that was read
+        size_t x, y, nx, ny;
+
+        // time of the first stored timestep
+        boost::posix_time::ptime start;
+
+        // [time][variable][cell of the region], points to values or shared
+        const float* data = nullptr;
+        std::vector<float> values;
+
+#ifdef USE_MPI
+        // set by share_grib2
+        bool share = false;
+        boost::mpi::communicator node;
+        node_shared::array<float> shared;
+#endif
+    } _grib2;
+
+    /// Sets a station's values for the current timestep and runs the netcdf filters on it
+    void set_nc_station(std::shared_ptr<station>& s, const std::vector<std::string>& variables, const double* values,
+                        size_t stride);
+
+#ifdef USE_MPI
+    /// Advances 1 timestep in the netcdf files, via the I/O aggregator
+    void next_nc_aggregated();
+
+    struct
+    {
+        bool enable = false;
+
+        // this rank's aggregation group, its rank 0 reads the forcing
+        boost::mpi::communicator group;
+
+        // netcdf variables, in the order they are sent
+        std::vector<std::string> variables;
+
+        // this rank's values for the timestep, [variable][station]
+        std::vector<double> recv;
+
+        // aggregator only: region of the grid read, and per group rank, the offset of each station in that region
+        size_t x, y, nx, ny;
+        std::vector<std::vector<size_t>> offsets;
+        std::vector<int> counts;
+        std::vector<int> displs;
+        std::vector<double> send;
+    } _io_aggregation;
+#endif
+
 
     /// Advances 1 timestep from the ascii timeseries
     /// @return
@@ -226,7 +382,7 @@ class metdata
         //if we use netcdf, store it here
         std::unique_ptr<netcdf> _nc;
 
-        //if we use netcdf, we need to save the filters and run it once every timestep.
+        //if we use netcdf or GRIB2, we need to save the filters and run it once every timestep.
         std::map<std::string, boost::shared_ptr<filter_base>>_netcdf_filters;
 
         std::set<std::string> _provides_from_nc_filters;
@@ -294,6 +450,13 @@ class metdata
         typename CGAL::internal::Spatial_searching_default_distance<Traits>::type,
         Splitter > Neighbor_search;
 
+    // Used by nearest_station_in_radius and quadrant_stations to walk stations in order of increasing distance
+    typedef CGAL::Orthogonal_incremental_neighbor_search <
+        Traits,
+        typename CGAL::internal::Spatial_searching_default_distance<Traits>::type,
+        Splitter,
+        Tree > Incremental_search;
+
     Tree _dD_tree; //spatial query tree
 
 
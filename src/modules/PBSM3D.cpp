@@ -100,6 +100,199 @@ double my_fill_topo3(double x, void* p)
     return -fac_fill * x * gsl_ran_gaussian_pdf(x - m_tpi, s_tpi);
 }
 
+// Coefficients of the filling function that gives normalized snow depth as a function of TPI.
+// These are constant over snow depth, which is what allows the normalization factor to be computed once per face.
+const double subgrid_a1 = 1.5;
+const double subgrid_b1 = 0.3;
+const double subgrid_a2 = 0.6;
+const double subgrid_b2 = 0.55;
+
+// Areas with negative TPI are assumed to be filled when SD = fac_fill * TPI.
+const double subgrid_fac_fill = 0.8;
+
+double PBSM3D::subgrid_topo_V2_norm(double moy_tpi, double std_tpi, int& status)
+{
+    struct my_fill_topo_params params = {subgrid_a1, subgrid_b1, subgrid_a2, subgrid_b2, moy_tpi, std_tpi};
+    gsl_function F_fill;
+    F_fill.function = &my_fill_topo;
+    F_fill.params = &params;
+
+    gsl_integration_workspace* w = gsl_integration_workspace_alloc(1000);
+    double result, error;
+    status = gsl_integration_qags(&F_fill, -50, 50, 0, 1e-7, 1000, w, &result, &error);
+    gsl_integration_workspace_free(w);
+
+    return result;
+}
+
+int PBSM3D::subgrid_topo_V2_holding(double snow_depth, double norm, double moy_tpi, double std_tpi,
+                                    double& tpi_lim, double& hold, double& frac_contrib)
+{
+    boost::uintmax_t max_iter = 500;
+    auto tol = [](double a, double b) -> bool { return fabs(a - b) < 1e-8; };
+
+    // Default values for the TPI threshold above which gullies are filled.
+    tpi_lim = -min_sd_trans;
+
+    // Determine TPI threshold above which gullies are considered as filled.
+    auto frootFn = [&](double xx) -> double {
+        return (1 - subgrid_a1 * tanh(subgrid_b1 * (xx + 0.25))) * snow_depth / norm + subgrid_fac_fill * xx;
+    };
+    try
+    {
+        auto r = boost::math::tools::bracket_and_solve_root(frootFn, -1.0, 1.0, true, tol, max_iter);
+        tpi_lim = r.first + (r.second - r.first) / 2.0;
+    }
+    catch (...)
+    {
+        // Didn't converge
+    }
+
+    double error;
+
+    // Determine area-averaged snow depth which is stored in the non-filled gullies
+    struct my_fill_topo2_params params2 = {subgrid_a1, subgrid_b1, subgrid_a2, subgrid_b2, moy_tpi, std_tpi, snow_depth, norm};
+    gsl_function F_fill2;
+    F_fill2.function = &my_fill_topo2;
+    F_fill2.params = &params2;
+
+    gsl_integration_workspace* w2 = gsl_integration_workspace_alloc(1000);
+    double h1;
+    int status = gsl_integration_qags(&F_fill2, -50, tpi_lim, 0, 1e-7, 1000, w2, &h1, &error);
+    gsl_integration_workspace_free(w2);
+
+    // Determine area-averaged snow depth which is stored in the filled gullies
+    struct my_fill_topo3_params params3 = {moy_tpi, std_tpi, subgrid_fac_fill};
+    gsl_function F_fill3;
+    F_fill3.function = &my_fill_topo3;
+    F_fill3.params = &params3;
+
+    gsl_integration_workspace* w3 = gsl_integration_workspace_alloc(1000);
+    double h2;
+    int status3 = gsl_integration_qags(&F_fill3, tpi_lim, -min_sd_trans / subgrid_fac_fill, 0, 1e-7, 1000,
+                                       w3, &h2, &error);
+    gsl_integration_workspace_free(w3);
+
+    // With the GSL error handler off, a failed integration still returns its best estimate, so only report it
+    if (status == GSL_SUCCESS)
+        status = status3;
+
+    // Determine area-averaged snow depth hold in the area of positive TPI
+    double h3 = min_sd_trans * gsl_cdf_gaussian_Q(-min_sd_trans / subgrid_fac_fill - moy_tpi, std_tpi);
+
+    // Total holding capacity, not yet limited by the snow depth
+    hold = h1 + h2 + h3;
+
+    // Fraction of the triangle that contributes to snow transport
+    frac_contrib = gsl_cdf_gaussian_Q(tpi_lim - moy_tpi, std_tpi);
+
+    return status;
+}
+
+void PBSM3D::build_subgrid_topo_table(subgrid_topo_table& tbl)
+{
+    tbl.nfailed = 0;
+
+    int status = GSL_SUCCESS;
+    tbl.norm = subgrid_topo_V2_norm(tbl.moy_tpi, tbl.std_tpi, status);
+    if (status != GSL_SUCCESS)
+        ++tbl.nfailed;
+    tbl.frac_contrib_no_hold = gsl_cdf_gaussian_Q(-min_sd_trans - tbl.moy_tpi, tbl.std_tpi);
+
+    tbl.sd0 = min_sd_trans;
+    tbl.sd_max = std::max(subgrid_table_max_sd, min_sd_trans + subgrid_table_dsd);
+
+    size_t n = static_cast<size_t>(std::ceil((tbl.sd_max - tbl.sd0) / subgrid_table_dsd)) + 1;
+    tbl.dsd = (tbl.sd_max - tbl.sd0) / (n - 1);
+
+    tbl.tpi_lim.resize(n);
+    tbl.hold.resize(n);
+    tbl.frac_contrib.resize(n);
+
+    for (size_t k = 0; k < n; ++k)
+    {
+        if (subgrid_topo_V2_holding(tbl.sd0 + k * tbl.dsd, tbl.norm, tbl.moy_tpi, tbl.std_tpi,
+                                    tbl.tpi_lim[k], tbl.hold[k], tbl.frac_contrib[k]) != GSL_SUCCESS)
+            ++tbl.nfailed;
+    }
+
+    // Evaluate the exact solution at the midpoints of the current table. If linear interpolation is within the tolerance
+    // the current table is kept, otherwise the midpoints are merged in and the check is repeated on the finer table.
+    // After max_refine refinements the table is kept as is, with the error of the last check.
+    const int max_refine = 6;
+    tbl.converged = false;
+    for (int level = 0; level <= max_refine; ++level)
+    {
+        size_t m = tbl.hold.size() - 1;
+        std::vector<double> mid_tpi_lim(m), mid_hold(m), mid_frac(m);
+
+        double max_err = 0;
+        for (size_t k = 0; k < m; ++k)
+        {
+            if (subgrid_topo_V2_holding(tbl.sd0 + (k + 0.5) * tbl.dsd, tbl.norm, tbl.moy_tpi, tbl.std_tpi,
+                                        mid_tpi_lim[k], mid_hold[k], mid_frac[k]) != GSL_SUCCESS)
+                ++tbl.nfailed;
+
+            max_err = std::max(max_err, std::fabs(0.5 * (tbl.hold[k] + tbl.hold[k + 1]) - mid_hold[k]));
+            max_err = std::max(max_err, std::fabs(0.5 * (tbl.tpi_lim[k] + tbl.tpi_lim[k + 1]) - mid_tpi_lim[k]));
+            max_err = std::max(max_err, std::fabs(0.5 * (tbl.frac_contrib[k] + tbl.frac_contrib[k + 1]) - mid_frac[k]));
+        }
+
+        tbl.max_err = max_err;
+        if (max_err <= subgrid_table_tol)
+        {
+            tbl.converged = true;
+            break;
+        }
+        if (level == max_refine)
+            break;
+
+        auto merge = [m](std::vector<double>& nodes, const std::vector<double>& mid)
+        {
+            std::vector<double> merged(2 * m + 1);
+            for (size_t k = 0; k < m; ++k)
+            {
+                merged[2 * k] = nodes[k];
+                merged[2 * k + 1] = mid[k];
+            }
+            merged[2 * m] = nodes[m];
+            nodes.swap(merged);
+        };
+
+        merge(tbl.tpi_lim, mid_tpi_lim);
+        merge(tbl.hold, mid_hold);
+        merge(tbl.frac_contrib, mid_frac);
+        tbl.dsd /= 2.0;
+    }
+}
+
+bool PBSM3D::subgrid_topo_table::lookup(double snow_depth, double& tpi_lim_out, double& hold_out,
+                                        double& frac_contrib_out) const
+{
+    if (snow_depth < sd0 || snow_depth >= sd_max)
+        return false;
+
+    double pos = (snow_depth - sd0) / dsd;
+    size_t k = std::min(static_cast<size_t>(pos), hold.size() - 2);
+    double w = pos - k;
+
+    tpi_lim_out = tpi_lim[k] + w * (tpi_lim[k + 1] - tpi_lim[k]);
+    hold_out = hold[k] + w * (hold[k + 1] - hold[k]);
+    frac_contrib_out = frac_contrib[k] + w * (frac_contrib[k + 1] - frac_contrib[k]);
+
+    return true;
+}
+
+double PBSM3D::wind_10m(double uref, double snow_depth)
+{
+    double z10 = 10. + snow_depth; // 10-m height above the snow surface
+
+    if (z10 < Atmosphere::Z_U_R)
+        return Atmosphere::log_scale_wind(uref, Atmosphere::Z_U_R, z10, snow_depth);
+
+    return uref; // Extreme case (avalanche gone crazy case)
+}
+
 PBSM3D::PBSM3D(config_file cfg) : module_base("PBSM3D", parallel::domain, cfg)
 {
     depends("U_2m_above_srf");
@@ -164,7 +357,18 @@ PBSM3D::PBSM3D(config_file cfg) : module_base("PBSM3D", parallel::domain, cfg)
         provides("is_drifting");
         provides("Km_coeff");
         provides("Qsusp_pbsm");
-        provides("height_diff");
+
+        // height difference between snowcover and veg
+        provides_diagnostic("height_diff",
+                            [this](mesh_elem& face)
+                            {
+                                if (!enable_veg)
+                                    return 0.0;
+
+                                // snowdepthavg may have been updated by a later module, so use the depth run() used
+                                auto& d = face->get_module_data<data>(ID);
+                                return std::max(0.0, d.CanopyHeight - d.snow_depth);
+                            });
         provides("suspension_mass");
         provides("saltation_mass");
         //        provides("Ti");
@@ -176,7 +380,11 @@ PBSM3D::PBSM3D(config_file cfg) : module_base("PBSM3D", parallel::domain, cfg)
         provides("z0");
         provides("lambda");
 
-        provides("U_10m");
+        provides_diagnostic("U_10m",
+                            [this](mesh_elem& face)
+                            {
+                                return face->get_module_data<data>(ID).u10;
+                            });
 
         provides("csalt");
         provides("csalt_orig");
@@ -257,6 +465,22 @@ void PBSM3D::init(mesh& domain)
 
     iterative_subl = cfg.get("iterative_subl", false);
 
+    // Lookup tables for the sub-grid topography holding capacity over snow depth
+    subgrid_table_max_sd = cfg.get("subgrid_table_max_sd", 5.0);
+    subgrid_table_dsd = cfg.get("subgrid_table_dsd", 0.05);
+    subgrid_table_tol = cfg.get("subgrid_table_tol", 1e-4);
+    subgrid_table_dtpi = cfg.get("subgrid_table_dtpi", 0.0);
+
+    if (subgrid_table_dsd <= 0)
+    {
+        CHM_THROW_EXCEPTION(module_error, "PBSM3D subgrid_table_dsd must be positive");
+    }
+
+    if (subgrid_table_dtpi < 0)
+    {
+        CHM_THROW_EXCEPTION(module_error, "PBSM3D subgrid_table_dtpi must be positive or 0");
+    }
+
     if (rouault_diffusion_coeff)
     {
         SPDLOG_WARN( "rouault_diffusion_coef overrides const snow_diffusion_const values.");
@@ -269,6 +493,10 @@ void PBSM3D::init(mesh& domain)
 
     SPDLOG_DEBUG("#face={}",ntri);
 
+    // TPI class of each face, used to share the sub-grid topography tables between faces
+    std::vector<std::pair<double, double>> tpi_class(ntri);
+    std::vector<char> has_tpi(ntri, 0);
+
     // **************************************************************
     // **************************************************************
     // TODO can this loop be combined with the trilinos GrsGraph creations?
@@ -323,12 +551,23 @@ void PBSM3D::init(mesh& domain)
             enable_veg = false;
         }
 
-        d.F_fill.function = &my_fill_topo;
-        d.F_fill2.function = &my_fill_topo2;
-        d.F_fill3.function = &my_fill_topo3;
+        // The TPI distribution is static, so the holding capacity only varies with snow depth. It is tabulated after
+        // this loop, once per TPI class instead of once per face.
+        d.subgrid_topo = nullptr;
+        if (use_subgrid_topo_V2 && !is_nan(face->parameter("TPI_std"_s)))
+        {
+            double moy_tpi = std::max(-5.0, std::min(5.0, face->parameter("TPI_mean"_s)));
+            double std_tpi = std::min(5.0, std::max(0.1, face->parameter("TPI_std"_s)));
 
-        // pre alloc for the windpseeds
-        d.u_z_susp.resize(nLayer);
+            // Without quantization only faces with identical TPI distributions share a table
+            if (subgrid_table_dtpi > 0)
+            {
+                moy_tpi = std::round(moy_tpi / subgrid_table_dtpi) * subgrid_table_dtpi;
+                std_tpi = std::max(0.1, std::round(std_tpi / subgrid_table_dtpi) * subgrid_table_dtpi);
+            }
+            tpi_class[i] = {moy_tpi, std_tpi};
+            has_tpi[i] = 1;
+        }
 
         auto& m = d.m;
         // edge unit normals
@@ -387,11 +626,88 @@ void PBSM3D::init(mesh& domain)
 
         d.sum_drift = 0;
         d.sum_subl = 0;
-        d.csubl.resize(nLayer);
+        d.snow_depth = 0;
+        d.u10 = 0;
         (*face)["sum_drift"_s]=0;
 
     }
 
+    if (use_subgrid_topo_V2)
+    {
+        // One table per TPI class, built in parallel and then shared by all the faces of that class
+        std::map<std::pair<double, double>, size_t> class_index;
+        for (size_t i = 0; i < ntri; i++)
+        {
+            if (has_tpi[i])
+                class_index.emplace(tpi_class[i], class_index.size());
+        }
+
+        _subgrid_tables.clear();
+        _subgrid_tables.resize(class_index.size());
+        for (auto& itr : class_index)
+        {
+            _subgrid_tables[itr.second].moy_tpi = itr.first.first;
+            _subgrid_tables[itr.second].std_tpi = itr.first.second;
+        }
+
+#pragma omp parallel for schedule(dynamic)
+        for (size_t t = 0; t < _subgrid_tables.size(); t++)
+        {
+            build_subgrid_topo_table(_subgrid_tables[t]);
+        }
+
+        size_t nfailed = 0;
+        size_t nentries = 0;
+        size_t nunconverged = 0;
+        double max_err = 0;
+        for (auto& tbl : _subgrid_tables)
+        {
+            nfailed += tbl.nfailed;
+            nentries += tbl.hold.size();
+            if (!tbl.converged)
+            {
+                ++nunconverged;
+                max_err = std::max(max_err, tbl.max_err);
+            }
+        }
+        if (nfailed > 0)
+        {
+            SPDLOG_WARN("PBSM3D: {} sub-grid topography integrations did not reach the requested accuracy", nfailed);
+        }
+        if (nunconverged > 0)
+        {
+            SPDLOG_WARN("PBSM3D: {} of {} sub-grid topography tables did not reach subgrid_table_tol={} after refining, "
+                        "largest interpolation error {}", nunconverged, _subgrid_tables.size(), subgrid_table_tol, max_err);
+        }
+
+        // _subgrid_tables is not resized after this, so the pointers stay valid
+        size_t nfaces = 0;
+        for (size_t i = 0; i < ntri; i++)
+        {
+            if (!has_tpi[i])
+                continue;
+
+            auto& d = domain->face(i)->get_module_data<data>(ID);
+            d.subgrid_topo = &_subgrid_tables[class_index[tpi_class[i]]];
+            ++nfaces;
+        }
+
+        SPDLOG_DEBUG("PBSM3D: {} sub-grid topography tables ({} entries) shared by {} faces", _subgrid_tables.size(),
+                     nentries, nfaces);
+    }
+
+    _profile_settings.nLayer = nLayer;
+    _profile_settings.v_edge_height = v_edge_height;
+    _profile_settings.l__max = l__max;
+    _profile_settings.snow_diffusion_const = snow_diffusion_const;
+    _profile_settings.rouault_diffusion_coeff = rouault_diffusion_coeff;
+    _profile_settings.do_fixed_settling = do_fixed_settling;
+    _profile_settings.settling_velocity = settling_velocity;
+    _profile_settings.do_sublimation = do_sublimation;
+    _profile_settings.iterative_subl = iterative_subl;
+
+    _profile.resize(ntri, nLayer, debug_output);
+
     suspension_NNP.reset(new math::LinearAlgebra::NearestNeighborProblem(domain,nLayer));
     deposition_NNP.reset(new math::LinearAlgebra::NearestNeighborProblem(domain));
 
@@ -406,6 +722,9 @@ void PBSM3D::run(mesh& domain)
     size_t ntri = domain->size_faces();
     size_t n_global_tri = domain->size_global_faces();
 
+    // neighbour ids and geometry for the linear systems
+    const auto& cmesh = domain->compact();
+
     suspension_NNP->zeroSystem();
     deposition_NNP->zeroSystem();
 
@@ -419,23 +738,22 @@ void PBSM3D::run(mesh& domain)
         // Helpers for the u* iterative solver
         // - needs to be here in thread pool, otherwise there are thread consistency
         // issues with the solver
-        boost::uintmax_t max_iter = 500;
         auto tol = [](double a, double b) -> bool { return fabs(a - b) < 1e-8; };
 
-        // ice density
-        double rho_p = PhysConst::rho_ice;
+        // thread local buffers for the batched u* solve
+        std::vector<size_t> solve_idx;
+        std::vector<double> solve_u2, solve_lambda, solve_ustar;
+        std::vector<char> solve_converged;
+
+        ////////////////////////////////////////////////////////////////////////////
+        // Surface conditions and u* setup
+        ////////////////////////////////////////////////////////////////////////////
 #pragma omp for
-        for (size_t i = 0; i < domain->size_faces(); i++)
+        for (size_t i = 0; i < ntri; i++)
         {
-
             auto face = domain->face(i);
 
             auto& d = face->get_module_data<data>(ID);
-            auto& m = d.m;
-
-            double fetch = 1000;
-            if (use_exp_fetch || use_tanh_fetch)
-                fetch = (*face)["fetch"_s];
 
             double frac_contrib = 1.;       // Default value for the fraction of the grid contributing to snow transport
             double frac_contrib_nosnw = 1.; // Default value for the fraction of the grid contributing to snow transport
@@ -445,36 +763,17 @@ void PBSM3D::run(mesh& domain)
             double uref = (*face)["U_R"_s];
             double snow_depth = (*face)["snowdepthavg"_s];
             snow_depth = is_nan(snow_depth) ? 0 : snow_depth;
+            d.snow_depth = snow_depth;
 
             double u2 = (*face)["U_2m_above_srf"_s];
-            double z10; // 10-m height above the snow surface
-            z10 = 10. + snow_depth;
-
-            double u10;
-            if (z10 < Atmosphere::Z_U_R)
-            {
-                // u10 is used by the pom probability forumuation, so don't hide behide debug output
-                u10 = Atmosphere::log_scale_wind(uref, Atmosphere::Z_U_R, z10,
-                        snow_depth);
-            }
-            else
-            {
-                u10 = uref; // Extreme case (avalanche gone crazy case)
-            }
 
-            if (debug_output)
-                (*face)["U_10m"_s] = u10;
-
-            double swe = (*face)["swe"_s]; // mm   -->    kg/m^2
-            swe = is_nan(swe) ? 0 : swe;   // handle the first timestep where swe won't have been
-            // updated if we override the module order
+            // u10 is used by the pom probability forumuation, so don't hide behide debug output
+            double u10 = wind_10m(uref, snow_depth);
 
             // height difference between snowcover and veg
             double height_diff = std::max(0.0, d.CanopyHeight - snow_depth);
             if (!enable_veg)
                 height_diff = 0;
-            if (debug_output)
-                (*face)["height_diff"_s] = height_diff;
 
             // Topographic holding capacity associated with subgrid topographic features
             // This method combines the distribution of TPI with a filling function to obtain
@@ -485,111 +784,36 @@ void PBSM3D::run(mesh& domain)
 
             if (use_subgrid_topo_V2)
             {
-                // Areas with negative TPI are assumed to be filled when SD = fac_fill * TPI.
-                double fac_fill = 0.8;
-
                 // Default values for the TPI threshold above which gullies are filled.
                 double tpi_lim = -min_sd_trans;
 
-                if (!is_nan(face->parameter("TPI_std"_s)))
+                if (d.subgrid_topo)
                 { // Std value of TPI is defined
-
-                    double moy_tpi = std::max(-5.0, std::min(5.0, face->parameter("TPI_mean"_s)));
-                    double std_tpi = std::min(5.0, std::max(0.1, face->parameter("TPI_std"_s)));
+                    const auto& tbl = *d.subgrid_topo;
 
                     if (snow_depth > min_sd_trans)
                     {
+                        (*face)["test_int"_s] = tbl.norm;
 
-                        // Coefficient for the filling function that give normalized snow depth as a function of TPI
-
-                        double a1 = 1.5;
-                        double b1 = 0.3;
-                        double a2 = 0.6;
-                        double b2 = 0.55;
-                        if (snow_depth > 0.75 and snow_depth < 1.25)
+                        double hold = 0;
+                        if (!tbl.lookup(snow_depth, tpi_lim, hold, frac_contrib))
                         {
-                            double a1 = 1.15;
+                            // Outside of the tabulated range, fall back to the full integration
+                            if (subgrid_topo_V2_holding(snow_depth, tbl.norm, tbl.moy_tpi, tbl.std_tpi, tpi_lim, hold,
+                                                        frac_contrib) != GSL_SUCCESS)
+                            {
+                                SPDLOG_DEBUG("PBSM3D: sub-grid topography integration did not reach the requested "
+                                             "accuracy for snow depth {}", snow_depth);
+                            }
                         }
-                        else if (snow_depth < 1.75)
-                        {
-                            double a1 = 1.1;
-                            double b2 = 0.4;
-                        }
-                        else if (snow_depth < 2.25)
-                        {
-                            double a1 = 0.9;
-                            double b2 = 0.4;
-                        }
-                        else if (snow_depth < 2.75)
-                        {
-                            double a1 = 0.85;
-                            double b2 = 0.4;
-                        }
-                        else if (snow_depth < 3.25)
-                        {
-                            double a1 = 0.75;
-                            double b2 = 0.4;
-                        }
-                        else
-                        {
-                            double a1 = 0.6;
-                            double b2 = 0.35;
-                        }
-
-                        // Compute normalization factor
-                        struct my_fill_topo_params params = {a1, b1, a2, b2, moy_tpi, std_tpi};
-                        d.F_fill.params = &params;
-
-                        gsl_integration_workspace* w = gsl_integration_workspace_alloc(1000);
-                        double result, error;
-                        int code = gsl_integration_qags(&d.F_fill, -50, 50, 0, 1e-7, 1000, w, &result, &error);
-                        gsl_integration_workspace_free(w);
-
-                        (*face)["test_int"_s] = result;
-
-                        // Determine TPI threshold above which gullies are considered as filled.
-                        auto frootFn = [&](double xx) -> double {
-                            return (1 - a1 * tanh(b1 * (xx + 0.25))) * snow_depth / result + fac_fill * xx;
-                        };
-                        try
-                        {
-                            auto r =
-                                boost::math::tools::bracket_and_solve_root(frootFn, -1.0, 1.0, true, tol, max_iter);
-                            tpi_lim = r.first + (r.second - r.first) / 2.0;
-                        }
-                        catch (...)
-                        {
-                            // Didn't converge
-                        }
-
-                        // Determine area-averaged snow depth which is stored in the non-filled gullies
-                        struct my_fill_topo2_params params2 = {a1, b1, a2, b2, moy_tpi, std_tpi, snow_depth, result};
-                        d.F_fill2.params = &params2;
-
-                        gsl_integration_workspace* w2 = gsl_integration_workspace_alloc(1000);
-                        double h1;
-                        int code2 = gsl_integration_qags(&d.F_fill2, -50, tpi_lim, 0, 1e-7, 1000, w2, &h1, &error);
-                        gsl_integration_workspace_free(w2);
-
-                        // Determine area-averaged snow depth which is stored in the filled gullies
-                        struct my_fill_topo3_params params3 = {moy_tpi, std_tpi, fac_fill};
-                        d.F_fill3.params = &params3;
-
-                        gsl_integration_workspace* w3 = gsl_integration_workspace_alloc(1000);
-                        double h2;
-                        int code3 = gsl_integration_qags(&d.F_fill3, tpi_lim, -min_sd_trans / fac_fill, 0, 1e-7, 1000,
-                                w3, &h2, &error);
-                        gsl_integration_workspace_free(w3);
-
-                        // Determine area-averaged snow depth hold in the area of positive TPI
-                        double h3 = min_sd_trans * gsl_cdf_gaussian_Q(-min_sd_trans / fac_fill - moy_tpi, std_tpi);
 
                         // Compute total holding capacity
-                        min_sd_trans_avg = std::min(h1 + h2 + h3, snow_depth);
+                        min_sd_trans_avg = std::min(hold, snow_depth);
+                    }
+                    else
+                    {
+                        frac_contrib = tbl.frac_contrib_no_hold;
                     }
-
-                    // Determine fraction of the triangle that contributes to snow transport
-                    frac_contrib = gsl_cdf_gaussian_Q(tpi_lim - moy_tpi, std_tpi);
                 }
                 (*face)["tpi_lim"_s] = tpi_lim;
                 (*face)["frac_contrib"_s] = frac_contrib;
@@ -663,6 +887,8 @@ void PBSM3D::run(mesh& domain)
             double lambda = 0;
 
             d.saltation = false; // default case
+            d.try_saltation = false;
+            d.solve_ustar = false;
 
             // threshold friction velocity. Compute here as it's used below as well
             // Pomeroy and Li, 2000
@@ -688,59 +914,138 @@ void PBSM3D::run(mesh& domain)
                 if (debug_output)
                     (*face)["lambda"_s] = lambda;
 
+                d.try_saltation = true;
+
                 if (z0_ustar_coupling)
                 {
                     // Calculate the new value of z0 to take into account partially filled
-                    // vegetation and the momentum sink
-                    auto ustarFn = [&](double ustar) -> double {
-                        // Li and Pomeroy 2000, eqn 5.
-                        // This formulation has the following coeffs built in
-                        // c_2 = 1.6;
-                        // c_3 = 0.07519;
-                        // c_4 = 0.5;
-                        // g   = 9.81;
-
-                        return u2 * PhysConst::kappa / log(2.0 / (0.6131702345e-2 * ustar * ustar + .5 * lambda)) -
-                            ustar;
-                    };
-                    try
-                    {
-                        auto r = boost::math::tools::bracket_and_solve_root(ustarFn, 1.0, 1.0, false, tol, max_iter);
-                        ustar = r.first + (r.second - r.first) / 2.0;
-                    }
-                    catch (...)
-                    {
-                        // Didn't converge
-                        d.saltation = false;
-                    }
+                    // vegetation and the momentum sink. This is solved below for blocks of faces at once.
+                    d.solve_ustar = true;
                 }
                 else
                 {
                     // follow PBSM (Pom & Li 2000; Alpine3D) and don't calculate the feedback of z0 on u*
                     ustar = u2 * PhysConst::kappa / log(2.0 / 0.0002);
                 }
+            }
+
+            d.lambda = lambda;
+            d.u10 = u10;
+            d.frac_contrib = frac_contrib;
+
+            _profile.ustar[i] = ustar;
+            _profile.snow_depth[i] = snow_depth;
+            _profile.height_diff[i] = height_diff;
+            _profile.uref[i] = uref;
+            _profile.T[i] = T;
+            _profile.u_th[i] = u_star_saltation_threshold;
+        }
+
+        ////////////////////////////////////////////////////////////////////////////
+        // Coupled u* and z0, Li and Pomeroy 2000 eqn 5
+        // Newton's method is run for a block of faces at once so it vectorizes, with the
+        // bracketing solver used for any face that doesn't converge
+        ////////////////////////////////////////////////////////////////////////////
+        if (z0_ustar_coupling)
+        {
+#pragma omp for schedule(static)
+            for (size_t b = 0; b < ntri; b += ustar_block_size)
+            {
+                size_t end = std::min(ntri, b + ustar_block_size);
+
+                solve_idx.clear();
+                solve_u2.clear();
+                solve_lambda.clear();
 
-                if (ustar >= u_star_saltation_threshold)
+                for (size_t i = b; i < end; i++)
                 {
-                    d.saltation = true;
+                    auto face = domain->face(i);
+                    auto& d = face->get_module_data<data>(ID);
+
+                    if (!d.solve_ustar)
+                        continue;
+
+                    solve_idx.push_back(i);
+                    solve_u2.push_back((*face)["U_2m_above_srf"_s]);
+                    solve_lambda.push_back(d.lambda);
+                }
 
-                    if (z0_ustar_coupling)
+                size_t n = solve_idx.size();
+                solve_ustar.resize(n);
+                solve_converged.resize(n);
+
+                pbsm3d::solve_ustar_coupled(n, solve_u2.data(), solve_lambda.data(), solve_ustar.data(),
+                                            solve_converged.data());
+
+                for (size_t j = 0; j < n; j++)
+                {
+                    size_t i = solve_idx[j];
+                    if (solve_converged[j])
                     {
-                        // Update z0 for blowing snow conditions
-                        // Li and Pomeroy 2000, eqn 5.
-                        // This formulation has the following coeffs built in
-                        // c_2 = 1.6;
-                        // c_3 = 0.07519;
-                        // c_4 = 0.5;
-                        // g   = 9.81;
-                        d.z0 = 0.6131702345e-2 * ustar * ustar + .5 * lambda; // pom and li 2000, eqn 4
+                        _profile.ustar[i] = solve_ustar[j];
+                        continue;
                     }
-                    else
+
+                    double u2 = solve_u2[j];
+                    double lambda = solve_lambda[j];
+                    auto ustarFn = [&](double ustar) -> double {
+                        return u2 * PhysConst::kappa / log(2.0 / pbsm3d::z0_blowing_snow(ustar, lambda)) - ustar;
+                    };
+
+                    try
+                    {
+                        boost::uintmax_t max_iter = 500;
+                        auto r = boost::math::tools::bracket_and_solve_root(ustarFn, 1.0, 1.0, false, tol, max_iter);
+                        _profile.ustar[i] = r.first + (r.second - r.first) / 2.0;
+                    }
+                    catch (...)
                     {
-                        d.z0 = Snow::Z0_SNOW;
+                        // Didn't converge, u* is left at the placeholder
                     }
                 }
             }
+        }
+
+        ////////////////////////////////////////////////////////////////////////////
+        // Saltation
+        ////////////////////////////////////////////////////////////////////////////
+#pragma omp for
+        for (size_t i = 0; i < ntri; i++)
+        {
+            auto face = domain->face(i);
+            auto& d = face->get_module_data<data>(ID);
+
+            double fetch = 1000;
+            if (use_exp_fetch || use_tanh_fetch)
+                fetch = (*face)["fetch"_s];
+
+            double swe = (*face)["swe"_s]; // mm   -->    kg/m^2
+            swe = is_nan(swe) ? 0 : swe;   // handle the first timestep where swe won't have been
+            // updated if we override the module order
+
+            double ustar = _profile.ustar[i];
+            double lambda = d.lambda;
+            double u10 = d.u10;
+            double frac_contrib = d.frac_contrib;
+            double uref = _profile.uref[i];
+            double height_diff = _profile.height_diff[i];
+            double T = _profile.T[i];
+            double u_star_saltation_threshold = _profile.u_th[i];
+
+            if (d.try_saltation && ustar >= u_star_saltation_threshold)
+            {
+                d.saltation = true;
+
+                if (z0_ustar_coupling)
+                {
+                    // Update z0 for blowing snow conditions
+                    d.z0 = pbsm3d::z0_blowing_snow(ustar, lambda); // pom and li 2000, eqn 4
+                }
+                else
+                {
+                    d.z0 = Snow::Z0_SNOW;
+                }
+            }
 
             if (!d.saltation)
             {
@@ -885,7 +1190,7 @@ void PBSM3D::run(mesh& domain)
                 uvw(0) = v.x(); // U_x
                 uvw(1) = v.y(); // U_y
                 uvw(2) = 0;
-                double V = face->get_area();
+                double V = cmesh.area[i];
                 double udotm[3] = {0, 0, 0};
                 double E[3] = {0, 0, 0};
 
@@ -895,7 +1200,7 @@ void PBSM3D::run(mesh& domain)
                 for (int j = 0; j < 3; ++j)
                 {
                     udotm[j] = arma::dot(uvw, d.m[j]);
-                    E[j] = face->edge_length(j);
+                    E[j] = cmesh.edge_length(i, j);
                     mass += -E[j] * Qsalt * udotm[j];
                 }
 
@@ -924,210 +1229,62 @@ void PBSM3D::run(mesh& domain)
 
             (*face)["Qsalt"_s] = Qsalt;
 
-            double rh = (*face)["rh"_s] / 100.;
-            double es = Atmosphere::saturatedVapourPressure(t);
-            double ea = rh * es / 1000.; // ea needs to be in kpa
+            d.c_salt = c_salt;
 
-            double v = 1.88e-5; // kinematic viscosity of air, below eqn 13 in Pomeroy 1993
-
-            // iterate over the vertical layers
-            for (int z = 0; z < nLayer; ++z)
-            {
-                // height in the suspension layer, floats above the snow surface
-                double cz = z * v_edge_height + hs + v_edge_height / 2.; // cell center height
-
-                // compute new U_z at this height in the suspension layer
-                double u_z = 0;
-
-                // Height above the ground (snow+free) of the suspension layer
-                double hz = cz + snow_depth;
-
-                // the suspension layer discretization 'floats' on top of the snow
-                // surface so height_diff = d.CanopyHeight - snowdepth which is
-                // looking to see if cz is within this part of the canopy
-                if (d.saltation && cz < height_diff)
-                {
-                    // saltating so used the z0 with veg, but we are in the canopy so
-                    // use the saltation vel
-
-                    // wind speed in the saltation layer Pomeroy and Gray 1990
-                    u_z = 2.8 * u_star_saltation_threshold; // eqn 7
-                }
-                else if (cz < height_diff)
-                {
-                    // we/re in a canopy, but not saltating, just do nothing
-                    u_z = 0.01; // essentially do nothing when we are in sub canopy
-
-                    //                // LAI used as attenuation coefficient introduced
-                    //                by Inoue (1963) and increases with canopy density
-                    //                double LAI =
-                    //                std::max(0.01,face->veg_attribute("LAI"));
-                    //                //bring wind down to canopy top
-                    //                double u_cantop = std::max(0.01,
-                    //                Atmosphere::log_scale_wind(uref,
-                    //                Atmosphere::Z_U_R, d.CanopyHeight, 0 , d.z0));
-                    //
-                    //                u_z = Atmosphere::exp_scale_wind(u_cantop,
-                    //                d.CanopyHeight, cz, LAI);
-                }
-                else
-                {
-                    if (hz < Atmosphere::Z_U_R)
-                    {
-                        u_z =
-                            std::max(0.01, Atmosphere::log_scale_wind(uref, Atmosphere::Z_U_R, hz, snow_depth, d.z0));
-                    }
-                    else
-                    {
-                        u_z = std::max(0.01, uref);
-                    }
-                }
-
-                d.u_z_susp.at(z) = u_z;
+            _profile.hs[i] = hs;
+            _profile.z0[i] = d.z0;
+            _profile.ustar[i] = ustar;
+            _profile.saltation[i] = d.saltation;
+            _profile.t[i] = t;
+            _profile.rh[i] = (*face)["rh"_s] / 100.;
+        }
 
-                // calculate dm/dt from
-                // equation 13 from Pomeroy and Li 2000
-                // To do so, use equations 12 - 16 in Pomeroy et al 2000
-                // Pomeroy, J. W., and L. Li (2000), Prairie and arctic areal snow
-                // cover mass balance using a blowing snow model, J. Geophys. Res.,
-                // 105(D21), 26619–26634, doi:10.1029/2000JD900149. [online] Available
-                // from: http://www.agu.org/pubs/crossref/2000/2000JD900149.shtml
+        ////////////////////////////////////////////////////////////////////////////
+        // Suspension layer wind speed, settling velocity, diffusivity, and sublimation
+        ////////////////////////////////////////////////////////////////////////////
+#pragma omp for schedule(static)
+        for (size_t b = 0; b < ntri; b += profile_block_size)
+        {
+            _profile.compute(_profile_settings, b, std::min(ntri, b + profile_block_size));
+        }
 
-                // these are from
-                // Pomeroy, J. W., D. M. Gray, and P. G. Landine (1993), The prairie
-                // blowing snow model: characteristics, validation, operation, J.
-                // Hydrol., 144(1–4), 165–192.
+        ////////////////////////////////////////////////////////////////////////////
+        // Suspension linear system
+        ////////////////////////////////////////////////////////////////////////////
+#pragma omp for
+        for (size_t i = 0; i < ntri; i++)
+        {
+            auto face = domain->face(i);
 
-                // eqn 18, mean particle radius
-                // This is 'r_r' in Pomeroy and Gray 1995, eqn 53
-                double rm = 4.6e-5 * pow(cz, -0.258);
-                if (debug_output)
-                {
-                    (*face)["rm" + std::to_string(z)] = rm;
-                    (*face)["cz" + std::to_string(z)] = cz;
-                }
+            auto& d = face->get_module_data<data>(ID);
+            auto& m = d.m;
 
-                // calculate mean mass, eqn 23, 24 in Pomeroy 1993 (PBSM)
-                // 52, 53 P&G 1995
-                double mm_alpha = 4.08 + 12.6 * cz; // 24
-                double mm = 4. / 3. * M_PI * rho_p * rm * rm * rm *
-                    (1.0 + 3.0 / mm_alpha + 2. / (mm_alpha * mm_alpha)); // mean mass, eqn 23
+            double hs = d.hs;
+            double c_salt = d.c_salt;
 
-                // mean radius of mean mass particle
-                double r_z = pow((3.0 * mm) / (4 * M_PI * rho_p), 0.3333333); // 50 in p&g 1995
-                if (debug_output)
-                    (*face)["mm"_s] = mm;
+            double phi = (*face)["vw_dir"_s]; // wind direction
+            Vector_2 vwind = -math::gis::bearing_to_cartesian(phi);
 
-                double xrz = 0.005 * pow(u_z, 1.36); // eqn 16
+            // iterate over the vertical layers
+            for (int z = 0; z < nLayer; ++z)
+            {
+                size_t k = _profile.index(i, z);
 
-                double omega = settling_velocity;
-                ; // Settling velocity
-                if (!do_fixed_settling)
-                {
-                    omega = 1.1e7 * pow(r_z, 1.8); // eqn 15 settling velocity
-                }
+                double u_z = _profile.u_z[k];
+                double w = _profile.w[k]; // settling_velocity;
+                double csubl = _profile.csubl[k];
 
                 if (debug_output)
-                    (*face)["settling_velocity" + std::to_string(z)] = omega;
-                double Vr = omega + 3.0 * xrz * cos(M_PI / 4.0); // eqn 14
-
-                double v = 1.88e-5;             // kinematic viscosity of air, below eqn 13 in
-                // Pomeroy 1993
-                double Re = 2.0 * r_z * Vr / v; // eqn  55 in p&g 1995
-
-                double Nu, Sh;
-                Nu = Sh = 1.79 + 0.606 * pow(Re, 0.5); // eqn 12
-
-                // define above, T is in C, t is in K
-
-                // (A.6)
-                double D = 2.06e-5 * pow(t / 273.15,
-                        1.75); // diffusivity of water vapour in air, t in K,
-                // eqn A-7 in Liston 1998 or Harder 2013 A.6
-
-                // (A.9)
-                double lambda_t =
-                    0.000063 * t + 0.00673; //  thermal conductivity, user Harder 2013 A.9, Pomeroy's
-                //  is off by an order of magnitude, this matches this
-                //  https://www.engineeringtoolbox.com/air-properties-d_156.html
-
-                // Standard constant value, e.g.,
-                // https://link.springer.com/referenceworkentry/10.1007%2F978-90-481-2642-2_329
-                //          double L = 2.38e6; // Latent heat of sublimation, J/kg
-                double L = 2.838e6; // Latent heat of sublimation, J/kg, Corrected value
-
-                double dmdtz = 0;
-
-                // use Pomeroy and Li 2000 iterative sol'n for Schmidt's equation
-                if (iterative_subl)
-                {
-                    /*
-                     * The *1000 and /1000 are important unit conversions. Doesn't quite
-                     * match the harder paper, but Phil assures me it is correct.
-                     */
-                    double mw = 0.01801528 * 1000.0; //[kg/mol]  ---> g/mol
-                    double R = 8.31441 / 1000.0;     // [J mol-1 K-1]
-
-                    double rho = (mw * ea) / (R * t);
-
-                    // use Harder 2013 (A.5) Formulation, but Pa formulation for e
-                    auto fx = [=](double Ti) {
-                        return boost::math::make_tuple(
-                                T +
-                                D * L *
-                                (rho / (1000.0) -
-                                 .611 * mw * exp(17.3 * Ti / (237.3 + Ti)) / (R * (Ti + 273.15) * (1000.0))) /
-                                lambda_t -
-                                Ti,
-                                D * L *
-                                (-0.6110000000e-3 * mw * (17.3 / (237.3 + Ti) - 17.3 * Ti / pow(237.3 + Ti, 2)) *
-                                 exp(17.3 * Ti / (237.3 + Ti)) / (R * (Ti + 273.15)) +
-                                 0.6110000000e-3 * mw * exp(17.3 * Ti / (237.3 + Ti)) / (R * pow(Ti + 273.15, 2))) /
-                                lambda_t -
-                                1);
-                    };
-
-                    double guess = T;
-                    double min = -50;
-                    double max = 0;
-                    int digits = 6;
-
-                    double Ti = boost::math::tools::newton_raphson_iterate(fx, guess, min, max, digits);
-                    double Ts = Ti + 273.15; // dmdtz expects in K
-
-                    // now use equation 13 with our solved Ts to compute dm/dt(z)
-                    dmdtz = 2.0 * M_PI * rm * lambda_t / L * Nu * (Ts - (t + 273.15)); // eqn 13 in Pomeroy and Li 2000
-                }
-                else // Use PBSM. Eqn 11 Pomeroy, Gray, Ladine, 1993  "﻿The
-                    // prairie blowing snow model: characteristics, validation,
-                    // operation"
                 {
-                    double M = 18.01; // molecular weight of water kg kmol-1
-                    double R = 8313;  // universal fas constant J mol-1 K-1
-
-                    double sigma =
-                        (rh - 1.0) * (1.019 + 0.027 * log(cz)); // undersaturation, Pomeroy and Li 2000, eqn 14
-
-                    double rho = (M * es) / (R * t); // saturation vapour density at t
-                    // radiative energy absorebed by the particle -- take from CRHM's
-                    // PBSM implimentation
-                    double Qr = 0.9 * M_PI * rm * rm * 120.0; // 120.0 = PBSM_constants::Qstar (Solar Radiation
-                    // Input), 0.9 comes from Schmidt (1972) assuming a
-                    // snow particle albedo of 0.5 and a snow surface
-                    // albedo of 0.8
-                    // rm ise used here as in Liston and Sturm (1998)
-
-                    // eqn 11 in PGL 1993, r_z is used here as in PG95 and Liston ans Sturm (1998)
-                    dmdtz = Sh * rho * D *
-                        (6.283185308 * Nu * R * r_z * sigma * t * t * lambda_t - L * M * Qr + Qr * R * t) /
-                        (D * L * Sh * (L * M - R * t) * rho + lambda_t * t * t * Nu * R);
+                    (*face)["rm" + std::to_string(z)] = _profile.rm[k];
+                    (*face)["cz" + std::to_string(z)] = _profile.cz[k];
+                    (*face)["mm"_s] = _profile.mm[k];
+                    (*face)["settling_velocity" + std::to_string(z)] = w;
+                    (*face)["dm/dt"_s] = _profile.dmdt[k];
+                    (*face)["l"_s] = _profile.l[k];
+                    (*face)["w"_s] = w;
+                    (*face)["Km_coeff"_s] = _profile.diffusion_coeff[k];
                 }
-                if (debug_output)
-                    (*face)["dm/dt"_s] = dmdtz;
-
-                if (debug_output)
-                    (*face)["mm"_s] = mm;
-                double csubl = dmdtz / mm; // EQN 21 POMEROY 1993 (PBSM)
 
                 // eddy diffusivity (m^2/s)
                 // 0,1,2 will all be K = 0, as no horizontal diffusion process
@@ -1152,32 +1309,8 @@ void PBSM3D::run(mesh& domain)
                         alpha[a] *= K[a];
                     }
                 }
-                // Li and Pomeroy 2000
-                double l = PhysConst::kappa * (cz + d.z0) * l__max / (PhysConst::kappa * (cz + d.z0) + l__max);
-                if (debug_output)
-                    (*face)["l"_s] = l;
-
-                double w = omega; // settling_velocity;
-                if (debug_output)
-                    (*face)["w"_s] = w;
-
-                double diffusion_coeff = snow_diffusion_const; // snow_diffusion_const is a shared param so
-                // need a seperate copy here we can
-                // overwrite
-                if (rouault_diffusion_coeff)
-                {
-                    double c2 = 1.0;
-                    double dc = 1.0 / (1.0 + (c2 * w * w) / (1.56 * ustar * ustar));
-                    diffusion_coeff = dc; // nope, snow_diffusion_const is shared, use a new
-                }
-                if (debug_output)
-                    (*face)["Km_coeff"_s] = diffusion_coeff;
 
-                // snow_diffusion_const is pretty much a calibration constant. At 1 it
-                // seems to over predict transports.
-                // with pomeroy fall velocity, 0.3 gives good agreement w/ published
-                // Qsusp values. Low value compensates for low fall velocity
-                K[3] = K[4] = diffusion_coeff * ustar * l;
+                K[3] = K[4] = _profile.K[k];
 
                 if (debug_output)
                     (*face)["K" + std::to_string(z)] = K[3];
@@ -1186,9 +1319,6 @@ void PBSM3D::run(mesh& domain)
                 // bottom
                 alpha[4] = d.A[4] * K[4] / v_edge_height;
 
-                double phi = (*face)["vw_dir"_s]; // wind direction
-                Vector_2 vwind = -math::gis::bearing_to_cartesian(phi);
-
                 // setup wind vector
                 arma::vec uvw(3);
                 uvw(0) = vwind.x(); // U_x
@@ -1219,19 +1349,12 @@ void PBSM3D::run(mesh& domain)
                 // lateral
                 int idx = n_global_tri * z + face->cell_global_id;
 
-                double V = face->get_area() * v_edge_height;
+                double V = cmesh.area[i] * v_edge_height;
                 // the sink term is added on for each edge check, which isn't right
                 // and ends up 5x counting it so / by 5 for V so it's
                 // not 5x counted.
                 V /= 5.0;
 
-                if (!do_sublimation)
-                {
-                    csubl = 0.0;
-                }
-
-                d.csubl[z] = csubl;
-
 
                 for (int f = 0; f < 3; f++)
                 {
@@ -1240,7 +1363,7 @@ void PBSM3D::run(mesh& domain)
 
                         if (d.face_neigh[f])
                         {
-                            int nidx = n_global_tri * z + face->neighbor(f)->cell_global_id;
+                            int nidx = n_global_tri * z + cmesh.global_id[cmesh.neighbor(i, f)];
 
                             // Diagonal value
                             suspension_NNP->matrixSumIntoGlobalValues(idx, idx,
@@ -1262,7 +1385,7 @@ void PBSM3D::run(mesh& domain)
                     {
                         if (d.face_neigh[f])
                         {
-                            int nidx = n_global_tri * z + face->neighbor(f)->cell_global_id;
+                            int nidx = n_global_tri * z + cmesh.global_id[cmesh.neighbor(i, f)];
                             // Diagonal entry
                             suspension_NNP->matrixSumIntoGlobalValues(idx, idx,
                                     V * csubl - alpha[f]);
@@ -1478,20 +1601,21 @@ void PBSM3D::run(mesh& domain)
             c = c < 0 || is_nan(c) ? 0 : c; // harden against some numerical issues that
             // occasionally come up for unknown reasons.
 
-            double u_z = d.u_z_susp.at(z);
+            size_t k = _profile.index(i, z);
+            double u_z = _profile.u_z[k];
 
             Qsusp += c * u_z * v_edge_height; /// kg/m^3 ---->  kg/(m.s)
 
             if (debug_output)
             {
                 (*face)["c" + std::to_string(z)] = c;
-                (*face)["csubl" + std::to_string(z)] = d.csubl[z];
+                (*face)["csubl" + std::to_string(z)] = _profile.csubl[k];
                 // This is an approximation as it uses after transport concentrations.
                 // However this will have already taken into account sublimation during the coupled transport phase
                 // Eqn 20 Pomeroy 1993
 
             }
-            Qsubl += d.csubl[z] * c * v_edge_height; //  kg/(m^2 *s)=> per unit area of snowcover
+            Qsubl += _profile.csubl[k] * c * v_edge_height; //  kg/(m^2 *s)=> per unit area of snowcover
         }
         (*face)["Qsusp"_s] = Qsusp;
 
@@ -1533,7 +1657,7 @@ void PBSM3D::run(mesh& domain)
         double E[3] = {0, 0, 0};        // edge lengths b/c 2d now
         double dx[3] = {2.0, 2.0, 2.0}; // cell centre distances
 
-        double V = face->get_area(); // V for consistency but actually an area
+        double V = cmesh.area[i]; // V for consistency but actually an area
 
         int global_row, local_col, global_col;
         global_row = static_cast<int>(face->cell_global_id);
@@ -1550,7 +1674,7 @@ void PBSM3D::run(mesh& domain)
         {
             // just unit vectors as qsusp/qsalt flux has magnitude
             udotm[j] = arma::dot(uvw, m[j]);
-            E[j] = face->edge_length(j);
+            E[j] = cmesh.edge_length(i, j);
 
             double Qtj = 0;
             double Qsj = 0;
@@ -1608,9 +1732,8 @@ void PBSM3D::run(mesh& domain)
             // build up our neighbors
             if (d.face_neigh[j])
             {
-                auto neigh = face->neighbor(j);
-                global_col = static_cast<int>(neigh->cell_global_id);
-                dx[j] = math::gis::distance(face->center(), neigh->center());
+                global_col = static_cast<int>(cmesh.global_id[cmesh.neighbor(i, j)]);
+                dx[j] = cmesh.neighbor_dist(i, j);
 
                 if(is_nan(eps))
                 {
@@ -31,6 +31,7 @@
 
 #include "math/coordinates.hpp"
 #include "math/LinearAlgebra.hpp"
+#include "PBSM3D_profile.hpp"
 
 #include <physics/PhysConst.h>
 #include "physics/Atmosphere.h"
@@ -39,10 +40,12 @@
 
 #include <cmath>
 #include <gsl/gsl_cdf.h>
+#include <gsl/gsl_errno.h>
 #include <gsl/gsl_integration.h>
 #include <gsl/gsl_math.h>
 #include <gsl/gsl_randist.h>
 #include <gsl/gsl_sf_lambert.h>
+#include <map>
 #include <vector>
 
 #include <armadillo>
@@ -171,6 +174,35 @@
  *
  *    Experimental sub-grid topographic impacts v2. Do not use.
  *
+ * .. confval:: subgrid_table_max_sd
+ *
+ *    :default: 5.0 [m]
+ *
+ *    If ``use_subgrid_topo_V2:true``, the holding capacity is tabulated at init for snow depths up to this value.
+ *    Deeper snow falls back to integrating the holding capacity every timestep.
+ *
+ * .. confval:: subgrid_table_dsd
+ *
+ *    :default: 0.05 [m]
+ *
+ *    Initial snow depth spacing of the holding capacity table.
+ *
+ * .. confval:: subgrid_table_tol
+ *
+ *    :default: 1e-4
+ *
+ *    Maximum linear interpolation error of the holding capacity table. The table is refined until this is met, at most
+ *    6 times. Tables that still miss it are reported in the log.
+ *
+ * .. confval:: subgrid_table_dtpi
+ *
+ *    :default: 0 [m]
+ *
+ *    By default, holding capacity tables are only shared between faces with identical TPI distributions, and results are
+ *    within ``subgrid_table_tol`` of integrating every timestep. A positive value rounds each face's mean and standard
+ *    deviation of TPI to a multiple of it so that more faces share a table. This reduces init time but changes the
+ *    results by far more than ``subgrid_table_tol``, with no bound on the difference.
+ *
  * .. confval:: use_R94_lambda
  *
  *    :default: true
@@ -364,6 +396,70 @@ class PBSM3D : public module_base
     // to modify the u* estimation instead of using a snow z0 for u* estimation
     bool z0_ustar_coupling;
 
+    // Sub-grid topography (use_subgrid_topo_V2) lookup table settings
+    double subgrid_table_max_sd; // largest snow depth (m) that is tabulated, larger depths are integrated directly
+    double subgrid_table_dsd;    // initial snow depth spacing (m) of the table
+    double subgrid_table_tol;    // maximum allowed linear interpolation error
+    double subgrid_table_dtpi;   // TPI mean and std (m) quantization used to share tables between faces
+
+    /**
+     * Table of the sub-grid topography holding capacity, TPI filling threshold and contributing fraction
+     * as a function of snow depth for one TPI class. The TPI distribution of a face is static, so these only need to be
+     * integrated at init.
+     */
+    struct subgrid_topo_table
+    {
+        double moy_tpi;
+        double std_tpi;
+        double norm; // normalization of the filling function over the TPI distribution
+        double frac_contrib_no_hold; // contributing fraction when snow depth <= min_sd_trans
+
+        double sd0;    // first tabulated snow depth (m)
+        double sd_max; // last tabulated snow depth (m)
+        double dsd;    // snow depth spacing (m)
+
+        std::vector<double> tpi_lim;
+        std::vector<double> hold;
+        std::vector<double> frac_contrib;
+
+        size_t nfailed; // integrations that did not reach the requested accuracy
+        bool converged; // linear interpolation is within subgrid_table_tol
+        double max_err; // largest midpoint interpolation error found in the last refinement check
+
+        /**
+         * Linearly interpolates the table at the given snow depth
+         * @return false if the snow depth is outside of the tabulated range
+         */
+        bool lookup(double snow_depth, double& tpi_lim_out, double& hold_out, double& frac_contrib_out) const;
+    };
+
+    /**
+     * Normalization factor of the TPI filling function for a face's TPI distribution
+     */
+    double subgrid_topo_V2_norm(double moy_tpi, double std_tpi, int& status);
+
+    /**
+     * Integrates the sub-grid topography holding capacity for a given snow depth
+     * @param hold Holding capacity (m), not yet limited by the snow depth
+     * @return GSL_SUCCESS, or the GSL status of the first integration that did not reach the requested accuracy
+     */
+    int subgrid_topo_V2_holding(double snow_depth, double norm, double moy_tpi, double std_tpi,
+                                double& tpi_lim, double& hold, double& frac_contrib);
+
+    /**
+     * Wind speed 10 m above the snow surface from the reference height wind speed uref
+     */
+    static double wind_10m(double uref, double snow_depth);
+
+    /**
+     * Fills the snow depth table for the table's moy_tpi and std_tpi, refining it until linear interpolation is within
+     * subgrid_table_tol
+     */
+    void build_subgrid_topo_table(subgrid_topo_table& tbl);
+
+    // Holding capacity tables, one per TPI class. Faces point into this, so it is not resized after init
+    std::vector<subgrid_topo_table> _subgrid_tables;
+
     class data : public face_info
     {
       public:
@@ -376,7 +472,6 @@ class PBSM3D : public module_base
         // face neighbors
         bool face_neigh[3];
 
-        std::vector<double> u_z_susp; // suspension layer windspeeds
         size_t cell_local_id;
 
         double CanopyHeight;
@@ -396,15 +491,19 @@ class PBSM3D : public module_base
 
         double z0;
 
+        // saltation checks and inputs that are carried between the stages of run
+        bool try_saltation; // veg and snow cover allow saltation, pending the u* threshold
+        bool solve_ustar;   // u* needs the iterative z0_ustar_coupling solution
+        double lambda;
+        double u10;
+        double snow_depth; // snowdepthavg this timestep, before any later module updates it
+        double frac_contrib;
+        double c_salt;
+
         double sum_drift;
         double sum_subl;
-        std::vector<double> csubl; //vertical col of sublimation coeffs
 
-        gsl_function F_fill;
-        gsl_function F_fill2;
-        gsl_function F_fill3;
-        // gsl_function F_roots;
-        // struct my_fill_topo_params params = { 1.1, 0.3, 0.6 , 0.4};
+        const subgrid_topo_table* subgrid_topo; // shared use_subgrid_topo_V2 holding capacity, nullptr without TPI
     };
 
     void checkpoint(mesh& domain,  netcdf& chkpt);
@@ -420,6 +519,14 @@ private:
   std::unique_ptr<math::LinearAlgebra::NearestNeighborProblem> deposition_NNP;
   std::unique_ptr<math::LinearAlgebra::NearestNeighborProblem> suspension_NNP;
 
+  // Per-face u* and the [face][layer] suspension layer profile
+  pbsm3d::profile_settings _profile_settings;
+  pbsm3d::suspension_profile _profile;
+
+  // number of faces handled at once by the batched u* solver and the profile kernel
+  constexpr static size_t ustar_block_size = 256;
+  constexpr static size_t profile_block_size = 64;
+
 };
 
 /**
@@ -0,0 +1,369 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+#include "PBSM3D_profile.hpp"
+
+#include <physics/PhysConst.h>
+#include "physics/Atmosphere.h"
+#include "math/fast_math.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+#include <boost/math/tools/roots.hpp>
+#include <boost/math/tools/tuple.hpp>
+
+namespace pbsm3d
+{
+
+void suspension_profile::resize(size_t nfaces, int nLayer, bool debug)
+{
+    _nLayer = nLayer;
+    _debug = debug;
+
+    for (auto* v : {&hs, &snow_depth, &height_diff, &z0, &ustar, &uref, &u_th, &T, &t, &rh, &_D, &_lambda_t, &_Ts, &_rho})
+        v->assign(nfaces, 0);
+    saltation.assign(nfaces, 0);
+
+    size_t n = nfaces * nLayer;
+    for (auto* v : {&u_z, &w, &K, &csubl})
+        v->assign(n, 0);
+
+    for (auto* v : {&cz, &rm, &mm, &dmdt, &l, &diffusion_coeff})
+        v->assign(debug ? n : 0, 0);
+}
+
+void suspension_profile::compute(const profile_settings& s, size_t begin, size_t end)
+{
+    // Standard constant value, e.g.,
+    // https://link.springer.com/referenceworkentry/10.1007%2F978-90-481-2642-2_329
+    //          double L = 2.38e6; // Latent heat of sublimation, J/kg
+    const double L = 2.838e6; // Latent heat of sublimation, J/kg, Corrected value
+
+    // PBSM, eqn 11 Pomeroy, Gray, Ladine, 1993
+    const double M = 18.01; // molecular weight of water kg kmol-1
+    const double R = 8313;  // universal fas constant J mol-1 K-1
+
+    // Per-face terms. These were previously recomputed for every layer, including the iterative particle temperature
+    // solve, but they do not depend on height.
+    for (size_t i = begin; i < end; ++i)
+    {
+        // (A.6)
+        _D[i] = 2.06e-5 * pow(t[i] / 273.15, 1.75); // diffusivity of water vapour in air, t in K,
+                                                    // eqn A-7 in Liston 1998 or Harder 2013 A.6
+
+        // (A.9)
+        _lambda_t[i] = 0.000063 * t[i] + 0.00673; //  thermal conductivity, user Harder 2013 A.9, Pomeroy's
+                                                  //  is off by an order of magnitude, this matches this
+                                                  //  https://www.engineeringtoolbox.com/air-properties-d_156.html
+
+        double es = Atmosphere::saturatedVapourPressure(t[i]);
+
+        if (s.iterative_subl)
+        {
+            // use Pomeroy and Li 2000 iterative sol'n for Schmidt's equation
+            /*
+             * The *1000 and /1000 are important unit conversions. Doesn't quite
+             * match the harder paper, but Phil assures me it is correct.
+             */
+            double mw = 0.01801528 * 1000.0; //[kg/mol]  ---> g/mol
+            double Rg = 8.31441 / 1000.0;    // [J mol-1 K-1]
+
+            double ea = rh[i] * es / 1000.; // ea needs to be in kpa
+            double rho = (mw * ea) / (Rg * t[i]);
+
+            double T_air = T[i];
+            double D = _D[i];
+            double lambda_t = _lambda_t[i];
+
+            // use Harder 2013 (A.5) Formulation, but Pa formulation for e
+            auto fx = [=](double Ti) {
+                return boost::math::make_tuple(
+                    T_air +
+                        D * L *
+                            (rho / (1000.0) -
+                             .611 * mw * exp(17.3 * Ti / (237.3 + Ti)) / (Rg * (Ti + 273.15) * (1000.0))) /
+                            lambda_t -
+                        Ti,
+                    D * L *
+                            (-0.6110000000e-3 * mw * (17.3 / (237.3 + Ti) - 17.3 * Ti / pow(237.3 + Ti, 2)) *
+                                 exp(17.3 * Ti / (237.3 + Ti)) / (Rg * (Ti + 273.15)) +
+                             0.6110000000e-3 * mw * exp(17.3 * Ti / (237.3 + Ti)) / (Rg * pow(Ti + 273.15, 2))) /
+                            lambda_t -
+                        1);
+            };
+
+            double guess = T_air;
+            double min = -50;
+            double max = 0;
+            int digits = 6;
+
+            double Ti = boost::math::tools::newton_raphson_iterate(fx, guess, min, max, digits);
+            _Ts[i] = Ti + 273.15; // dmdtz expects in K
+        }
+        else
+        {
+            _rho[i] = (M * es) / (R * t[i]); // saturation vapour density at t
+        }
+    }
+
+    // The settings that select between code paths are made compile time, so that the layer loop has no control flow
+    auto layers = [&](auto debug)
+    {
+        constexpr bool dbg = decltype(debug)::value;
+        if (s.iterative_subl)
+        {
+            if (s.rouault_diffusion_coeff)
+                compute_layers<dbg, true, true>(s, begin, end);
+            else
+                compute_layers<dbg, true, false>(s, begin, end);
+        }
+        else
+        {
+            if (s.rouault_diffusion_coeff)
+                compute_layers<dbg, false, true>(s, begin, end);
+            else
+                compute_layers<dbg, false, false>(s, begin, end);
+        }
+    };
+
+    if (_debug)
+        layers(std::true_type());
+    else
+        layers(std::false_type());
+}
+
+template<bool debug, bool iterative_subl, bool rouault_diffusion_coeff>
+void suspension_profile::compute_layers(const profile_settings& s, size_t begin, size_t end)
+{
+    const double rho_p = PhysConst::rho_ice;
+    const double v = 1.88e-5; // kinematic viscosity of air, below eqn 13 in Pomeroy 1993
+    const double L = 2.838e6; // Latent heat of sublimation, J/kg, Corrected value
+    const double M = 18.01;   // molecular weight of water kg kmol-1
+    const double R = 8313;    // universal fas constant J mol-1 K-1
+
+    const int nLayer = s.nLayer;
+    const double veh = s.v_edge_height;
+
+    // The on/off settings as factors, a ?: on them in the layer loop would be turned into a branch
+    const double fixed_settling = s.do_fixed_settling ? s.settling_velocity : 0.0;
+    const double settling_coeff = s.do_fixed_settling ? 0.0 : 1.1e7;
+    const double sublimation = s.do_sublimation ? 1.0 : 0.0;
+
+    double* u_z = this->u_z.data();
+    double* w = this->w.data();
+    double* K = this->K.data();
+    double* csubl = this->csubl.data();
+
+    for (size_t i = begin; i < end; ++i)
+    {
+        // Per-face inputs as locals, otherwise they are reloaded after every store in the layer loops
+        const double hs_i = hs[i];
+        const double snow_depth_i = snow_depth[i];
+        const double height_diff_i = height_diff[i];
+        const double z0_i = z0[i];
+        const double ustar_i = ustar[i];
+        const double uref_i = uref[i];
+        const double t_i = t[i];
+        const double rh_i = rh[i];
+        const double D = _D[i];
+        const double lambda_t = _lambda_t[i];
+        const double Ts = iterative_subl ? _Ts[i] : 0.0;
+        const double rho = iterative_subl ? 0.0 : _rho[i];
+
+        // If saltating in the canopy, use the saltation layer wind speed (Pomeroy and Gray 1990 eqn 7).
+        // If in a canopy but not saltating, essentially do nothing.
+        const double u_canopy = saltation[i] ? 2.8 * u_th[i] : 0.01;
+
+        double* u_z_i = u_z + i * nLayer;
+
+        // The wind profile is done in loops of its own. With the selects in the loop below, GCC moves the arithmetic
+        // on either side of them into branches, and those cannot be vectorized.
+
+        // Atmosphere::log_scale_wind, written out so that it vectorizes
+        const double log_ref = math::fast::log((Atmosphere::Z_U_R - (snow_depth_i + z0_i)) / z0_i);
+#pragma omp simd
+        for (int z = 0; z < nLayer; ++z)
+        {
+            double c_z = z * veh + hs_i + veh / 2.;
+            double hz = c_z + snow_depth_i;
+            u_z_i[z] = uref_i * math::fast::log((hz - (snow_depth_i + z0_i)) / z0_i) / log_ref;
+        }
+
+#pragma omp simd
+        for (int z = 0; z < nLayer; ++z)
+        {
+            double c_z = z * veh + hs_i + veh / 2.;
+            double hz = c_z + snow_depth_i;
+            double u_log = hz < Atmosphere::Z_U_R ? u_z_i[z] : uref_i;
+
+            // the suspension layer discretization 'floats' on top of the snow
+            // surface so height_diff = d.CanopyHeight - snowdepth which is
+            // looking to see if cz is within this part of the canopy.
+            u_z_i[z] = c_z < height_diff_i ? u_canopy : std::max(0.01, u_log);
+        }
+
+        // Every quantity below is a pure function of the per-face inputs and the height, so the layers of a face are
+        // vectorized. The transcendentals are math::fast so that this does not need libmvec.
+#pragma omp simd
+        for (int z = 0; z < nLayer; ++z)
+        {
+            size_t k = i * nLayer + z;
+
+            // height in the suspension layer, floats above the snow surface
+            double c_z = z * veh + hs_i + veh / 2.; // cell center height
+
+            double uz = u_z[k];
+
+            // eqn 18, mean particle radius
+            // This is 'r_r' in Pomeroy and Gray 1995, eqn 53
+            double r_m = 4.6e-5 * math::fast::pow(c_z, -0.258);
+
+            // calculate mean mass, eqn 23, 24 in Pomeroy 1993 (PBSM)
+            // 52, 53 P&G 1995
+            double mm_alpha = 4.08 + 12.6 * c_z; // 24
+            double m_m = 4. / 3. * M_PI * rho_p * r_m * r_m * r_m *
+                         (1.0 + 3.0 / mm_alpha + 2. / (mm_alpha * mm_alpha)); // mean mass, eqn 23
+
+            // mean radius of mean mass particle
+            double r_z = math::fast::pow((3.0 * m_m) / (4 * M_PI * rho_p), 0.3333333); // 50 in p&g 1995
+
+            double xrz = 0.005 * math::fast::pow(uz, 1.36); // eqn 16
+
+            // Settling velocity
+            double omega = fixed_settling + settling_coeff * math::fast::pow(r_z, 1.8); // eqn 15 settling velocity
+
+            double Vr = omega + 3.0 * xrz * cos(M_PI / 4.0); // eqn 14
+            double Re = 2.0 * r_z * Vr / v;                  // eqn  55 in p&g 1995
+
+            // std::sqrt would set errno on negative input, which also stops the vectorization
+            double Nu = 1.79 + 0.606 * math::fast::pow(Re, 0.5); // eqn 12
+            double Sh = Nu;
+
+            double dmdtz = 0;
+            if constexpr (iterative_subl)
+            {
+                // now use equation 13 with our solved Ts to compute dm/dt(z)
+                dmdtz = 2.0 * M_PI * r_m * lambda_t / L * Nu * (Ts - (t_i + 273.15)); // eqn 13 in Pomeroy and Li 2000
+            }
+            else
+            {
+                double sigma = (rh_i - 1.0) * (1.019 + 0.027 * math::fast::log(c_z)); // undersaturation, Pomeroy and Li 2000, eqn 14
+
+                // radiative energy absorebed by the particle -- take from CRHM's
+                // PBSM implimentation
+                double Qr = 0.9 * M_PI * r_m * r_m * 120.0; // 120.0 = PBSM_constants::Qstar (Solar Radiation
+                                                            // Input), 0.9 comes from Schmidt (1972) assuming a
+                                                            // snow particle albedo of 0.5 and a snow surface
+                                                            // albedo of 0.8
+                                                            // rm ise used here as in Liston and Sturm (1998)
+
+                // eqn 11 in PGL 1993, r_z is used here as in PG95 and Liston ans Sturm (1998)
+                dmdtz = Sh * rho * D *
+                        (6.283185308 * Nu * R * r_z * sigma * t_i * t_i * lambda_t - L * M * Qr + Qr * R * t_i) /
+                        (D * L * Sh * (L * M - R * t_i) * rho + lambda_t * t_i * t_i * Nu * R);
+            }
+
+            double c_subl = sublimation * dmdtz / m_m; // EQN 21 POMEROY 1993 (PBSM)
+
+            // Li and Pomeroy 2000
+            double l_mix = PhysConst::kappa * (c_z + z0_i) * s.l__max / (PhysConst::kappa * (c_z + z0_i) + s.l__max);
+
+            double dc = s.snow_diffusion_const;
+            if constexpr (rouault_diffusion_coeff)
+            {
+                double c2 = 1.0;
+                dc = 1.0 / (1.0 + (c2 * omega * omega) / (1.56 * ustar_i * ustar_i));
+            }
+
+            // snow_diffusion_const is pretty much a calibration constant. At 1 it
+            // seems to over predict transports.
+            // with pomeroy fall velocity, 0.3 gives good agreement w/ published
+            // Qsusp values. Low value compensates for low fall velocity
+            w[k] = omega;
+            K[k] = dc * ustar_i * l_mix;
+            csubl[k] = c_subl;
+
+            if constexpr (debug)
+            {
+                cz[k] = c_z;
+                rm[k] = r_m;
+                mm[k] = m_m;
+                dmdt[k] = dmdtz;
+                l[k] = l_mix;
+                diffusion_coeff[k] = dc;
+            }
+        }
+    }
+}
+
+void solve_ustar_coupled(size_t n, const double* u2, const double* lambda, double* ustar, char* converged)
+{
+    const int max_iter = 50;
+
+    // Same initial guess as the bracketing solver this replaces
+    for (size_t i = 0; i < n; ++i)
+    {
+        ustar[i] = 1.0;
+        converged[i] = 0;
+    }
+
+    for (int iter = 0; iter < max_iter; ++iter)
+    {
+        size_t active = 0;
+
+#pragma omp simd reduction(+ : active)
+        for (size_t i = 0; i < n; ++i)
+        {
+            // f(u*) = u2 * kappa / log(2 / z0(u*)) - u*
+            double u = ustar[i];
+            double g = z0_blowing_snow(u, lambda[i]);
+            double lg = math::fast::log(2.0 / g);
+            double c = u2[i] * PhysConst::kappa;
+
+            double f = c / lg - u;
+            double df = c * (2.0 * 0.6131702345e-2 * u) / (g * lg * lg) - 1.0;
+
+            double u_new = u - f / df;
+            bool done = converged[i] || std::fabs(u_new - u) < 1e-10;
+
+            ustar[i] = converged[i] ? u : u_new;
+            converged[i] = done;
+            active += !done;
+        }
+
+        if (active == 0)
+            break;
+    }
+
+    // Only accept physical roots, the remainder fall back to the bracketing solver
+    for (size_t i = 0; i < n; ++i)
+    {
+        double g = z0_blowing_snow(ustar[i], lambda[i]);
+        if (!std::isfinite(ustar[i]) || ustar[i] <= 0 || g <= 0 || g >= 2.0)
+            converged[i] = 0;
+    }
+}
+
+}
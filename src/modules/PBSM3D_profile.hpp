@@ -0,0 +1,137 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * Per-face friction velocity and suspension layer profile calculations used by PBSM3D.
+ *
+ * These are kept independent of the mesh so that they can be driven for blocks of faces at a time
+ * and tested in isolation. All per-layer quantities are stored as contiguous [face][layer] arrays,
+ * with the layer index varying fastest, so that the layers of a face are a contiguous span that the compiler
+ * vectorizes over.
+ */
+namespace pbsm3d
+{
+    /**
+     * Suspension layer settings that are shared by all faces. See PBSM3D for their meaning.
+     */
+    struct profile_settings
+    {
+        int nLayer;
+        double v_edge_height;
+        double l__max;
+        double snow_diffusion_const;
+        bool rouault_diffusion_coeff;
+        bool do_fixed_settling;
+        double settling_velocity;
+        bool do_sublimation;
+        bool iterative_subl;
+    };
+
+    class suspension_profile
+    {
+      public:
+        /**
+         * Allocates storage for nfaces faces of nLayer layers
+         * @param debug Also store the intermediate quantities that are written as debug output
+         */
+        void resize(size_t nfaces, int nLayer, bool debug);
+
+        /**
+         * Computes the suspension layer wind speed, settling velocity, eddy diffusivity, and sublimation coefficient for
+         * every layer of faces [begin, end). The per-face inputs must be set for these faces.
+         * Different threads may call this concurrently for non-overlapping face ranges.
+         */
+        void compute(const profile_settings& s, size_t begin, size_t end);
+
+        /// Index of layer z of face i in the [face][layer] arrays
+        inline size_t index(size_t i, int z) const
+        {
+            return i * _nLayer + z;
+        }
+
+        // Per-face inputs
+        std::vector<double> hs;          // saltation layer height (m)
+        std::vector<double> snow_depth;  // (m)
+        std::vector<double> height_diff; // exposed vegetation height (m)
+        std::vector<double> z0;          // (m)
+        std::vector<double> ustar;       // (m/s)
+        std::vector<double> uref;        // wind speed at Atmosphere::Z_U_R (m/s)
+        std::vector<double> u_th;        // saltation threshold friction velocity (m/s)
+        std::vector<double> T;           // air temperature (C)
+        std::vector<double> t;           // air temperature (K)
+        std::vector<double> rh;          // relative humidity [0,1]
+        std::vector<char> saltation;
+
+        // [face][layer] outputs
+        std::vector<double> u_z;   // wind speed (m/s)
+        std::vector<double> w;     // settling velocity (m/s)
+        std::vector<double> K;     // vertical eddy diffusivity (m^2/s)
+        std::vector<double> csubl; // sublimation coefficient (1/s)
+
+        // [face][layer] debug outputs, only allocated if requested in resize
+        std::vector<double> cz;
+        std::vector<double> rm;
+        std::vector<double> mm;
+        std::vector<double> dmdt;
+        std::vector<double> l;
+        std::vector<double> diffusion_coeff;
+
+      private:
+        // The layer loops of compute, specialized on the settings that change the code path so that they vectorize
+        template<bool debug, bool iterative_subl, bool rouault_diffusion_coeff>
+        void compute_layers(const profile_settings& s, size_t begin, size_t end);
+
+        int _nLayer = 0;
+        bool _debug = false;
+
+        // per-face quantities that do not vary with height
+        std::vector<double> _D;        // diffusivity of water vapour in air
+        std::vector<double> _lambda_t; // thermal conductivity of air
+        std::vector<double> _Ts;       // particle surface temperature, iterative_subl only
+        std::vector<double> _rho;      // water vapour density
+    };
+
+    /**
+     * Solves Li and Pomeroy (2000) eqn 5 for the friction velocity u* of n faces simultaneously via Newton's method,
+     * so that the iteration vectorizes across faces.
+     * @param u2 2 m wind speed
+     * @param lambda Exposed vegetation roughness element density
+     * @param ustar Resulting u*
+     * @param converged Set to 0 for faces that did not converge to a physical root. These should be solved with a
+     * bracketing solver instead.
+     */
+    void solve_ustar_coupled(size_t n, const double* u2, const double* lambda, double* ustar, char* converged);
+
+    /**
+     * Li and Pomeroy 2000 eqn 5 for the blowing snow z0, with c_2 = 1.6, c_3 = 0.07519, c_4 = 0.5, g = 9.81 built in
+     */
+    inline double z0_blowing_snow(double ustar, double lambda)
+    {
+        return 0.6131702345e-2 * ustar * ustar + .5 * lambda;
+    }
+}
@@ -37,63 +37,62 @@ PenmanMonteith_evaporation::PenmanMonteith_evaporation(config_file cfg)
 
     provides("ET");
 
+    block_kernel();
+
 
     SPDLOG_DEBUG("Successfully instantiated module {}",this->ID);
 }
 
- void PenmanMonteith_evaporation::run(mesh_elem& face)
+void PenmanMonteith_evaporation::run(face_range& range)
 {
 
     double albedo = 0.23; //grass and crops
-    double qsi = (*face)["iswr"_s];
-    double Lin = (*face)["ilwr"_s];
-
-    double rh = (*face)["rh"_s] / 100.;
-    double t = (*face)["t"_s];
-    double es = Atmosphere::saturatedVapourPressure(t);
-    double ea = rh * es / 1000.; // kpa
-
-
-    double T = (*face)["t"_s];
-    double u = (*face)["U_2m_above_srf"_s];
-
-
     double grass_emissivity = 0.9;
-
-
-    double Qn = (1-albedo)*qsi;
     double sigma = 5.67*pow(10.0,-8.0); //boltzman
-    double Lout = sigma * grass_emissivity * pow(T+273,4.0); //assume ground temp = air temp (lol)
-
-    double Rn = Qn + (Lin-Lout);
-
-    double G = 0.1*Rn;
-
-    double delta = ( 4098.0*(0.6108*exp( (17.27*T) / (T+237.3))))/pow(T+237.3,2.0);
-
     double psy_const = 0.066; //kpa / K
+    double cp = 1.005; //kJ/kg
+    double rho = 1.2; //density dry air, take it as const for now.
+    double h = 0.01; //veg height
+    double z0 = h/7.6; //maybe fix this?
+    double kappa = 0.41;
+    double rc = 62.0; //s/m  unstressed
 
-    double latent_heat = 2501.0-2.361*T; //kJ/kg
+    const double* iswr = range.in("iswr"_s);
+    const double* ilwr = range.in("ilwr"_s);
+    const double* RH = range.in("rh"_s);
+    const double* t = range.in("t"_s);
+    const double* U = range.in("U_2m_above_srf"_s);
+    double* ET = range.out("ET"_s);
 
-    double cp = 1.005; //kJ/kg
+    for (size_t k = 0; k < range.size(); ++k)
+    {
+        double qsi = iswr[k];
+        double Lin = ilwr[k];
 
-    double rho = 1.2; //density dry air, take it as const for now.
+        double rh = RH[k] / 100.;
+        double T = t[k];
+        double es = Atmosphere::saturatedVapourPressure(T);
+        double ea = rh * es / 1000.; // kpa
 
-    double h = 0.01; //veg height
+        double u = U[k];
 
-    double z0 = h/7.6; //maybe fix this?
+        double Qn = (1-albedo)*qsi;
+        double Lout = sigma * grass_emissivity * pow(T+273,4.0); //assume ground temp = air temp (lol)
 
-    double kappa = 0.41;
+        double Rn = Qn + (Lin-Lout);
 
-    double ra = pow(log( (10.0-0.67*h)/z0),2.0)/(pow(kappa,2.0)*u); //10cm veg
+        double G = 0.1*Rn;
 
-    double rc = 62.0; //s/m  unstressed
+        double delta = ( 4098.0*(0.6108*exp( (17.27*T) / (T+237.3))))/pow(T+237.3,2.0);
 
-    double E = (delta*(Qn-G)/latent_heat + (rho*cp*(es-ea)/ra))/(delta + psy_const * (1+rc/ra));
+        double latent_heat = 2501.0-2.361*T; //kJ/kg
 
-    (*face)["ET"_s]= E;
+        double ra = pow(log( (10.0-0.67*h)/z0),2.0)/(pow(kappa,2.0)*u); //10cm veg
 
+        double E = (delta*(Qn-G)/latent_heat + (rho*cp*(es-ea)/ra))/(delta + psy_const * (1+rc/ra));
 
+        ET[k] = E;
+    }
 }
 
 PenmanMonteith_evaporation::~PenmanMonteith_evaporation()
@@ -60,6 +60,6 @@ REGISTER_MODULE_HPP(PenmanMonteith_evaporation);
 public:
     PenmanMonteith_evaporation(config_file cfg);
     ~PenmanMonteith_evaporation();
-    virtual void run(mesh_elem& face);
+    virtual void run(face_range& range);
 
 };
@@ -35,6 +35,8 @@ Richard_albedo::Richard_albedo(config_file cfg)
     provides("snow_albedo");
     provides("melting_albedo");
 
+    // a snow-free face always resets to the bare albedo, so there is nothing to do once it has been set
+    skip_if_snow_free();
 }
 Richard_albedo::~Richard_albedo()
 {
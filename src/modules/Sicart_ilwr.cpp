@@ -35,6 +35,8 @@ Sicart_ilwr::Sicart_ilwr(config_file cfg)
     depends("cloud_frac");
     provides("ilwr");
 
+    block_kernel();
+
     SPDLOG_DEBUG("Successfully instantiated module {}",this->ID);
 }
 
@@ -42,30 +44,37 @@ void Sicart_ilwr::init(mesh& domain)
 {
 
 }
-void Sicart_ilwr::run(mesh_elem& face)
+void Sicart_ilwr::run(face_range& range)
 {
-    double T = (*face)["t"_s]+273.15; //C->K
-    double tau = (*face)["atm_trans"_s];
-    if( (*face)["iswr"_s] < 3.)
-    {
-        tau = (*face)["cloud_frac"_s];
-    }
-
+    const double* t = range.in("t"_s);
+    const double* rh = range.in("rh"_s);
+    const double* iswr = range.in("iswr"_s);
+    const double* atm_trans = range.in("atm_trans"_s);
+    const double* cloud_frac = range.in("cloud_frac"_s);
+    const double* svf = range.has_parameter("svf"_s) ? range.parameter("svf"_s) : nullptr;
+    double* ilwr = range.out("ilwr"_s);
 
-    double RH = (*face)["rh"_s] / 100.0;
-    double es = mio::Atmosphere::vaporSaturationPressure(T);//mio::Atmosphere::saturatedVapourPressure(T);
-    double e =  es * RH;
-    e = e * 0.01; // pa->mb
     double sigma = 5.67*pow(10.0,-8.0); //boltzman
 
-    double Lin = 1.24*pow(e/T,1.0/7.0)*(1.0+0.44*RH-0.18*tau)*sigma*pow(T,4.0);
-
-    double svf = 1.; //default open view
-    if (face->has_parameter("svf"_s) && !is_nan(face->parameter("svf"_s)))
+    for (size_t k = 0; k < range.size(); ++k)
     {
-        svf = face->parameter("svf"_s);
+        double T = t[k]+273.15; //C->K
+        double tau = iswr[k] < 3. ? cloud_frac[k] : atm_trans[k];
+
+        double RH = rh[k] / 100.0;
+        double es = mio::Atmosphere::vaporSaturationPressure(T);//mio::Atmosphere::saturatedVapourPressure(T);
+        double e =  es * RH;
+        e = e * 0.01; // pa->mb
+
+        double Lin = 1.24*pow(e/T,1.0/7.0)*(1.0+0.44*RH-0.18*tau)*sigma*pow(T,4.0);
+
+        double sv = 1.; //default open view
+        if (svf && !is_nan(svf[k]))
+        {
+            sv = svf[k];
+        }
+        ilwr[k] = sv*Lin;
     }
-    (*face)["ilwr"_s]= svf*Lin;
 }
 
 Sicart_ilwr::~Sicart_ilwr()
@@ -67,7 +67,7 @@ REGISTER_MODULE_HPP(Sicart_ilwr);
 public:
     Sicart_ilwr(config_file cfg);
     ~Sicart_ilwr();
-    virtual void run(mesh_elem& face);
+    virtual void run(face_range& range);
     void init(mesh& domain);
 
 
@@ -179,13 +179,13 @@ void Simple_Canopy::run(mesh_elem &face)
     // Aerodynamic resistance of canopy
     ra = (log(Zref/Z0snow)*log(Zwind/Z0snow))/pow(PhysConst::kappa,2)/U1; // (s/m)
 
-    double deltaX = 0.622*PhysConst::Ls*Qs(air_pressure, T1)/(PhysConst::Rgas*(pow(T1,2))); // Must be (kg K-1)
+    double deltaX = 0.622*PhysConst::Ls*Qs(air_pressure, T1)/(PhysConst::Rgas*(math::fast::ipow<2>(T1))); // Must be (kg K-1)
 
     double q = (rh/100)*Qs(air_pressure, T1); // specific humidity (kg/kg)
 
     // snow surface temperature of snow in canopy
-    Ts = T1 + (Snow::emiss*(ilwr - PhysConst::sbc*pow(T1, 4.0)) + PhysConst::Ls*(q - Qs(air_pressure, T1))*rho/ra)/
-              (4.0*Snow::emiss*PhysConst::sbc*pow(T1, 3.0) + (PhysConst::Cp + PhysConst::Ls*deltaX)*rho/ra);
+    Ts = T1 + (Snow::emiss*(ilwr - PhysConst::sbc*math::fast::ipow<4>(T1)) + PhysConst::Ls*(q - Qs(air_pressure, T1))*rho/ra)/
+              (4.0*Snow::emiss*PhysConst::sbc*math::fast::ipow<3>(T1) + (PhysConst::Cp + PhysConst::Ls*deltaX)*rho/ra);
 
     Ts -= mio::Cst::t_water_freezing_pt; // K to C
 
@@ -227,7 +227,7 @@ void Simple_Canopy::run(mesh_elem &face)
             Kstar_H = iswr * (1.0 - Alpha_c - Tauc * (1.0 - Albedo)); //  what is Kstar_H???
 
             // Incident long-wave at surface, "(W/m^2)"
-            Qlisn = ilwr * Vf_ + (1.0 - Vf_) * Vegetation::emiss_c * PhysConst::sbc * pow(T1, 4.0) + B_canopy * Kstar_H;
+            Qlisn = ilwr * Vf_ + (1.0 - Vf_) * Vegetation::emiss_c * PhysConst::sbc * math::fast::ipow<4>(T1) + B_canopy * Kstar_H;
 
             // Incident short-wave at surface, "(W/m^2)"
             Qsisn = iswr * Tauc;
@@ -290,7 +290,7 @@ void Simple_Canopy::run(mesh_elem &face)
 
         Qlisn = Vgap * ilwr + (1.0 - Vgap) * ((ilwr * Tau_b_gap +
                                                (1.0 - Tau_b_gap) * Vegetation::emiss_c * PhysConst::sbc *
-                                               pow(T1, 4.0f)) + B_canopy * Kd);
+                                               math::fast::ipow<4>(T1)) + B_canopy * Kd);
 
         Qsisn = cosxs * Qdfo * Tau_b_gap + Vgap * (iswr - Qdfo) + (1.0 - Vgap) * Tau_d * (iswr - Qdfo);
         if (Qsisn < 0.0)
@@ -26,6 +26,7 @@
 #include <boost/shared_ptr.hpp>
 #include "logger.hpp"
 #include "module_base.hpp"
+#include "math/fast_math.hpp"
 #include <meteoio/MeteoIO.h>
 #include <physics/Atmosphere.h>
 #include <physics/PhysConst.h>
@@ -33,6 +33,8 @@ Walcek_cloud::Walcek_cloud(config_file cfg)
 //    depends("t_lapse_rate");
  //   depends("Td_lapse_rate");
 
+    block_kernel();
+
 
     SPDLOG_DEBUG("Successfully instantiated module {}",this->ID);
 }
@@ -41,7 +43,7 @@ Walcek_cloud::~Walcek_cloud()
 
 };
 
-void Walcek_cloud::run(mesh_elem& face)
+void Walcek_cloud::run(face_range& range)
 {
     //Kunkel RH lapse rates
     // 1/km
@@ -63,44 +65,28 @@ void Walcek_cloud::run(mesh_elem& face)
 
     double press_ratio = 0.7;
 
-
-    double Ta = (*face)["t"_s];
-    double Rh = (*face)["rh"_s];
-
-//    double Td = mio::Atmosphere::RhtoDewPoint(Rh/100.0,Ta+273.15,false);
-//
-//
-//    double z = face->get_z();
-//    double dz = z - 3000.0;// assume 700mb is at 3000m
-//
-//    double Td_lapse_rate = (*face)["Td_lapse_rate"_s];
-//    double T_lapse_rate = (*face)["t_lapse_rate"_s];
-//
-//    double Td_700 = Td + Td_lapse_rate * dz;
-//    double Tair_700 = Ta + T_lapse_rate * dz;
-//
-//    double rh_700 = mio::Atmosphere::DewPointtoRh(Td_700,Tair_700+273.15 ,false);
-
     double lapse = lapse_rates[global_param->month() - 1] / 1000.0; // -> 1/m
-    double rh_700 = Rh * exp(lapse*(3000.0-face->get_z()));
-
-    rh_700 /= 100.0;//factional
-
-
-    //bound RH
-    rh_700 = std::min(1.0,rh_700);
-    rh_700 = std::max(0.0,rh_700);
 
     double dx = 80.0;
     double f_max = 78.0 + dx/15.5; //eqn (2)
     double f_100 = f_max * (press_ratio - 0.1) / 0.6 / 100.0; // eqn (3)
     double one_minus_RHe = 0.196 + (0.76-dx/2834.0) * (1.0 - press_ratio); // eqn (5)
 
+    const double* Rh = range.in("rh"_s);
+    const double* z = range.z();
+    double* cloud_frac = range.out("cloud_frac"_s);
 
-    double cloud_frac = f_100 * exp((rh_700 - 1.0)/one_minus_RHe);
-    cloud_frac = std::min(cloud_frac,1.0);
+    for (size_t k = 0; k < range.size(); ++k)
+    {
+        double rh_700 = Rh[k] * exp(lapse*(3000.0-z[k]));
 
+        rh_700 /= 100.0;//factional
 
-    (*face)["cloud_frac"_s]=cloud_frac;
+        //bound RH
+        rh_700 = std::min(1.0,rh_700);
+        rh_700 = std::max(0.0,rh_700);
 
+        double cf = f_100 * exp((rh_700 - 1.0)/one_minus_RHe);
+        cloud_frac[k] = std::min(cf,1.0);
+    }
 }
@@ -57,6 +57,6 @@ REGISTER_MODULE_HPP(Walcek_cloud);
 public:
     Walcek_cloud(config_file cfg);
     ~Walcek_cloud();
-    virtual void run(mesh_elem& face);
+    virtual void run(face_range& range);
 
 };
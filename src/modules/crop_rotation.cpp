@@ -28,6 +28,8 @@ crop_rotation::crop_rotation(config_file cfg)
         : module_base("crop_rotation", parallel::data, cfg)
 {
     provides_parameter("crop");
+
+    block_kernel();
 }
 
 crop_rotation::~crop_rotation()
@@ -35,14 +37,17 @@ crop_rotation::~crop_rotation()
 
 }
 
-void crop_rotation::run(mesh_elem& face)
+void crop_rotation::run(face_range& range)
 {
 
     int year = global_param->year();
 
-    if(year % 2 == 0)
-        face->parameter("crop"_s) = face->parameter("annual_crop_inventory_1"_s);
-    else
-        face->parameter("crop"_s) = face->parameter("annual_crop_inventory_2"_s);
+    const double* inventory = year % 2 == 0 ? range.parameter("annual_crop_inventory_1"_s)
+                                            : range.parameter("annual_crop_inventory_2"_s);
+    double* crop = range.parameter_out("crop"_s);
 
+    for (size_t k = 0; k < range.size(); ++k)
+    {
+        crop[k] = inventory[k];
+    }
 }
@@ -60,6 +60,6 @@ public:
 
     ~crop_rotation();
 
-    void run(mesh_elem &face);
+    void run(face_range& range);
 
 };
@@ -53,10 +53,10 @@ void Cullen_monthly_llra_ta::init(mesh& domain)
     }
 
 }
-void Cullen_monthly_llra_ta::run(mesh_elem& face)
+void Cullen_monthly_llra_ta::pre_timestep()
 {
-
-    double lapse_rate = -9999;
+    // the lapse rate only depends on the month, so select it once per timestep instead of per face
+    lapse_rate = -9999;
 
     switch(global_param->month())
     {
@@ -98,8 +98,10 @@ void Cullen_monthly_llra_ta::run(mesh_elem& face)
             break;
 
     }
+}
 
-
+void Cullen_monthly_llra_ta::run(mesh_elem& face)
+{
     //lower all the station values to sea level prior to the interpolation
     std::vector< boost::tuple<double, double, double> > lowered_values;
     for (auto& s : face->stations())
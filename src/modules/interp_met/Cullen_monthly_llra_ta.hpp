@@ -64,10 +64,14 @@ public:
     ~Cullen_monthly_llra_ta();
     virtual void run(mesh_elem& face);
     virtual void init(mesh& domain);
+    virtual void pre_timestep();
     struct data : public face_info
     {
         interpolation interp;
     };
+
+    // current month's lapse rate, set by pre_timestep
+    double lapse_rate;
 };
 
 /**
@@ -56,9 +56,8 @@ void Kunkel_monthlyTd_rh::init(mesh& domain)
     }
 
 }
-void Kunkel_monthlyTd_rh::run(mesh_elem& face)
+void Kunkel_monthlyTd_rh::pre_timestep()
 {
-//    size_t ID = face->_debug_ID;
     // 1/km
     double lapse_rates[] = {
             0.41,
@@ -75,8 +74,12 @@ void Kunkel_monthlyTd_rh::run(mesh_elem& face)
             0.4
     } ;
 
-    double lapse = lapse_rates[ global_param->month() - 1 ] / 1000.; // -> 1/m
+    lapse = lapse_rates[ global_param->month() - 1 ] / 1000.; // -> 1/m
+}
 
+void Kunkel_monthlyTd_rh::run(mesh_elem& face)
+{
+//    size_t ID = face->_debug_ID;
     //taken from mio
     const double  Bw = 17.502, Cw = 240.97; //parameters for water
     const double Bi = 22.452, Ci = 272.55; //parameters for ice
@@ -67,8 +67,12 @@ public:
     ~Kunkel_monthlyTd_rh();
     virtual void run(mesh_elem& face);
     virtual void init(mesh& domain);
+    virtual void pre_timestep();
     struct data : public face_info
     {
         interpolation interp;
     };
+
+    // current month's dew point lapse rate (m^-1), set by pre_timestep
+    double lapse;
 };
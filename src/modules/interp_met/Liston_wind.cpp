@@ -47,6 +47,9 @@ Liston_wind::Liston_wind(config_file cfg)
     provides_parameter("Liston_curvature");
     distance = cfg.get<double>("distance",300);
     Ww_coeff = cfg.get<double>("Ww_coeff",1.0);
+    smoothing_passes = cfg.get("smoothing_passes",1);
+
+    thread_safe_init();
 
     SPDLOG_DEBUG("Successfully instantiated module {}",this->ID);
 }
@@ -65,7 +68,7 @@ void Liston_wind::init(mesh& domain)
         auto face = domain->face(i);
         auto& d = face->make_module_data<lwinddata>(ID);
         d.interp.init(global_param->interp_algorithm,face->stations().size() );
-        d.interp_smoothing.init(interp_alg::tpspline,3,{ {"reuse_LU","true"}});
+        d.smoothing.init(face);
 
         face->coloured = false;
 
@@ -295,41 +298,25 @@ void Liston_wind::run(mesh& domain)
         face->set_face_vector("wind_direction",v3);
     }
 
-    // Need to access U_R from neighbors
-    domain->ghost_neighbors_communicate_variable("U_R"_s);
-
-#pragma omp parallel for
-    for (size_t i = 0; i < domain->size_faces(); i++)
+    for (int pass = 0; pass < smoothing_passes; pass++)
     {
+        // Need to access U_R from neighbors
+        domain->ghost_neighbors_communicate_variable("U_R"_s);
 
-        auto face = domain->face(i);
-        std::vector<boost::tuple<double, double, double> > u;
-        for (size_t j = 0; j < 3; j++)
+#pragma omp parallel for
+        for (size_t i = 0; i < domain->size_faces(); i++)
         {
-           auto neigh = face->neighbor(j);
-           if (neigh != nullptr)
-             u.push_back(boost::make_tuple(neigh->get_x(), neigh->get_y(), (*neigh)["U_R"_s]));
+            auto face = domain->face(i);
+            auto& d = face->get_module_data<lwinddata>(ID);
+            d.temp_u = d.smoothing.apply(face, "U_R"_s);
         }
 
-        double new_u = (*face)["U_R"_s];
-        if(u.size() > 0)
+#pragma omp parallel for
+        for (size_t i = 0; i < domain->size_faces(); i++)
         {
-           auto query = boost::make_tuple(face->get_x(), face->get_y(), face->get_z());
-           new_u = face->get_module_data<lwinddata>(ID).interp_smoothing(u, query);
+            auto face = domain->face(i);
+            (*face)["U_R"_s]=face->get_module_data<lwinddata>(ID).temp_u;
         }
-
-        face->get_module_data<lwinddata>(ID).temp_u = new_u;
-
-    }
-
-
-#pragma omp parallel for
-    for (size_t i = 0; i < domain->size_faces(); i++)
-    {
-
-        auto face = domain->face(i);
-        (*face)["U_R"_s]=face->get_module_data<lwinddata>(ID).temp_u;
-
     }
 
 }
@@ -27,6 +27,7 @@
 #include "triangulation.hpp"
 #include "module_base.hpp"
 #include "math/coordinates.hpp"
+#include "neighbor_stencil.hpp"
 #include <cstdlib>
 #include <string>
 
@@ -65,7 +66,8 @@
  *       "distance": 300,
  *       "Ww_coeff: 1,
  *       "ys": 0.5,
- *       "yc": 0.5
+ *       "yc": 0.5,
+ *       "smoothing_passes": 1
  *    }
  *
  * .. confval:: distance
@@ -96,6 +98,13 @@
  *
  *    Curvature weight. Valid range [0,1]. The value of 0.5 gives equal weight to slope and curvature
  *
+ * .. confval:: smoothing_passes
+ *
+ *    :type: int
+ *    :default: 1
+ *
+ *    Number of times the final windspeed is smoothed with a thin plate spline through the edge neighbours' values
+ *
  * \endrst
  *
  * **References:**
@@ -122,8 +131,9 @@ public:
         double corrected_theta;
         double W;
         double temp_u;
-        interpolation interp_smoothing;
+        neighbor_stencil smoothing;
     };
     double distance;
     double Ww_coeff;
+    int smoothing_passes;
 };
@@ -48,6 +48,7 @@ MS_wind::MS_wind(config_file cfg)
 
     speedup_height = cfg.get("speedup_height",2.0);
     use_ryan_dir = cfg.get("use_ryan_dir",false);
+    smoothing_passes = cfg.get("smoothing_passes",1);
     SPDLOG_DEBUG("Successfully instantiated module {}",this->ID);
 }
 
@@ -61,11 +62,35 @@ void MS_wind::init(mesh& domain)
 
          auto& d = face->make_module_data<data>(ID);
          d.interp.init(global_param->interp_algorithm,face->stations().size() );
-         d.interp_smoothing.init(interp_alg::tpspline,3,{ {"reuse_LU","true"}});
+         d.smoothing.init(face);
     }
 }
 
 
+void MS_wind::smooth_U_R(mesh& domain)
+{
+    for (int pass = 0; pass < smoothing_passes; pass++)
+    {
+        // Need to access U_R from neighbors
+        domain->ghost_neighbors_communicate_variable("U_R"_s);
+
+        #pragma omp parallel for
+        for (size_t i = 0; i < domain->size_faces(); i++)
+        {
+            auto face = domain->face(i);
+            auto& d = face->get_module_data<data>(ID);
+            d.temp_u = d.smoothing.apply(face, "U_R"_s);
+        }
+
+        #pragma omp parallel for
+        for (size_t i = 0; i < domain->size_faces(); i++)
+        {
+            auto face = domain->face(i);
+            (*face)["U_R"_s]= std::max(0.1, face->get_module_data<data>(ID).temp_u);
+        }
+    }
+}
+
 void MS_wind::run(mesh& domain)
 {
     if(!use_ryan_dir)
@@ -163,73 +188,7 @@ void MS_wind::run(mesh& domain)
 
         }
 
-	// Need to access U_R from neighbors
-	domain->ghost_neighbors_communicate_variable("U_R"_s);
-
-        #pragma omp parallel for
-        for (size_t i = 0; i < domain->size_faces(); i++)
-        {
-          auto face = domain->face(i);
-
-          std::vector<boost::tuple<double, double, double>> u;
-          for (size_t j = 0; j < 3; j++)
-          {
-            auto neigh = face->neighbor(j);
-
-            if (neigh != nullptr)
-            {
-                try
-                {
-                    u.push_back(boost::make_tuple(neigh->get_x(), neigh->get_y(), (*neigh)["U_R"_s]));
-                }
-                catch (...)
-                {
-                    SPDLOG_DEBUG("face global id {}",face->cell_global_id);
-                    SPDLOG_DEBUG("face is ghost? {}",face->is_ghost);
-                    SPDLOG_DEBUG("neigh that caused problem has global id {}",neigh->cell_global_id);
-                    SPDLOG_DEBUG("face neighbors are {}",face->is_ghost);
-                    for(int i = 0; i < 3; i++)
-                    {
-                        auto neigh = face->neighbor(i);
-                        if (neigh != nullptr)
-                        {
-                            SPDLOG_DEBUG("\tneigh {} global id {}", i, neigh->cell_global_id);
-                            SPDLOG_DEBUG("\tneigh {} local id {}", i, neigh->cell_local_id);
-                            SPDLOG_DEBUG("\tneigh {} is ghost? {}",i, neigh->is_ghost);
-                        }
-                        else
-                        {
-                            SPDLOG_DEBUG("\tneigh {} is nullptr", i);
-                        }
-                    }
-
-                    CHM_THROW_EXCEPTION(module_error, "RIP");
-                }
-            }
-
-          }
-
-          double new_u = (*face)["U_R"_s];
-
-          if (u.size() > 0)
-          {
-            auto query =
-                boost::make_tuple(face->get_x(), face->get_y(), face->get_z());
-            new_u = face->get_module_data<data>(ID).interp_smoothing(u, query);
-          }
-
-          face->get_module_data<data>(ID).temp_u = new_u;
-        }
-
-
-
-        #pragma omp parallel for
-        for (size_t i = 0; i < domain->size_faces(); i++)
-        {
-            auto face = domain->face(i);
-
-		     (*face)["U_R"_s]= std::max(0.1, face->get_module_data<data>(ID).temp_u);
-        }
+        smooth_U_R(domain);
 
     }else
     {
@@ -364,43 +323,7 @@ void MS_wind::run(mesh& domain)
 
         }
 
-    // Need to access U_R from neighbors
-    domain->ghost_neighbors_communicate_variable("U_R"_s);
-
-    #pragma omp parallel for
-        for (size_t i = 0; i < domain->size_faces(); i++)
-        {
-
-            auto face = domain->face(i);
-
-		     std::vector<boost::tuple<double, double, double> > u;
-		     for (size_t j = 0; j < 3; j++)
-		     {
-		       auto neigh = face->neighbor(j);
-		       if (neigh != nullptr)
-			 u.push_back(boost::make_tuple(neigh->get_x(), neigh->get_y(),(*neigh)["U_R"_s]));
-		     }
-
-
-		     double new_u = (*face)["U_R"_s];
-		     if (u.size() > 0)
-		     {
-		       auto query = boost::make_tuple(face->get_x(), face->get_y(), face->get_z());
-		       new_u = face->get_module_data<data>(ID).interp_smoothing(u, query);
-		     }
-
-		     face->get_module_data<data>(ID).temp_u = new_u;
-
-        }
-
-    #pragma omp parallel for
-        for (size_t i = 0; i < domain->size_faces(); i++)
-        {
-            auto face = domain->face(i);
-
-		     (*face)["U_R"_s]= std::max(0.1,face->get_module_data<data>(ID).temp_u) ;
-
-        }
+        smooth_U_R(domain);
 
     }
 }
@@ -27,6 +27,7 @@
 #include "triangulation.hpp"
 #include "module_base.hpp"
 #include "math/coordinates.hpp"
+#include "neighbor_stencil.hpp"
 #include <physics/Atmosphere.h>
 #include <cstdlib>
 #include <string>
@@ -67,7 +68,8 @@
  *
  *    {
  *       "speedup_height": 2.0,
- *       "use_ryan_dir", false
+ *       "use_ryan_dir", false,
+ *       "smoothing_passes": 1
  *    }
  *
  * .. confval:: speedup_height
@@ -83,6 +85,13 @@
  *    :default: false
  *
  *    Instead of using the _u and _v components to compute direction perturbation, use the algorithm of Ryan as per Liston and Elder (2006)
+ *
+ * .. confval:: smoothing_passes
+ *
+ *    :type: int
+ *    :default: 1
+ *
+ *    Number of times the final windspeed is smoothed with a thin plate spline through the edge neighbours' values
  * \endrst
  *
  * **Reference:**
@@ -110,9 +119,13 @@ public:
         double corrected_theta;
         double W;
         double temp_u;
-        interpolation interp_smoothing;
+        neighbor_stencil smoothing;
     };
     double distance;
     bool use_ryan_dir;
     double speedup_height; // height at which the speedup is for
+    int smoothing_passes;
+
+    // smooths U_R over the neighbours smoothing_passes times
+    void smooth_U_R(mesh& domain);
 };
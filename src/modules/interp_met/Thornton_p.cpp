@@ -51,7 +51,7 @@ void Thornton_p::init(mesh& domain)
     }
 
 }
-void Thornton_p::run(mesh_elem& face)
+void Thornton_p::pre_timestep()
 {
     //km^-1
     double monthly_factors[] = {0.35, 0.35, 0.35, 0.30, 0.25, 0.20, 0.20, 0.20, 0.20, 0.25, 0.30, 0.35};
@@ -59,6 +59,12 @@ void Thornton_p::run(mesh_elem& face)
     {
         mf /= 1000.0; //to m^-1
     }
+
+    lapse = monthly_factors[global_param->month() - 1];
+}
+
+void Thornton_p::run(mesh_elem& face)
+{
     std::vector< boost::tuple<double, double, double> > ppt;
     std::vector< boost::tuple<double, double, double> > staion_z;
     for (auto& s : face->stations())
@@ -77,9 +83,6 @@ void Thornton_p::run(mesh_elem& face)
     double z = face->get_z();
     double slp = face->slope();
 
-    int month = global_param->month()-1;
-    double lapse = monthly_factors[month];
-
     double P = p0*( (1+lapse*(z-z0))/(1-lapse*(z-z0)));
   //  P = std::max(0.0,P);
 
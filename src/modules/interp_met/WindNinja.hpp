@@ -176,7 +176,6 @@ public:
         double corrected_theta;
         double W;
         double temp_u;
-        interpolation interp_smoothing;
         double W_transf;
     };
     double distance;
@@ -52,7 +52,7 @@ void kunkel_rh::init(mesh& domain)
     }
 
 }
-void kunkel_rh::run(mesh_elem &face)
+void kunkel_rh::pre_timestep()
 {
     // 1/km
     double lapse_rates[] =
@@ -70,7 +70,11 @@ void kunkel_rh::run(mesh_elem &face)
              -0.07
             };
 
-    double lapse = lapse_rates[global_param->month() - 1] / 1000.0; // -> 1/m
+    lapse = lapse_rates[global_param->month() - 1] / 1000.0; // -> 1/m
+}
+
+void kunkel_rh::run(mesh_elem &face)
+{
     std::vector<boost::tuple<double, double, double> > lowered_values;
     for (auto &s : face->stations())
     {
@@ -57,8 +57,12 @@ public:
 
     virtual void run(mesh_elem &face);
     virtual void init(mesh& domain);
+    virtual void pre_timestep();
     struct data : public face_info
     {
         interpolation interp;
     };
+
+    // current month's rh lapse rate (m^-1), set by pre_timestep
+    double lapse;
 };
@@ -49,9 +49,8 @@ void p_lapse::init(mesh& domain)
         d.interp.init(global_param->interp_algorithm,face->stations().size() );
     }
 }
-void p_lapse::run(mesh_elem& face)
+void p_lapse::pre_timestep()
 {
-
     // Precipitation lapse rate derived from Marmot Creek stations by Logan Fang (used in CRHM for Marmot Creek domain)
     //(100 m)^-1
     double monthly_factors[] = {0.1081,0.1081 ,0.1081, 0.0997, 0.0997, 0.0592, 0.0592, 0.0592, 0.0868, 0.0868, 0.1081, 0.1081};
@@ -67,6 +66,12 @@ void p_lapse::run(mesh_elem& face)
     {
         mf /= 100.0; //to m^-1
     }
+
+    lapse = monthly_factors[global_param->month() - 1];
+}
+
+void p_lapse::run(mesh_elem& face)
+{
     std::vector< boost::tuple<double, double, double> > ppt;
     std::vector< boost::tuple<double, double, double> > staion_z;
     for (auto& s : face->stations())
@@ -85,8 +90,6 @@ void p_lapse::run(mesh_elem& face)
     double z = face->get_z();
     double slp = face->slope();
 
-    int month = global_param->month()-1;
-    double lapse = monthly_factors[month];
     double adj_fac = 1. + lapse*(z-z0);
 
     // Limit the precipitation-elevation adjustment factor in the range 0.5 - 1.5
@@ -85,6 +85,7 @@ public:
     ~p_lapse();
     virtual void run(mesh_elem& face);
     virtual void init(mesh& domain);
+    virtual void pre_timestep();
     struct data : public face_info
     {
         interpolation interp;
@@ -93,4 +94,6 @@ public:
     // Correct precipitation input using triangle slope when input preciptation are given for the horizontally projected area.
     bool apply_cosine_correction;
 
+    // current month's precipitation lapse rate (m^-1), set by pre_timestep
+    double lapse;
 };
@@ -67,11 +67,13 @@ void t_monthly_lapse::init(mesh& domain)
     MLR[11]=cfg.get("MLR_12",0.0049);
 
 }
-void t_monthly_lapse::run(mesh_elem& face)
+void t_monthly_lapse::pre_timestep()
 {
+    lapse_rate = MLR[global_param->month()-1];
+}
 
-    double lapse_rate = MLR[global_param->month()-1];
-
+void t_monthly_lapse::run(mesh_elem& face)
+{
     //lower all the station values to sea level prior to the interpolation
     std::vector< boost::tuple<double, double, double> > lowered_values;
     for (auto& s : face->stations())
@@ -94,9 +94,13 @@ public:
     ~t_monthly_lapse();
     virtual void run(mesh_elem& face);
     virtual void init(mesh& domain);
+    virtual void pre_timestep();
     struct data : public face_info
     {
         interpolation interp;
     };
     double MLR[12];
+
+    // current month's lapse rate from MLR, set by pre_timestep
+    double lapse_rate;
 };
@@ -23,6 +23,8 @@
 
 #pragma once
 
+#include <functional>
+#include <map>
 #include <string>
 #include <boost/shared_ptr.hpp>
 #include <boost/property_tree/ptree.hpp>
@@ -30,6 +32,7 @@
 namespace pt = boost::property_tree;
 
 #include "triangulation.hpp"
+#include "face_range.hpp"
 #include "global.hpp"
 #include "timeseries/netcdf.hpp"
 #include "factory.hpp"
@@ -242,6 +245,16 @@ public:
     {
     };
 
+    /**
+    * Optional block kernel for data parallel modules, called instead of run(mesh_elem&) if the module calls
+    * block_kernel() in its constructor. Computes a contiguous block of faces at once from the per-block arrays of
+    * the face_range, which allows a simple module to be written as a loop the compiler can vectorize.
+    * \param range The faces to be worked upon
+    */
+    virtual void run(face_range& range)
+    {
+    };
+
     /*
      * Needs to be implemented by each  domain parallel module. This will be called and executed for each timestep. Unique to domain parallel modules.
      * \param domain The entier terrain mesh
@@ -260,6 +273,15 @@ public:
 
     };
 
+    /**
+    * Optional hook called once per timestep, serially, before the module's chunk is run. Used to compute values that
+    * are the same for every face, e.g., the current month's lapse rate, so that run(mesh_elem&) only reads them.
+    * Members set here are read concurrently by the face loop and must not be written from run(mesh_elem&).
+    */
+    virtual void pre_timestep()
+    {
+    };
+
     /*
      * Returns the module's parallel type
      * \return the parallel type
@@ -347,6 +369,27 @@ public:
     }
 
 
+    /**
+     * Set an output only diagnostic variable that this module provides. Instead of being set in run, fn is evaluated
+     * for each face, in parallel, only on timesteps when an output writes the variable, just before the output
+     * happens. fn may read the face's variables and this module's face data, but must not write them. No other
+     * module may depend on a diagnostic. As fn runs after all modules, face variables may have since been changed by
+     * a module that runs later, so anything run() used that can change should be kept in the module's face data.
+     */
+    void provides_diagnostic(const std::string& name, std::function<double(mesh_elem&)> fn)
+    {
+        provides(name, SpatialType::local);
+        _diagnostics[name] = fn;
+    }
+
+    /**
+    * The output only diagnostics this module provides
+    */
+    const std::map<std::string, std::function<double(mesh_elem&)>>& diagnostics()
+    {
+        return _diagnostics;
+    }
+
     /**
      * Set a parameter that this module provides
      */
@@ -466,6 +509,10 @@ public:
     void set_optional_found(const std::string& variable)
     {
         _optional_found[variable]=true;
+
+        // cached so that snow_free() doesn't do a lookup per face
+        if (_skip_if_snow_free && variable == "p_snow")
+            _snow_free_p_snow = true;
     }
 
     bool is_nan(const double& variable)
@@ -502,8 +549,110 @@ public:
         return is;
     }
 
+    /**
+     * Call in the constructor, after depends(), if evaluating this module on a snow-free face is a fixed point, i.e.,
+     * running it again changes no outputs and no module state. Core will then not run the module on faces, or for a
+     * block kernel on whole blocks of faces, for which snow_free() is true. Disabled by the snow_free_fast_path option.
+     *
+     * Only valid for data parallel modules. snow_variable is the snow state the module depends on, swe or snowdepthavg,
+     * and has to be one of its depends(). p_snow is added as an optional if it is not a dependency already, so that
+     * snowfall this timestep is known before the module runs.
+     */
+    void skip_if_snow_free(const std::string& snow_variable = "swe")
+    {
+        _skip_if_snow_free = true;
+        _snow_free_variable = xxh64::hash(snow_variable.c_str(), snow_variable.length());
+
+        bool has_variable = false;
+        for (auto& itr : *_depends)
+        {
+            has_variable = has_variable || itr.name == snow_variable;
+            _snow_free_p_snow = _snow_free_p_snow || itr.name == "p_snow";
+        }
+
+        if (!has_variable)
+            BOOST_THROW_EXCEPTION(module_error() << errstr_info(ID + " skips snow-free faces but does not depend on " + snow_variable));
+
+        if (!_snow_free_p_snow)
+            optional("p_snow");
+    }
+
+    bool skips_if_snow_free()
+    {
+        return _skip_if_snow_free;
+    }
+
+    /**
+     * Call in the constructor if the module implements run(face_range&). Core then calls it for blocks of faces
+     * instead of calling run(mesh_elem&) per face. The block kernel must handle water, snow-free, etc. faces itself;
+     * with skip_if_snow_free() only whole snow-free blocks are skipped.
+     */
+    void block_kernel()
+    {
+        _block_kernel = true;
+    }
+
+    bool has_block_kernel()
+    {
+        return _block_kernel;
+    }
+
+    /**
+     * Call in the constructor if init() can run at the same time as other modules' init(). That is, it only writes
+     * this module's face data and the face variables and parameters it owns, and does no MPI communication.
+     * Core then runs it concurrently with other such modules once the modules it depends on are initialized.
+     */
+    void thread_safe_init()
+    {
+        _thread_safe_init = true;
+    }
+
+    bool has_thread_safe_init()
+    {
+        return _thread_safe_init;
+    }
+
+    /**
+     * True if this face ended the previous timestep without snow, has no snowfall this timestep, and the snow variable
+     * given to skip_if_snow_free() is still not positive. As the module depends on that variable, it has already been
+     * updated for this timestep, including any drift or avalanche deposition.
+     */
+    bool snow_free(mesh_elem& face)
+    {
+        if (!face->snow_free)
+            return false;
+
+        if (_snow_free_p_snow && (*face)["p_snow"_s] > 0)
+            return false;
+
+        return (*face)[_snow_free_variable] <= 0;
+    }
+
+    /**
+     * True if snow_free() holds for every face of the block [begin, end), which has to be one of the blocks the
+     * domain's snow_free flags were last updated for. Lets core skip a block kernel, or a whole block of faces, at once.
+     */
+    bool snow_free(triangulation& domain, size_t begin, size_t end)
+    {
+        if (!domain.snow_free_block(begin, end))
+            return false;
+
+        for (size_t i = begin; i < end; i++)
+        {
+            auto face = domain.face(i);
+            if (!snow_free(face))
+                return false;
+        }
+        return true;
+    }
+
 protected:
     parallel _parallel_type;
+    bool _skip_if_snow_free = false;
+    uint64_t _snow_free_variable = 0; // hash of the snow variable checked by snow_free()
+    bool _snow_free_p_snow = false;   // p_snow is available to snow_free()
+    bool _thread_safe_init = false;
+    bool _block_kernel = false;
     boost::shared_ptr<std::vector<variable_info>> _provides;
     boost::shared_ptr<std::vector<std::string>> _provides_parameters;
     boost::shared_ptr<std::vector<variable_info>> _depends;
@@ -518,6 +667,8 @@ protected:
 
     // lists the options that were found
     std::map<std::string, bool> _optional_found;
+
+    std::map<std::string, std::function<double(mesh_elem&)>> _diagnostics;
 };
 
 /**
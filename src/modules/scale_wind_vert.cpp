@@ -154,7 +154,7 @@ void scale_wind_vert::init(mesh& domain)
       // Exception throwing from OpenMP needs to be here
 
        auto& data = face->make_module_data<d>(ID);
-       data.interp.init(interp_alg::tpspline,3,{{"reuse_LU","true"}});
+       data.smoothing.init(face);
 
     }
 
@@ -187,32 +187,9 @@ void scale_wind_vert::run(mesh& domain)
     for (size_t i = 0; i < domain->size_faces(); i++)
     {
         auto face = domain->face(i);
+        auto& data = face->get_module_data<d>(ID);
 
-        std::vector<boost::tuple<double, double, double> > u;
-        for (size_t j = 0; j < 3; j++)
-        {
-            auto neigh = face->neighbor(j);
-
-             if (neigh != nullptr)
-             {
-                 u.push_back(boost::make_tuple(neigh->get_x(), neigh->get_y(), (*neigh)["U_2m_above_srf"_s]));
-             }
-
-        }
-
-        auto query = boost::make_tuple(face->get_x(), face->get_y(), face->get_z());
-
-        if(!u.empty())
-        {
-            double new_u =  face->get_module_data<d>(ID).interp(u, query);
-
-            face->get_module_data<d>(ID).temp_u = std::max(0.1,new_u);
-        }
-        else
-        {
-            face->get_module_data<d>(ID).temp_u = std::max(0.1,(*face)["U_2m_above_srf"_s]);
-        }
-
+        data.temp_u = std::max(0.1, data.smoothing.apply(face, "U_2m_above_srf"_s));
     }
 
 
@@ -26,6 +26,7 @@
 #include <boost/shared_ptr.hpp>
 #include <physics/Atmosphere.h>
 #include "module_base.hpp"
+#include "neighbor_stencil.hpp"
 #include <boost/shared_ptr.hpp>
 #include "logger.hpp"
 #include <string>
@@ -90,6 +91,6 @@ public:
     struct d: public face_info
     {
         double temp_u;
-        interpolation interp;
+        neighbor_stencil smoothing;
     };
 };
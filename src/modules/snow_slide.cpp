@@ -134,12 +134,20 @@ void snow_slide::run(mesh& domain)
 //        domain->ghost_neighbors_communicate_variable("ghost_ss_snowdepthavg_vert_copy"_s);
 //#endif
 
-#pragma omp parallel for
+        // Snow is only moved off faces that exceed their holding depth, and a face can only reach it in this pass by
+        // receiving snow from another face. So if no face exceeds it, the pass moves nothing and the sort can be skipped.
+        // This is the common case for snow-free or shallow snowpacks.
+        int any_over_max = 0;
+
+#pragma omp parallel for reduction(max:any_over_max)
         for (size_t i = 0; i < domain->size_faces(); i++)
         {
             auto face = domain->face(i); // Get face
             auto& data = face->get_module_data<snow_slide::data>(ID); // Get data
 
+            if (data.snowdepthavg_copy > data.maxDepth)
+                any_over_max = 1;
+
             // Use these placeholders to store the copy as we can then access it on the neighbours
             // vert missing as we can reconstruct it easily
             (*face)["ghost_ss_snowdepthavg_to_xfer"] = 0; // snowdepth to transfer this timestep
@@ -174,6 +182,9 @@ void snow_slide::run(mesh& domain)
         domain->ghost_neighbors_communicate_variable("ghost_ss_snowdepthavg_vert_copy"_s);
 #endif
 
+        if (!any_over_max)
+            sorted_z.clear();
+
         // Sort faces by elevation + snowdepth
         tbb::parallel_sort(sorted_z.begin(), sorted_z.end(),
                            [](const std::pair<double, mesh_elem>& a, const std::pair<double, mesh_elem>& b)
@@ -420,6 +431,7 @@ void snow_slide::init(mesh& domain)
     double avalache_pow  = cfg.get("avalache_pow", -1.998); // param from dhiraj
 
     // Initialize for each triangle
+#pragma omp parallel for
     for(size_t i=0;i<domain->size_faces();i++)
     {
         auto face = domain->face(i);
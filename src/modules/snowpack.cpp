@@ -22,6 +22,7 @@
 //
 
 #include "snowpack.hpp"
+#include "timer.hpp"
 REGISTER_MODULE_CPP(Lehning_snowpack);
 
 Lehning_snowpack::Lehning_snowpack(config_file cfg)
@@ -77,6 +78,8 @@ Lehning_snowpack::Lehning_snowpack(config_file cfg)
     provides("MS_TOTALMASS");
     provides("MS_SOIL_RUNOFF");
 
+    // init() is not marked thread safe: SnowpackConfig's constructor fills static maps, which would race with another
+    // module's init() building a SnowpackConfig or reading them
 }
 
 Lehning_snowpack::~Lehning_snowpack()
@@ -299,6 +302,7 @@ void Lehning_snowpack::init(mesh& domain)
 {
     const_T_g = cfg.get("const_T_g",-4.0);
 
+    // serial: SnowpackConfig's constructor fills static maps, so the faces can't build theirs concurrently
     for(size_t i=0;i<domain->size_faces();i++)
     {
         auto face = domain->face(i);
@@ -370,31 +374,264 @@ void Lehning_snowpack::init(mesh& domain)
 
         //addSpecial keys goes here to deal with Antarctica, canopy, and detect grass
 
-        SN_SNOWSOIL_DATA SSdata;
-        SSdata.SoilAlb = cfg.get<double>("sno.SoilAlbedo",0.09);
-        SSdata.Albedo = SSdata.SoilAlb; // following snowpacks' no snow default.
-        SSdata.BareSoil_z0 = cfg.get<double>("sno.BareSoil_z0",0.2);
-        if (SSdata.BareSoil_z0 == 0.)
+        SN_SNOWSOIL_DATA SSdata = snowsoil_data(face);
+
+        d.Xdata = boost::make_shared<SnowStation>(false,false);
+        d.Xdata->initialize(SSdata,0);
+//        d.Xdata->cos_sl = 1;
+//        d.Xdata->windward = false;
+//        d.Xdata->rho_hn = 0;
+//        d.Xdata->hn = 0;
+//        d.Xdata->mH = 0;
+
+        d.sp = boost::make_shared<Snowpack>(*(d.Spackconfig));
+        d.meteo = boost::make_shared<Meteo>( (d.config));
+        d.stability = boost::make_shared<Stability> ( (d.config), false);
+
+        d.sum_subl = 0;
+
+
+    }
+}
+
+namespace
+{
+    // Per element state saved in checkpoints. This follows what SNOWPACK itself saves in .sno files to restart
+    enum layer_field
+    {
+        DEPOSITION_DATE, // local julian date
+        DEPOSITION_TZ,
+        THICKNESS,
+        T_TOP, // temperature of the element's top node
+        THETA_ICE,
+        THETA_WATER,
+        THETA_AIR,
+        THETA_SOIL,
+        SOIL_DENSITY,
+        SOIL_CONDUCTIVITY,
+        SOIL_HEAT_CAPACITY,
+        GRAIN_SIZE,
+        BOND_SIZE,
+        DENDRICITY,
+        SPHERICITY,
+        MARKER,
+        SURFACE_HOAR,
+        STRESS_RATE,
+        METAMORPHISM,
+        N_LAYER_FIELDS
+    };
+    const char* layer_field_names[N_LAYER_FIELDS] = {
+        "depositionDate", "depositionDate_tz", "L", "T", "theta_ice", "theta_water", "theta_air", "theta_soil",
+        "soil_rho", "soil_k", "soil_c", "rg", "rb", "dd", "sp", "mk", "hoar", "CDot", "metamo"};
+
+    // Per face state
+    enum face_field
+    {
+        CUM_PRECIP,
+        SUM_SUBL,
+        T_BOTTOM, // temperature of the bottom node
+        ALBEDO,
+        EROSION_LEVEL,
+        TIME_COUNT_DELTA_HS,
+        N_FACE_FIELDS
+    };
+    const char* face_field_names[N_FACE_FIELDS] = {
+        "cum_precip", "sum_subl", "T_bottom", "Albedo", "ErosionLevel", "TimeCountDeltaHS"};
+}
+
+void Lehning_snowpack::checkpoint(mesh& domain, netcdf& chkpt)
+{
+    if (SnowStation::number_of_solutes > 0)
+    {
+        CHM_THROW_EXCEPTION(module_error, "Checkpointing SNOWPACK solutes is not supported");
+    }
+
+    timer c;
+    c.tic();
+
+    size_t nfaces = domain->size_faces();
+
+    // the elements of face i are [offset[i], offset[i+1]) in the flat per element variables
+    std::vector<unsigned long long> offset(nfaces + 1, 0);
+    for (size_t i = 0; i < nfaces; i++)
+    {
+        auto& d = domain->face(i)->get_module_data<data>(ID);
+        offset[i + 1] = offset[i] + d.Xdata->getNumberOfElements();
+    }
+    size_t nelem = offset[nfaces];
+
+    std::vector<std::vector<double>> layers(N_LAYER_FIELDS, std::vector<double>(nelem));
+    std::vector<std::vector<double>> faces(N_FACE_FIELDS, std::vector<double>(nfaces));
+
+#pragma omp parallel for
+    for (size_t i = 0; i < nfaces; i++)
+    {
+        auto& d = domain->face(i)->get_module_data<data>(ID);
+        auto& X = *(d.Xdata);
+
+        faces[CUM_PRECIP][i] = d.cum_precip;
+        faces[SUM_SUBL][i] = d.sum_subl;
+        faces[T_BOTTOM][i] = X.Ndata[0].T;
+        faces[ALBEDO][i] = X.Albedo;
+        faces[EROSION_LEVEL][i] = X.ErosionLevel;
+        faces[TIME_COUNT_DELTA_HS][i] = X.TimeCountDeltaHS;
+
+        for (size_t e = 0; e < X.getNumberOfElements(); e++)
         {
-            SPDLOG_WARN("[snowpack] BareSoil_z0 == 0, set to 0.2");
-            SSdata.BareSoil_z0 = 0.2;
+            size_t k = offset[i] + e;
+            auto& E = X.Edata[e];
+
+            layers[DEPOSITION_DATE][k] = E.depositionDate.getJulian();
+            layers[DEPOSITION_TZ][k] = E.depositionDate.getTimeZone();
+            layers[THICKNESS][k] = E.L;
+            layers[T_TOP][k] = X.Ndata[e + 1].T;
+            layers[THETA_ICE][k] = E.theta[ICE];
+            layers[THETA_WATER][k] = E.theta[WATER];
+            layers[THETA_AIR][k] = E.theta[AIR];
+            layers[THETA_SOIL][k] = E.theta[SOIL];
+            layers[SOIL_DENSITY][k] = E.soil[SOIL_RHO];
+            layers[SOIL_CONDUCTIVITY][k] = E.soil[SOIL_K];
+            layers[SOIL_HEAT_CAPACITY][k] = E.soil[SOIL_C];
+            layers[GRAIN_SIZE][k] = E.rg;
+            layers[BOND_SIZE][k] = E.rb;
+            layers[DENDRICITY][k] = E.dd;
+            layers[SPHERICITY][k] = E.sp;
+            layers[MARKER][k] = E.mk;
+            layers[SURFACE_HOAR][k] = X.Ndata[e + 1].hoar;
+            layers[STRESS_RATE][k] = E.CDot;
+            layers[METAMORPHISM][k] = E.metamo;
         }
+    }
 
-        SSdata.WindScalingFactor= cfg.get<double>("sno.WindScalingFactor",1);
-        SSdata.TimeCountDeltaHS = cfg.get<double>("sno.TimeCountDeltaHS",0.0);
+    chkpt.put_var1D("snowpack:offset", "snowpack:offset", offset);
+    for (size_t f = 0; f < N_FACE_FIELDS; f++)
+        chkpt.put_var1D(std::string("snowpack:") + face_field_names[f], "tri_id", faces[f]);
+    for (size_t f = 0; f < N_LAYER_FIELDS; f++)
+        chkpt.put_var1D(std::string("snowpack:") + layer_field_names[f], "snowpack:element", layers[f]);
 
+    double mb = (offset.size() * sizeof(unsigned long long) +
+                 (N_FACE_FIELDS * nfaces + N_LAYER_FIELDS * nelem) * sizeof(double)) / (1024.0 * 1024.0);
+    SPDLOG_INFO("[snowpack] Checkpointed {} elements over {} faces, {:.1f} MiB [ {} ms ]", nelem, nfaces, mb,
+                c.toc<ms>());
+}
 
-        SSdata.meta.stationName = cfg.get<std::string>("sno.station_name","chm");
-        SSdata.meta.position.setAltitude(face->get_z());
+void Lehning_snowpack::load_checkpoint(mesh& domain, netcdf& chkpt)
+{
+    timer c;
+    c.tic();
+
+    size_t nfaces = domain->size_faces();
+
+    std::vector<unsigned long long> offset;
+    chkpt.get_var1D("snowpack:offset", offset);
+    if (offset.size() != nfaces + 1)
+    {
+        CHM_THROW_EXCEPTION(module_error, "Checkpoint has SNOWPACK state for " + std::to_string(offset.size() - 1) +
+                                              " faces, expected " + std::to_string(nfaces));
+    }
+    size_t nelem = offset[nfaces];
 
-        SSdata.meta.position.setXY(face->get_x(),face->get_y(),face->get_z());
-        SSdata.meta.setSlope(mio::IOUtils::nodata,mio::IOUtils::nodata);
+    std::vector<std::vector<double>> layers(N_LAYER_FIELDS);
+    std::vector<std::vector<double>> faces(N_FACE_FIELDS);
+    for (size_t f = 0; f < N_FACE_FIELDS; f++)
+        chkpt.get_var1D(std::string("snowpack:") + face_field_names[f], faces[f]);
+    for (size_t f = 0; f < N_LAYER_FIELDS; f++)
+    {
+        chkpt.get_var1D(std::string("snowpack:") + layer_field_names[f], layers[f]);
+        if (layers[f].size() != nelem)
+        {
+            CHM_THROW_EXCEPTION(module_error, std::string("Checkpoint variable snowpack:") + layer_field_names[f] +
+                                                  " has the wrong number of elements");
+        }
+    }
+
+#pragma omp parallel for
+    for (size_t i = 0; i < nfaces; i++)
+    {
+        auto face = domain->face(i);
+        auto& d = face->get_module_data<data>(ID);
+
+        SN_SNOWSOIL_DATA SSdata = snowsoil_data(face);
+
+        // each saved element becomes a layer of one element
+        size_t n = offset[i + 1] - offset[i];
+        SSdata.nLayers = n;
+        SSdata.nN = n + 1;
+        SSdata.Ldata.resize(n, LayerData());
+        SSdata.Height = 0;
+
+        for (size_t e = 0; e < n; e++)
+        {
+            size_t k = offset[i] + e;
+            auto& L = SSdata.Ldata[e];
+
+            L.depositionDate = mio::Date(layers[DEPOSITION_DATE][k], layers[DEPOSITION_TZ][k]);
+            L.hl = layers[THICKNESS][k];
+            L.ne = 1;
+            L.tl = layers[T_TOP][k];
+            L.phiIce = layers[THETA_ICE][k];
+            L.phiWater = layers[THETA_WATER][k];
+            L.phiVoids = layers[THETA_AIR][k];
+            L.phiSoil = layers[THETA_SOIL][k];
+            L.SoilRho = layers[SOIL_DENSITY][k];
+            L.SoilK = layers[SOIL_CONDUCTIVITY][k];
+            L.SoilC = layers[SOIL_HEAT_CAPACITY][k];
+            L.rg = layers[GRAIN_SIZE][k];
+            L.rb = layers[BOND_SIZE][k];
+            L.dd = layers[DENDRICITY][k];
+            L.sp = layers[SPHERICITY][k];
+            L.mk = static_cast<unsigned short int>(layers[MARKER][k]);
+            L.hr = layers[SURFACE_HOAR][k];
+            L.CDot = layers[STRESS_RATE][k];
+            L.metamo = layers[METAMORPHISM][k];
+
+            SSdata.Height += L.hl;
+        }
+
+        SSdata.Albedo = faces[ALBEDO][i];
+        SSdata.ErosionLevel = static_cast<int>(faces[EROSION_LEVEL][i]);
+        SSdata.TimeCountDeltaHS = faces[TIME_COUNT_DELTA_HS][i];
+
+        d.Xdata = boost::make_shared<SnowStation>(false, false);
+        d.Xdata->initialize(SSdata, 0);
+
+        // initialize sets the bottom node to the first layer's top temperature
+        d.Xdata->Ndata[0].T = faces[T_BOTTOM][i];
+
+        d.cum_precip = faces[CUM_PRECIP][i];
+        d.sum_subl = faces[SUM_SUBL][i];
+    }
+
+    SPDLOG_INFO("[snowpack] Loaded {} elements over {} faces from checkpoint [ {} ms ]", nelem, nfaces, c.toc<ms>());
+}
+
+SN_SNOWSOIL_DATA Lehning_snowpack::snowsoil_data(mesh_elem& face)
+{
+    SN_SNOWSOIL_DATA SSdata;
+    SSdata.SoilAlb = cfg.get<double>("sno.SoilAlbedo",0.09);
+    SSdata.Albedo = SSdata.SoilAlb; // following snowpacks' no snow default.
+    SSdata.BareSoil_z0 = cfg.get<double>("sno.BareSoil_z0",0.2);
+    if (SSdata.BareSoil_z0 == 0.)
+    {
+        SPDLOG_WARN("[snowpack] BareSoil_z0 == 0, set to 0.2");
+        SSdata.BareSoil_z0 = 0.2;
+    }
+
+    SSdata.WindScalingFactor= cfg.get<double>("sno.WindScalingFactor",1);
+    SSdata.TimeCountDeltaHS = cfg.get<double>("sno.TimeCountDeltaHS",0.0);
+
+
+    SSdata.meta.stationName = cfg.get<std::string>("sno.station_name","chm");
+    SSdata.meta.position.setAltitude(face->get_z());
+
+    SSdata.meta.position.setXY(face->get_x(),face->get_y(),face->get_z());
+    SSdata.meta.setSlope(mio::IOUtils::nodata,mio::IOUtils::nodata);
 //        SSdata.meta.setSlope(face->slope() * ,face->aspect());
 //        SSdata.meta.setSlope(0,0);
 
-        SSdata.HS_last = 0.; //cfg.get<double>("sno.HS_Last");
+    SSdata.HS_last = 0.; //cfg.get<double>("sno.HS_Last");
 
-        //meta data in *sno files that we don't use
+    //meta data in *sno files that we don't use
 //        cfg.get<std::string>("sno.station_id");
 
 //        cfg.get<double>("sno.latitude");
@@ -407,36 +644,21 @@ void Lehning_snowpack::init(mesh& domain)
 
 
 
-        //assumes no starting layers
-        SSdata.nN = 1;
-        SSdata.Height = 0.;
+    //assumes no starting layers
+    SSdata.nN = 1;
+    SSdata.Height = 0.;
 
-        SSdata.nLayers = 0;// cfg.get("sno.nSoilLayerData",0);
+    SSdata.nLayers = 0;// cfg.get("sno.nSoilLayerData",0);
 //        SSdata.nLayers += cfg.get("sno.nSnowLayerData",0);
 //        SSdata.Ldata
 
 
 
-        SSdata.Canopy_Height = cfg.get<double>("sno.CanopyHeight",0);
-        SSdata.Canopy_LAI = cfg.get<double>("sno.CanopyLeafAreaIndex",0);
-        SSdata.Canopy_Direct_Throughfall = cfg.get<double>("sno.CanopyDirectThroughfall",1);
+    SSdata.Canopy_Height = cfg.get<double>("sno.CanopyHeight",0);
+    SSdata.Canopy_LAI = cfg.get<double>("sno.CanopyLeafAreaIndex",0);
+    SSdata.Canopy_Direct_Throughfall = cfg.get<double>("sno.CanopyDirectThroughfall",1);
 
-        SSdata.ErosionLevel = cfg.get<double>("sno.ErosionLevel",0);
+    SSdata.ErosionLevel = cfg.get<double>("sno.ErosionLevel",0);
 
-        d.Xdata = boost::make_shared<SnowStation>(false,false);
-        d.Xdata->initialize(SSdata,0);
-//        d.Xdata->cos_sl = 1;
-//        d.Xdata->windward = false;
-//        d.Xdata->rho_hn = 0;
-//        d.Xdata->hn = 0;
-//        d.Xdata->mH = 0;
-
-        d.sp = boost::make_shared<Snowpack>(*(d.Spackconfig));
-        d.meteo = boost::make_shared<Meteo>( (d.config));
-        d.stability = boost::make_shared<Stability> ( (d.config), false);
-
-        d.sum_subl = 0;
-
-
-    }
+    return SSdata;
 }
@@ -119,6 +119,18 @@ public:
 
     virtual void init(mesh& domain);
 
+    /**
+     * The layered state is variable length per face, so it is stored as ragged arrays: each per-element quantity is
+     * a single flat variable over all faces' elements, and snowpack:offset gives each face's range of elements.
+     */
+    void checkpoint(mesh& domain, netcdf& chkpt);
+    void load_checkpoint(mesh& domain, netcdf& chkpt);
+
+    /**
+     * The configured snow and soil data of a face, without any layers
+     */
+    SN_SNOWSOIL_DATA snowsoil_data(mesh_elem& face);
+
 
     struct data : public face_info
     {
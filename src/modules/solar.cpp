@@ -31,6 +31,8 @@ solar::solar(config_file cfg)
     provides("solar_az");
 
     provides_parameter("svf");
+
+    thread_safe_init();
 }
 solar::~solar()
 {
@@ -55,15 +57,14 @@ void solar::run(mesh_elem &face)
     //Following the RA DEC to Az Alt conversion sequence explained here:
     //http://www.stargazing.net/kepler/altaz.html
 
-    //UTC offset. Don't know how to use datetime's UTC converter yet....
-    boost::posix_time::time_duration UTC_offset = boost::posix_time::hours(global_param->_utc_offset);
-    std::tm tm = boost::posix_time::to_tm(global_param->posix_time()+UTC_offset);
-    double year =  tm.tm_year + 1900.; //convert from epoch
-    double month =  tm.tm_mon + 1.;//conert jan == 0
-    double day =   tm.tm_mday; //starts at 1, ok
-    double hour = tm.tm_hour; // 0 = midnight, ok
-    double min = tm.tm_min; // 0, ok
-    double sec = tm.tm_sec; // [0,60] in c++11, ok http://en.cppreference.com/w/cpp/chrono/c/tm
+    // date offset by UTC_offset, decomposed once per timestep by global
+    const auto& utc = global_param->now_utc();
+    double year = utc.year;
+    double month = utc.month; // jan == 1
+    double day = utc.day; //starts at 1, ok
+    double hour = utc.hour; // 0 = midnight, ok
+    double min = utc.minute; // 0, ok
+    double sec = utc.second;
     double Alt = face->center().z();//0.; //TODO: fix this?
 
     if (month <= 2.0)
@@ -32,6 +32,11 @@ sub_grid::sub_grid(config_file cfg)
 
     provides("snowcoverfraction");
 
+    block_kernel();
+
+    // a snow-free face always has no snow cover, so a snow-free block has nothing to update
+    skip_if_snow_free("snowdepthavg");
+
     SPDLOG_DEBUG("Successfully instantiated module {}",this->ID);
 }
 
@@ -41,17 +46,13 @@ sub_grid::~sub_grid()
 
 }
 
-void sub_grid::run(mesh_elem &face) {
-
-    double snowdepthavg = (*face)["snowdepthavg"_s];
-    double snowcoverfraction;
+void sub_grid::run(face_range& range)
+{
+    const double* snowdepthavg = range.in("snowdepthavg"_s);
+    double* snowcoverfraction = range.out("snowcoverfraction"_s);
 
-    if(snowdepthavg>0) {
-        snowcoverfraction = 1;
-    } else {
-        snowcoverfraction = 0;
+    for (size_t k = 0; k < range.size(); ++k)
+    {
+        snowcoverfraction[k] = snowdepthavg[k] > 0 ? 1 : 0;
     }
-
-    (*face)["snowcoverfraction"_s]=snowcoverfraction;
-
 }
@@ -36,6 +36,6 @@ public:
 
     ~sub_grid();
 
-    virtual void run(mesh_elem &face);
+    virtual void run(face_range& range);
 
 };
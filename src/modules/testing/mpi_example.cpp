@@ -22,6 +22,19 @@
 //
 
 #include "mpi_example.hpp"
+
+#include <iomanip>
+#include <map>
+#include <sstream>
+
+#ifdef USE_MPI
+#include <boost/mpi/collectives.hpp>
+#include <boost/mpi/communicator.hpp>
+#include <boost/mpi/nonblocking.hpp>
+#include <boost/mpi/timer.hpp>
+#include <boost/serialization/vector.hpp>
+#endif
+
 REGISTER_MODULE_CPP(mpi);
 
 mpi::mpi(config_file cfg)
@@ -29,6 +42,19 @@ mpi::mpi(config_file cfg)
 {
     provides("mpi_rank");
     provides("mpi_ghost_test");
+
+    do_benchmark = cfg.get("benchmark", false);
+    benchmark_iterations = cfg.get("benchmark_iterations", 20);
+    benchmark_max_variables = cfg.get("benchmark_max_variables", 16);
+    benchmark_done = false;
+
+    if (do_benchmark)
+    {
+        if (benchmark_iterations < 1 || benchmark_max_variables < 1)
+        {
+            CHM_THROW_EXCEPTION(module_error, "benchmark_iterations and benchmark_max_variables must be >= 1");
+        }
+    }
 }
 
 mpi::~mpi()
@@ -60,4 +86,170 @@ void mpi::run(mesh& domain)
     // this will set the faces on the remote ranks to be our rank
     // our ghost -> their face
     domain->ghost_to_neighbors_communicate_variable("mpi_ghost_test");
+
+    if (do_benchmark && !benchmark_done)
+    {
+        benchmark(domain);
+        benchmark_done = true;
+    }
+}
+
+void mpi::benchmark(mesh& domain)
+{
+#ifdef USE_MPI
+    // own context so the benchmark messages can't match the model's ghost exchanges
+    boost::mpi::communicator comm(domain->_comm_world, boost::mpi::comm_duplicate);
+
+    // Static description of this rank's halo
+    auto send = domain->ghost_send_sizes();
+    auto recv = domain->ghost_recv_sizes();
+
+    size_t send_faces = 0;
+    for (auto& itr : send)
+        send_faces += itr.second;
+
+    size_t recv_faces = 0;
+    for (auto& itr : recv)
+        recv_faces += itr.second;
+
+    size_t partners = std::max(send.size(), recv.size());
+
+    // 0, 1, 2, 4, ... benchmark_max_variables. Empty messages time the latency alone
+    std::vector<int> nvars = {0};
+    for (int n = 1; n < benchmark_max_variables; n *= 2)
+        nvars.push_back(n);
+    nvars.push_back(benchmark_max_variables);
+
+    // The same pattern as ghost_neighbors_communicate_variable, one message to and from each partner, but with n values
+    // per face packed into each message. Only the message size changes with n, so the fit below separates the per
+    // exchange latency from the bandwidth
+    std::map<int, std::vector<double>> send_buffer, recv_buffer;
+    auto exchange = [&](int n)
+    {
+        std::vector<boost::mpi::request> reqs;
+        for (auto& itr : recv)
+        {
+            auto& buf = recv_buffer[itr.first];
+            buf.resize(itr.second * n);
+            reqs.push_back(comm.irecv(itr.first, 0, buf.data(), static_cast<int>(buf.size())));
+        }
+        for (auto& itr : send)
+        {
+            auto& buf = send_buffer[itr.first];
+            buf.assign(itr.second * n, static_cast<double>(comm.rank()));
+            reqs.push_back(comm.isend(itr.first, 0, buf.data(), static_cast<int>(buf.size())));
+        }
+        boost::mpi::wait_all(reqs.begin(), reqs.end());
+    };
+
+    // mean time of one exchange of n values per face, seconds, and the bytes this rank sends and receives in it
+    std::vector<double> exchange_time;
+    std::vector<double> exchange_bytes;
+    for (auto n : nvars)
+    {
+        // warm up, e.g., lazy connection setup
+        exchange(n);
+
+        comm.barrier();
+        boost::mpi::timer t;
+        for (int it = 0; it < benchmark_iterations; ++it)
+            exchange(n);
+        exchange_time.push_back(t.elapsed() / benchmark_iterations);
+        exchange_bytes.push_back(static_cast<double>(send_faces + recv_faces) * n * sizeof(double));
+    }
+
+    // latency and bandwidth from a least squares fit of time = latency + bytes / bandwidth. The sizes span orders of
+    // magnitude, so the relative error is minimized, i.e., weights of 1/time^2; otherwise the largest messages
+    // decide the intercept and the latency is lost in their noise
+    double latency = exchange_time.front();
+    double bandwidth = 0;
+    if (nvars.size() > 1)
+    {
+        double sw = 0, mx = 0, my = 0;
+        for (size_t i = 0; i < nvars.size(); ++i)
+        {
+            double w = 1.0 / (exchange_time[i] * exchange_time[i]);
+            sw += w;
+            mx += w * exchange_bytes[i];
+            my += w * exchange_time[i];
+        }
+        mx /= sw;
+        my /= sw;
+
+        double sxy = 0, sxx = 0;
+        for (size_t i = 0; i < nvars.size(); ++i)
+        {
+            double w = 1.0 / (exchange_time[i] * exchange_time[i]);
+            sxy += w * (exchange_bytes[i] - mx) * (exchange_time[i] - my);
+            sxx += w * (exchange_bytes[i] - mx) * (exchange_bytes[i] - mx);
+        }
+
+        // no halo, nothing to fit
+        if (sxx > 0)
+        {
+            double per_byte = sxy / sxx;
+            latency = std::max(0.0, my - per_byte * mx);
+            bandwidth = per_byte > 0 ? 1.0 / per_byte : 0;
+        }
+    }
+
+    // rank, partners, ghost (recv) faces, send faces, latency, bandwidth, then the time per variable count
+    std::vector<double> stats = {static_cast<double>(comm.rank()),
+                                 static_cast<double>(partners),
+                                 static_cast<double>(recv_faces),
+                                 static_cast<double>(send_faces),
+                                 latency,
+                                 bandwidth};
+    stats.insert(stats.end(), exchange_time.begin(), exchange_time.end());
+
+    std::vector<std::vector<double>> all_stats;
+    boost::mpi::gather(comm, stats, all_stats, 0);
+
+    if (comm.rank() != 0)
+        return;
+
+    SPDLOG_INFO("Ghost exchange benchmark: {} ranks, {} iterations", comm.size(), benchmark_iterations);
+
+    std::string header = "rank partners ghosts send_faces latency[us] bandwidth[MB/s]";
+    for (auto n : nvars)
+        header += " t(" + std::to_string(n) + "/face)[us]";
+    SPDLOG_INFO(header);
+
+    double mean_ghosts = 0;
+    for (auto& r : all_stats)
+        mean_ghosts += r[2];
+    mean_ghosts /= all_stats.size();
+
+    double sd_ghosts = 0;
+    for (auto& r : all_stats)
+        sd_ghosts += (r[2] - mean_ghosts) * (r[2] - mean_ghosts);
+    sd_ghosts = std::sqrt(sd_ghosts / all_stats.size());
+
+    for (auto& r : all_stats)
+    {
+        std::stringstream line;
+        line << std::fixed << std::setprecision(1)
+             << std::setw(4) << static_cast<int>(r[0]) << " "
+             << std::setw(8) << static_cast<int>(r[1]) << " "
+             << std::setw(6) << static_cast<size_t>(r[2]) << " "
+             << std::setw(10) << static_cast<size_t>(r[3]) << " "
+             << std::setw(11) << r[4] * 1e6 << " "
+             << std::setw(15) << r[5] / 1e6;
+        for (size_t i = 0; i < nvars.size(); ++i)
+            line << " " << std::setw(10) << r[6 + i] * 1e6;
+        SPDLOG_INFO(line.str());
+    }
+
+    SPDLOG_INFO("Ghosts per rank: mean={:.1f} sd={:.1f}", mean_ghosts, sd_ghosts);
+    for (auto& r : all_stats)
+    {
+        if (sd_ghosts > 0 && std::fabs(r[2] - mean_ghosts) > 2 * sd_ghosts)
+        {
+            SPDLOG_WARN("Rank {} has an outlier ghost count: {} (mean {:.1f})",
+                        static_cast<int>(r[0]), static_cast<size_t>(r[2]), mean_ghosts);
+        }
+    }
+#else
+    SPDLOG_WARN("Ghost exchange benchmark requires an MPI build");
+#endif
 }
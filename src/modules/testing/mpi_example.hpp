@@ -35,14 +35,50 @@
  *
  * MPI usage example
  *
+ * Optionally, benchmarks the ghost exchange on the partition being run. On the first timestep, it times an exchange
+ * with the same partners and message pattern as ghost_neighbors_communicate_variable, one message to and from each
+ * partner, with 0, 1, 2, 4, ... values per face packed into each message. Fitting the time against the bytes moved gives,
+ * per rank, the latency and bandwidth of the exchange, which are reported with the number of communication partners
+ * and ghosts. Ranks with an outlier number of ghosts are flagged. This allows partitions and MPI settings to be
+ * evaluated before a long run.
+ *
  * **Depends:**
  * - None
  *
  * **Provides:**
- * - None
+ * - MPI rank that owns the face "mpi_rank"
+ * - Ghost exchange test "mpi_ghost_test"
  *
  * **Configuration:**
- * - None
+ *
+ * .. code:: json
+ *
+ *    {
+ *       "benchmark": false,
+ *       "benchmark_iterations": 20,
+ *       "benchmark_max_variables": 16
+ *    }
+ *
+ * .. confval:: benchmark
+ *
+ *    :type: boolean
+ *    :default: false
+ *
+ *    Run the ghost exchange benchmark on the first timestep
+ *
+ * .. confval:: benchmark_iterations
+ *
+ *    :type: int
+ *    :default: 20
+ *
+ *    Number of timed exchanges per message size
+ *
+ * .. confval:: benchmark_max_variables
+ *
+ *    :type: int
+ *    :default: 16
+ *
+ *    The exchange is timed for 0, 1, 2, 4, ... up to this many values per face in each message
  *
  * **Parameters:**
  * - None
@@ -58,4 +94,14 @@ public:
 
     void run(mesh &domain);
 
+private:
+    /**
+     * Times the ghost exchange and reports the per-rank statistics on rank 0
+     */
+    void benchmark(mesh &domain);
+
+    bool do_benchmark;
+    int benchmark_iterations;
+    int benchmark_max_variables;
+    bool benchmark_done;
 };
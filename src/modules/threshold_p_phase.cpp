@@ -38,6 +38,8 @@ threshold_p_phase::threshold_p_phase(config_file cfg)
     provides("p_snow");
     provides("p_rain");
 
+    block_kernel();
+
 }
 
 threshold_p_phase::~threshold_p_phase()
@@ -45,26 +47,24 @@ threshold_p_phase::~threshold_p_phase()
 
 }
 
-void threshold_p_phase::run(mesh_elem &face)
+void threshold_p_phase::run(face_range& range)
 {
-    double p = (*face)["p"_s];
+    const double* p = range.in("p"_s);
+    const double* t = range.in("t"_s);
 
-    if( (*face)["t"_s] >= t_thresh)
-    {
-        (*face)["frac_precip_rain"_s]= 1;
-        (*face)["frac_precip_snow"_s]= 0;
+    double* frac_precip_rain = range.out("frac_precip_rain"_s);
+    double* frac_precip_snow = range.out("frac_precip_snow"_s);
+    double* p_rain = range.out("p_rain"_s);
+    double* p_snow = range.out("p_snow"_s);
 
-        (*face)["p_rain"_s]= p;
-        (*face)["p_snow"_s]= 0 ;
-    } else
+    for (size_t k = 0; k < range.size(); ++k)
     {
-        (*face)["frac_precip_rain"_s]= 0;
-        (*face)["frac_precip_snow"_s]= 1;
-
-        (*face)["p_rain"_s]= 0;
-        (*face)["p_snow"_s]= p ;
-    }
-
+        bool rain = t[k] >= t_thresh;
 
+        frac_precip_rain[k] = rain ? 1 : 0;
+        frac_precip_snow[k] = rain ? 0 : 1;
 
+        p_rain[k] = rain ? p[k] : 0;
+        p_snow[k] = rain ? 0 : p[k];
+    }
 }
@@ -76,7 +76,7 @@ public:
 
     ~threshold_p_phase();
 
-    virtual void run(mesh_elem &face);
+    virtual void run(face_range& range);
 
 private:
 
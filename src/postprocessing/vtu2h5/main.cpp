@@ -0,0 +1,438 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+// Converts the per-rank vtu mesh output of a run, as listed in its pvd file, to a single time-indexed HDF5 file.
+// Timesteps are read in parallel, the values are ordered by global_id, and each variable is written as a
+// [time][face] dataset chunked so that a face's time series is cheap to extract.
+
+#include "H5Cpp.h"
+#include "logger.hpp"
+
+#include <vtkCellData.h>
+#include <vtkDataArray.h>
+#include <vtkSmartPointer.h>
+#include <vtkUnstructuredGrid.h>
+#include <vtkXMLUnstructuredGridReader.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/xml_parser.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace pt = boost::property_tree;
+namespace po = boost::program_options;
+
+using namespace H5;
+
+// one vtu part of a timestep
+struct part
+{
+    int rank;
+    std::string file;
+};
+
+// a timestep of the pvd collection and its parts
+struct timestep
+{
+    long long time;
+    std::vector<part> parts;
+};
+
+// cell arrays that describe the mesh partition, not output variables
+static bool is_partition_array(const std::string& name)
+{
+    return name == "global_id" || name == "is_ghost" || name == "ghost_type" || name == "owner";
+}
+
+// parameters and initial conditions don't change with time, so are only written once
+static bool is_static_array(const std::string& name)
+{
+    return name.rfind("[param] ", 0) == 0 || name.rfind("[ic] ", 0) == 0;
+}
+
+// HDF5 treats / as a path separator
+static std::string dataset_name(const std::string& name)
+{
+    std::string s = name;
+    std::replace(s.begin(), s.end(), '/', '_');
+    return s;
+}
+
+std::vector<timestep> read_pvd(const boost::filesystem::path& pvd_file)
+{
+    pt::ptree tree;
+    pt::read_xml(pvd_file.string(), tree);
+
+    auto dir = pvd_file.parent_path();
+
+    // datasets are grouped by timestep, in the order they are listed
+    std::vector<timestep> timesteps;
+    std::map<long long, size_t> index;
+    for (auto& itr : tree.get_child("VTKFile.Collection"))
+    {
+        if (itr.first != "DataSet")
+            continue;
+
+        auto t = itr.second.get<long long>("<xmlattr>.timestep");
+        part p;
+        p.rank = itr.second.get<int>("<xmlattr>.part", 0);
+        p.file = (dir / itr.second.get<std::string>("<xmlattr>.file")).string();
+
+        auto it = index.find(t);
+        if (it == index.end())
+        {
+            index[t] = timesteps.size();
+            timesteps.push_back({t, {}});
+            it = index.find(t);
+        }
+        timesteps[it->second].parts.push_back(p);
+    }
+
+    for (auto& t : timesteps)
+    {
+        std::sort(t.parts.begin(), t.parts.end(), [](const part& a, const part& b) { return a.rank < b.rank; });
+    }
+
+    return timesteps;
+}
+
+vtkSmartPointer<vtkUnstructuredGrid> read_vtu(const std::string& file)
+{
+    if (!boost::filesystem::exists(file))
+    {
+        throw std::runtime_error("Missing vtu file " + file);
+    }
+
+    auto reader = vtkSmartPointer<vtkXMLUnstructuredGridReader>::New();
+    reader->SetFileName(file.c_str());
+    reader->Update();
+
+    vtkSmartPointer<vtkUnstructuredGrid> grid = reader->GetOutput();
+    return grid;
+}
+
+/**
+ * Column of each of the part's cells in the output, or -1 for ghost cells. Parts are static over the run, so these
+ * are computed from the first timestep.
+ */
+std::vector<long long> part_columns(vtkUnstructuredGrid* grid, const std::unordered_map<unsigned long, size_t>& column)
+{
+    auto* ids = grid->GetCellData()->GetArray("global_id");
+    auto* ghost = grid->GetCellData()->GetArray("is_ghost");
+
+    std::vector<long long> cols(grid->GetNumberOfCells(), -1);
+    for (vtkIdType i = 0; i < grid->GetNumberOfCells(); i++)
+    {
+        if (ghost && ghost->GetTuple1(i) != 0)
+            continue;
+
+        cols[i] = column.at(static_cast<unsigned long>(ids->GetTuple1(i)));
+    }
+
+    return cols;
+}
+
+int main(int argc, char* argv[])
+{
+    std::string pvd_filename;
+    std::string out_filename;
+    size_t time_chunk = 24;
+    size_t face_chunk = 1024;
+    int compression = 0;
+
+    po::options_description desc("Allowed options.");
+    desc.add_options()("help", "This message")
+        ("pvd-file,p", po::value<std::string>(&pvd_filename), "pvd file written by CHM")
+        ("output,o", po::value<std::string>(&out_filename), "Output HDF5 file")
+        ("variables,v", po::value<std::vector<std::string>>()->multitoken(), "Only convert these variables")
+        ("time-chunk", po::value<size_t>(&time_chunk), "Timesteps per chunk. This many timesteps of every variable are held in memory")
+        ("face-chunk", po::value<size_t>(&face_chunk), "Faces per chunk")
+        ("compression,c", po::value<int>(&compression), "gzip level, 0 (default) disables compression");
+
+    po::variables_map vm;
+    po::store(po::command_line_parser(argc, argv).options(desc).run(), vm);
+    po::notify(vm);
+
+    if (vm.count("help"))
+    {
+        std::cout << desc << std::endl;
+        return 0;
+    }
+
+    if (!vm.count("pvd-file") || !vm.count("output"))
+    {
+        SPDLOG_ERROR("A pvd file and an output file are required");
+        return -1;
+    }
+
+    if (time_chunk == 0 || face_chunk == 0)
+    {
+        SPDLOG_ERROR("Chunk sizes must be > 0");
+        return -1;
+    }
+
+    try
+    {
+        auto timesteps = read_pvd(pvd_filename);
+        if (timesteps.empty())
+        {
+            SPDLOG_ERROR("No datasets found in {}", pvd_filename);
+            return -1;
+        }
+        size_t ntime = timesteps.size();
+        size_t nparts = timesteps[0].parts.size();
+
+        SPDLOG_INFO("{} timesteps of {} parts", ntime, nparts);
+
+        // The first timestep determines the faces and variables
+        std::vector<vtkSmartPointer<vtkUnstructuredGrid>> first(nparts);
+#pragma omp parallel for
+        for (size_t p = 0; p < nparts; p++)
+        {
+            first[p] = read_vtu(timesteps[0].parts[p].file);
+        }
+
+        std::vector<unsigned long> global_ids;
+        for (auto& grid : first)
+        {
+            auto* ids = grid->GetCellData()->GetArray("global_id");
+            auto* ghost = grid->GetCellData()->GetArray("is_ghost");
+            if (!ids)
+            {
+                SPDLOG_ERROR("vtu files do not have a global_id array");
+                return -1;
+            }
+
+            for (vtkIdType i = 0; i < grid->GetNumberOfCells(); i++)
+            {
+                if (!ghost || ghost->GetTuple1(i) == 0)
+                    global_ids.push_back(static_cast<unsigned long>(ids->GetTuple1(i)));
+            }
+        }
+        std::sort(global_ids.begin(), global_ids.end());
+        if (std::adjacent_find(global_ids.begin(), global_ids.end()) != global_ids.end())
+        {
+            SPDLOG_ERROR("A global_id is owned by more than one part");
+            return -1;
+        }
+        size_t nfaces = global_ids.size();
+
+        std::unordered_map<unsigned long, size_t> column;
+        for (size_t i = 0; i < nfaces; i++)
+            column[global_ids[i]] = i;
+
+        std::vector<std::vector<long long>> columns(nparts);
+        for (size_t p = 0; p < nparts; p++)
+            columns[p] = part_columns(first[p], column);
+
+        std::vector<std::string> variables, static_variables;
+        auto* cd = first[0]->GetCellData();
+        for (int a = 0; a < cd->GetNumberOfArrays(); a++)
+        {
+            auto* arr = cd->GetArray(a);
+            if (!arr || !arr->GetName())
+                continue;
+
+            std::string name = arr->GetName();
+            if (is_partition_array(name))
+                continue;
+
+            if (arr->GetNumberOfComponents() != 1)
+            {
+                SPDLOG_WARN("Skipping vector variable {}", name);
+                continue;
+            }
+
+            if (vm.count("variables"))
+            {
+                auto& only = vm["variables"].as<std::vector<std::string>>();
+                if (std::find(only.begin(), only.end(), name) == only.end())
+                    continue;
+            }
+
+            if (is_static_array(name))
+                static_variables.push_back(name);
+            else
+                variables.push_back(name);
+        }
+
+        SPDLOG_INFO("{} faces, {} variables, {} parameters", nfaces, variables.size(), static_variables.size());
+
+        H5File file(out_filename, H5F_ACC_TRUNC);
+
+        {
+            hsize_t dims[1] = {ntime};
+            std::vector<long long> times(ntime);
+            for (size_t t = 0; t < ntime; t++)
+                times[t] = timesteps[t].time;
+
+            auto ds = file.createDataSet("time", PredType::NATIVE_LLONG, DataSpace(1, dims));
+            ds.write(times.data(), PredType::NATIVE_LLONG);
+
+            StrType str_type(PredType::C_S1, H5T_VARIABLE);
+            std::string units = "seconds since 1970-01-01 00:00:00";
+            ds.createAttribute("units", str_type, DataSpace(H5S_SCALAR)).write(str_type, units);
+        }
+
+        {
+            hsize_t dims[1] = {nfaces};
+            auto ds = file.createDataSet("global_id", PredType::NATIVE_ULONG, DataSpace(1, dims));
+            ds.write(global_ids.data(), PredType::NATIVE_ULONG);
+        }
+
+        // gathers one variable of one part into its columns of row
+        auto scatter = [&](vtkUnstructuredGrid* grid, size_t p, const std::string& name, float* row)
+        {
+            auto* arr = grid->GetCellData()->GetArray(name.c_str());
+            auto& cols = columns[p];
+
+            if (static_cast<size_t>(grid->GetNumberOfCells()) != cols.size())
+            {
+                throw std::runtime_error("Part " + std::to_string(p) + " changed size between timesteps");
+            }
+
+            for (size_t i = 0; i < cols.size(); i++)
+            {
+                if (cols[i] < 0)
+                    continue;
+                row[cols[i]] = arr ? static_cast<float>(arr->GetTuple1(i)) : nanf("");
+            }
+        };
+
+        if (!static_variables.empty())
+        {
+            file.createGroup("parameters");
+
+            std::vector<float> row(nfaces);
+            hsize_t dims[1] = {nfaces};
+            for (auto& v : static_variables)
+            {
+                for (size_t p = 0; p < nparts; p++)
+                    scatter(first[p], p, v, row.data());
+
+                auto ds = file.createDataSet("parameters/" + dataset_name(v), PredType::NATIVE_FLOAT, DataSpace(1, dims));
+                ds.write(row.data(), PredType::NATIVE_FLOAT);
+            }
+        }
+        first.clear();
+
+        // [time][face], chunked so that a face's time series only touches ntime / time_chunk chunks
+        hsize_t dims[2] = {ntime, nfaces};
+        hsize_t chunk[2] = {std::min(time_chunk, ntime), std::min(face_chunk, nfaces)};
+
+        DSetCreatPropList plist;
+        plist.setChunk(2, chunk);
+        if (compression > 0)
+            plist.setDeflate(compression);
+        float fill = nanf("");
+        plist.setFillValue(PredType::NATIVE_FLOAT, &fill);
+
+        std::vector<DataSet> datasets;
+        for (auto& v : variables)
+        {
+            datasets.push_back(file.createDataSet(dataset_name(v), PredType::NATIVE_FLOAT, DataSpace(2, dims), plist));
+
+            StrType str_type(PredType::C_S1, H5T_VARIABLE);
+            datasets.back().createAttribute("name", str_type, DataSpace(H5S_SCALAR)).write(str_type, v);
+        }
+
+        // a block of time_chunk timesteps is read in parallel, then written as whole chunks
+        size_t tblock = chunk[0];
+        std::vector<std::vector<float>> block(variables.size(), std::vector<float>(tblock * nfaces));
+
+        for (size_t t0 = 0; t0 < ntime; t0 += tblock)
+        {
+            size_t nt = std::min(tblock, ntime - t0);
+
+            for (auto& b : block)
+                std::fill(b.begin(), b.end(), nanf(""));
+
+            std::string error;
+#pragma omp parallel for collapse(2) schedule(dynamic)
+            for (size_t t = 0; t < nt; t++)
+            {
+                for (size_t p = 0; p < nparts; p++)
+                {
+                    try
+                    {
+                        auto& ts = timesteps[t0 + t];
+                        if (ts.parts.size() != nparts)
+                            throw std::runtime_error("Timestep " + std::to_string(ts.time) + " has a different number of parts");
+
+                        auto grid = read_vtu(ts.parts[p].file);
+                        for (size_t v = 0; v < variables.size(); v++)
+                            scatter(grid, p, variables[v], &block[v][t * nfaces]);
+                    }
+                    catch (std::exception& e)
+                    {
+#pragma omp critical
+                        error = e.what();
+                    }
+                }
+            }
+
+            if (!error.empty())
+            {
+                SPDLOG_ERROR(error);
+                return -1;
+            }
+
+            hsize_t offset[2] = {t0, 0};
+            hsize_t count[2] = {nt, nfaces};
+            DataSpace mem(2, count);
+            for (size_t v = 0; v < variables.size(); v++)
+            {
+                auto space = datasets[v].getSpace();
+                space.selectHyperslab(H5S_SELECT_SET, count, offset);
+                datasets[v].write(block[v].data(), PredType::NATIVE_FLOAT, mem, space);
+            }
+
+            SPDLOG_INFO("Wrote timesteps {} to {} of {}", t0, t0 + nt - 1, ntime);
+        }
+    }
+    catch (Exception& e)
+    {
+        SPDLOG_ERROR("HDF5 error: {}", e.getDetailMsg());
+        return -1;
+    }
+    catch (std::exception& e)
+    {
+        SPDLOG_ERROR(e.what());
+        return -1;
+    }
+
+    return 0;
+}
@@ -151,7 +151,7 @@ class preprocessingTriangulation : public triangulation
         _vtk_unstructuredGrid->SetCells(VTK_TRIANGLE, triangles);
         _vtk_unstructuredGrid->GetFieldData()->AddArray(proj4);
 
-        auto variables = output_variables.size() == 0 ? this->face(0)->variables() : output_variables;
+        auto variables = output_variables.size() == 0 ? _vtu_outputs : output_variables;
         for(auto& v: variables)
         {
             data[v] = vtkSmartPointer<vtkFloatArray>::New();
@@ -174,7 +174,7 @@ class preprocessingTriangulation : public triangulation
 
             for (auto &v: variables)
             {
-                double d = (*fit)[v];
+                double d = vtu_value(fit, v);
                 if(d == -9999.)
                 {
                     d = nan("");
@@ -199,6 +199,32 @@ class preprocessingTriangulation : public triangulation
         writer->Write();
     }
 
+    // what write_vtu can output
+    const std::vector<std::string> _vtu_outputs = {"owner", "is_ghost", "ghost_type", "global_id", "local_id"};
+
+    /**
+     * The value of an output for a face, from its partition state. As the faces are not part of a compact mesh here,
+     * this does not go through the face variables. is_ghost and ghost_type are only set for ghosts.
+     */
+    double vtu_value(mesh_elem f, const std::string& v)
+    {
+        if (v == "owner")
+            return f->owner;
+        if (v == "global_id")
+            return f->cell_global_id;
+        if (v == "local_id")
+            return f->cell_local_id;
+
+        if (!f->is_ghost)
+            return -9999;
+        if (v == "is_ghost")
+            return f->is_ghost;
+        if (v == "ghost_type")
+            return static_cast<double>(f->get_module_data<ghost_info>("partition_tool").ghost_type);
+
+        return -9999;
+    }
+
     // sets the partition owner on every face
     // we don't do a valid rank check here as every triangle will need it set so ghosts are correctly ID'd
     void set_face_partition_owner(int mpi_rank)
@@ -781,16 +807,6 @@ class preprocessingTriangulation : public triangulation
             if(real_comm_world.rank() == 0)
             {
                 SPDLOG_DEBUG("Writting partition.vtu");
-                // init the datastructs to hold information for outputting to VTU
-                std::set< std::string > vtu_outputs = { "owner", "is_ghost", "ghost_type", "global_id","local_id"};
-#pragma omp parallel for
-                for (size_t i = 0; i < _faces.size(); ++i)
-                {
-                    auto f = _faces.at(i);
-                    f->init_time_series(vtu_outputs);
-                    (*f)["owner"] = f->owner;
-                }
-
                 _local_faces = _faces;
                 write_vtu("partition.vtu",{"owner"});
             }
@@ -853,16 +869,6 @@ class preprocessingTriangulation : public triangulation
                 // doesn't match the is_ghost default state. Here we assume false, and then switch it to the correct
                 // type when determined
                 gi.ghost_type = ghost_info::GHOST_TYPE::NONE;
-
-                if(output_vtu)
-                {
-                    (*f)["owner"] = -9999;
-                    (*f)["is_ghost"] = -9999;
-                    (*f)["ghost_type"]=-9999;
-                    (*f)["global_id"]=-9999;
-                    (*f)["local_id"]=-9999;
-                }
-
             }
 
             partition(_comm_world._rank);
@@ -988,22 +994,6 @@ class preprocessingTriangulation : public triangulation
 
             if(output_vtu)
             {
-                // the default vtu write param setup isn't going to do what we want so be explicit here
-#pragma omp parallel for
-                for (int t = 0; t < _local_faces.size(); t++)
-                {
-                    auto f = _local_faces.at(t);
-                    (*f)["global_id"] = f->cell_global_id;
-                    (*f)["local_id"] = f->cell_local_id;
-                    (*f)["owner"] = f->owner;
-                    if (f->is_ghost)
-                    {
-                        auto& gi = f->get_module_data<ghost_info>("partition_tool");
-                        (*f)["ghost_type"] = gi.ghost_type;
-                        (*f)["is_ghost"] = f->is_ghost;
-                    }
-                }
-
                 //per-rank so doesn't need to be protected on comm_world_rank = 0;
                 write_vtu("rank." + std::to_string(mpirank) + ".vtu");
             }
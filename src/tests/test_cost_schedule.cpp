@@ -0,0 +1,145 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+
+#include "utility/cost_schedule.hpp"
+
+#include "gtest/gtest.h"
+
+#include <iostream>
+#include <random>
+#include <vector>
+
+/**
+ * Per-face cost of a heterogeneous mesh: a cheap background with a contiguous expensive band, e.g., the snow covered
+ * faces of a partially snow free basin, plus noise.
+ */
+class CostScheduleTest : public testing::Test
+{
+  protected:
+    std::vector<double> heterogeneous(size_t n)
+    {
+        std::mt19937 gen(42);
+        std::uniform_real_distribution<double> U(0.8, 1.2);
+
+        std::vector<double> cost(n);
+        for (size_t i = 0; i < n; ++i)
+            cost[i] = U(gen) * (i > n / 2 && i < n / 2 + n / 4 ? 20 : 1);
+        return cost;
+    }
+};
+
+TEST_F(CostScheduleTest, PartitionCoversAllItems)
+{
+    auto cost = heterogeneous(10007);
+
+    for (int nparts : {1, 3, 8, 64})
+    {
+        auto bounds = cost_schedule::partition(cost, nparts);
+        ASSERT_EQ(bounds.size(), nparts + 1);
+        ASSERT_EQ(bounds.front(), 0);
+        ASSERT_EQ(bounds.back(), cost.size());
+        for (int p = 0; p < nparts; ++p)
+            ASSERT_LE(bounds[p], bounds[p + 1]);
+    }
+}
+
+TEST_F(CostScheduleTest, PartitionBalancesHeterogeneousCost)
+{
+    auto cost = heterogeneous(100000);
+    int nparts = 8;
+
+    double before = cost_schedule::imbalance(cost, cost_schedule::partition(cost.size(), nparts));
+    double after = cost_schedule::imbalance(cost, cost_schedule::partition(cost, nparts));
+
+    std::cout << nparts << " threads: imbalance " << before << " with equal ranges, " << after
+              << " with cost weighted ranges" << std::endl;
+
+    ASSERT_GT(before, 1.5);
+    ASSERT_LT(after, 1.01);
+}
+
+TEST_F(CostScheduleTest, ZeroCostIsEqualSplit)
+{
+    std::vector<double> cost(100, 0);
+    ASSERT_EQ(cost_schedule::partition(cost, 4), cost_schedule::partition(cost.size(), 4));
+    ASSERT_DOUBLE_EQ(cost_schedule::imbalance(cost, cost_schedule::partition(cost.size(), 4)), 1);
+}
+
+TEST_F(CostScheduleTest, RebalancesAtEndOfWindow)
+{
+    auto cost = heterogeneous(1000);
+    cost_schedule schedule;
+    schedule.init(cost.size(), 4, 2);
+
+    ASSERT_EQ(schedule.begin(1), 250);
+
+    for (int ts = 0; ts < 2; ++ts)
+        for (size_t i = 0; i < cost.size(); ++i)
+            schedule.add(i, cost[i]);
+
+    ASSERT_FALSE(schedule.end_timestep());
+    ASSERT_TRUE(schedule.end_timestep());
+
+    ASSERT_DOUBLE_EQ(schedule.initial_imbalance(), schedule.measured_imbalance());
+    ASSERT_GT(schedule.measured_imbalance(), 1.5);
+    ASSERT_LT(schedule.predicted_imbalance(), 1.05);
+    ASSERT_EQ(schedule.begin(0), 0);
+    ASSERT_EQ(schedule.end(3), cost.size());
+    ASSERT_NE(schedule.begin(1), 250);
+}
+
+// Each thread adds the cost of its own range, as core::run does, and the ranges must come out exactly as a serial
+// partition of the same cost
+TEST_F(CostScheduleTest, ThreadedAddMatchesSerialPartition)
+{
+    auto cost = heterogeneous(20000);
+    int nparts = 8;
+
+    cost_schedule schedule;
+    schedule.init(cost.size(), nparts, 1);
+
+    auto equal = cost_schedule::partition(cost.size(), nparts);
+    auto weighted = cost_schedule::partition(cost, nparts);
+
+    for (int ts = 0; ts < 2; ++ts)
+    {
+        #pragma omp parallel for schedule(static, 1)
+        for (int p = 0; p < schedule.parts(); ++p)
+            for (size_t i = schedule.begin(p); i < schedule.end(p); ++i)
+                schedule.add(i, cost[i]);
+
+        ASSERT_TRUE(schedule.end_timestep());
+
+        std::vector<size_t> bounds;
+        for (int p = 0; p < nparts; ++p)
+            bounds.push_back(schedule.begin(p));
+        bounds.push_back(schedule.end(nparts - 1));
+        ASSERT_EQ(bounds, weighted);
+    }
+
+    ASSERT_DOUBLE_EQ(schedule.initial_imbalance(), cost_schedule::imbalance(cost, equal));
+    ASSERT_DOUBLE_EQ(schedule.measured_imbalance(), cost_schedule::imbalance(cost, weighted));
+    ASSERT_GT(schedule.initial_imbalance(), 1.5);
+    ASSERT_LT(schedule.measured_imbalance(), 1.01);
+}
@@ -0,0 +1,186 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+
+#include "math/fast_math.hpp"
+
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+/**
+ * Compares math::fast against libm over physical input ranges and reports the maximum error in ulp of the libm result
+ */
+class FastMathTest : public testing::Test
+{
+  protected:
+    static double ulp_error(double approx, double exact)
+    {
+        if (approx == exact)
+            return 0;
+        double ulp = std::nextafter(std::fabs(exact), std::numeric_limits<double>::infinity()) - std::fabs(exact);
+        return std::fabs(approx - exact) / ulp;
+    }
+
+    std::vector<double> uniform(double a, double b, size_t n)
+    {
+        std::uniform_real_distribution<double> U(a, b);
+        std::vector<double> v(n);
+        for (auto& x : v)
+            x = U(gen);
+        return v;
+    }
+
+    // log uniform on [a, b], a > 0
+    std::vector<double> log_uniform(double a, double b, size_t n)
+    {
+        auto v = uniform(std::log(a), std::log(b), n);
+        for (auto& x : v)
+            x = std::exp(x);
+        return v;
+    }
+
+    std::mt19937_64 gen{42};
+    size_t n = 1000000;
+};
+
+TEST_F(FastMathTest, Exp)
+{
+    // full range, and the range of e.g. the Clausius-Clapeyron and stability function arguments
+    for (auto range : {std::make_pair(-708.0, 709.0), std::make_pair(-50.0, 50.0), std::make_pair(-1e-3, 1e-3)})
+    {
+        double max_ulp = 0;
+        for (auto x : uniform(range.first, range.second, n))
+            max_ulp = std::max(max_ulp, ulp_error(math::fast::exp(x), std::exp(x)));
+
+        std::cout << "exp [" << range.first << ", " << range.second << "]: max " << max_ulp << " ulp" << std::endl;
+        ASSERT_LE(max_ulp, 1.0);
+    }
+
+    // gradual underflow
+    double max_ulp = 0;
+    for (auto x : uniform(-745, -708, n))
+        max_ulp = std::max(max_ulp, ulp_error(math::fast::exp(x), std::exp(x)));
+    std::cout << "exp [-745, -708]: max " << max_ulp << " ulp" << std::endl;
+    ASSERT_LE(max_ulp, 1.0);
+
+    ASSERT_EQ(math::fast::exp(0), 1);
+    ASSERT_EQ(math::fast::exp(-800), 0);
+    ASSERT_EQ(math::fast::exp(-INFINITY), 0);
+    ASSERT_EQ(math::fast::exp(709.78), std::exp(709.78));
+    ASSERT_TRUE(std::isinf(math::fast::exp(709.8)));
+    ASSERT_TRUE(std::isinf(math::fast::exp(INFINITY)));
+    ASSERT_TRUE(std::isnan(math::fast::exp(NAN)));
+}
+
+TEST_F(FastMathTest, Log)
+{
+    for (auto range : {std::make_pair(1e-300, 1e300), std::make_pair(0.5, 2.0), std::make_pair(1e-320, 1e-300)})
+    {
+        double max_ulp = 0;
+        for (auto x : log_uniform(range.first, range.second, n))
+            max_ulp = std::max(max_ulp, ulp_error(math::fast::log(x), std::log(x)));
+
+        std::cout << "log [" << range.first << ", " << range.second << "]: max " << max_ulp << " ulp" << std::endl;
+        ASSERT_LE(max_ulp, 1.0);
+    }
+
+    // near 1, where the result is small
+    double max_ulp = 0;
+    for (auto x : uniform(1 - 1e-6, 1 + 1e-6, n))
+        max_ulp = std::max(max_ulp, ulp_error(math::fast::log(x), std::log(x)));
+    std::cout << "log [1-1e-6, 1+1e-6]: max " << max_ulp << " ulp" << std::endl;
+    ASSERT_LE(max_ulp, 1.0);
+
+    ASSERT_EQ(math::fast::log(1), 0);
+    ASSERT_TRUE(std::isinf(math::fast::log(0)) && math::fast::log(0) < 0);
+    ASSERT_TRUE(std::isinf(math::fast::log(INFINITY)));
+    ASSERT_TRUE(std::isnan(math::fast::log(-1)));
+    ASSERT_TRUE(std::isnan(math::fast::log(-INFINITY)));
+    ASSERT_TRUE(std::isnan(math::fast::log(NAN)));
+}
+
+TEST_F(FastMathTest, Pow)
+{
+    struct pow_range
+    {
+        const char* name;
+        double x0, x1, y0, y1;
+    };
+
+    // |y log x| <= 1: pressure ratios to the hypsometric exponent (Dodson_NSA_ta), small corrections
+    // larger: Gray_inf's soil moisture and temperature terms, diffusivity (T/273)^-1.75, and the PBSM3D suspension
+    // layer: particle radius from height, settling velocity from radius, Re^0.5 and wind speed^1.36
+    std::vector<pow_range> ranges = {
+        {"pressure ratio", 0.6, 1.0, 0.19, 5.26},
+        {"Gray_inf", 0.01, 1.0, 0.44, 2.92},
+        {"temperature ratio", 0.8, 1.1, -1.75, -0.45},
+        {"PBSM3D particle radius", 0.01, 20, -0.258, -0.258},
+        {"PBSM3D settling", 1e-6, 1e-3, 1.8, 1.8},
+        {"PBSM3D mean mass radius", 1e-18, 1e-9, 0.3333333, 0.3333333},
+        {"PBSM3D Re, wind", 0.01, 100, 0.5, 1.36},
+    };
+
+    for (auto& r : ranges)
+    {
+        auto x = uniform(r.x0, r.x1, n);
+        auto y = uniform(r.y0, r.y1, n);
+
+        double max_ulp = 0;
+        double max_excess = 0; // error beyond the documented bound
+        for (size_t i = 0; i < n; ++i)
+        {
+            double e = ulp_error(math::fast::pow(x[i], y[i]), std::pow(x[i], y[i]));
+            double a = std::fabs(y[i] * std::log(x[i]));
+            double bound = a <= 1 ? 2 : 2 + 2 * a;
+            max_ulp = std::max(max_ulp, e);
+            max_excess = std::max(max_excess, e - bound);
+        }
+
+        std::cout << "pow " << r.name << ": max " << max_ulp << " ulp" << std::endl;
+        ASSERT_LE(max_excess, 0);
+    }
+
+    ASSERT_EQ(math::fast::pow(0, 2.5), 0);
+    ASSERT_TRUE(std::isinf(math::fast::pow(0, -2.5)));
+    ASSERT_EQ(math::fast::pow(2, 0), 1);
+}
+
+TEST_F(FastMathTest, IntegerPow)
+{
+    double max_ulp = 0;
+    for (auto x : uniform(200, 350, n))
+    {
+        max_ulp = std::max(max_ulp, ulp_error(math::fast::ipow<4>(x), std::pow(x, 4.0)));
+        max_ulp = std::max(max_ulp, ulp_error(math::fast::ipow<3>(x), std::pow(x, 3.0)));
+        max_ulp = std::max(max_ulp, ulp_error(math::fast::ipow<-2>(x), std::pow(x, -2.0)));
+    }
+    std::cout << "ipow: max " << max_ulp << " ulp" << std::endl;
+    ASSERT_LE(max_ulp, 2.0);
+
+    static_assert(math::fast::ipow<0>(3.0) == 1.0);
+    static_assert(math::fast::ipow<5>(2.0) == 32.0);
+}
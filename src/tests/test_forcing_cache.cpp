@@ -0,0 +1,168 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+
+#include "forcing_cache.hpp"
+#include "exception.hpp"
+
+#include "gtest/gtest.h"
+
+#include <boost/filesystem.hpp>
+
+#include <vector>
+
+class ForcingCacheTest : public testing::Test
+{
+  protected:
+    virtual void SetUp()
+    {
+        file = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("forcing_cache_%%%%%%.bin"))
+                   .string();
+
+        start = boost::posix_time::from_iso_string("20180115T060000");
+        dt = boost::posix_time::hours(1);
+
+        // 2 scalars and a vector, 5 values per face
+        nvalues = variables.size() + 3 * vectors.size();
+        for (size_t ts = 0; ts < ntimesteps; ts++)
+        {
+            std::vector<double> v(nvalues * nfaces);
+            for (size_t i = 0; i < v.size(); i++)
+                v[i] = 1000.0 * ts + i + 0.25;
+            values.push_back(v);
+        }
+    }
+
+    virtual void TearDown()
+    {
+        boost::filesystem::remove(file);
+    }
+
+    void record(size_t n, bool finished)
+    {
+        forcing_cache cache;
+        cache.open_record(file, hash, variables, vectors, nfaces, ntimesteps);
+        for (size_t ts = 0; ts < n; ts++)
+            cache.write(values[ts], start + dt * ts);
+        cache.close(finished);
+    }
+
+    bool valid()
+    {
+        return forcing_cache::is_valid(file, hash, nfaces, nvalues, ntimesteps);
+    }
+
+    std::string file;
+    boost::posix_time::ptime start;
+    boost::posix_time::time_duration dt;
+
+    uint64_t hash = 0x1234abcd;
+    std::vector<std::string> variables = {"t", "rh"};
+    std::vector<std::string> vectors = {"wind_direction"};
+    size_t nfaces = 7;
+    size_t nvalues = 0;
+    size_t ntimesteps = 4;
+
+    std::vector<std::vector<double>> values; // [timestep][value][face]
+};
+
+TEST_F(ForcingCacheTest, RecordThenReplay)
+{
+    ASSERT_FALSE(valid());
+
+    record(ntimesteps, true);
+    ASSERT_TRUE(valid());
+
+    forcing_cache cache;
+    cache.open_replay(file, variables, vectors, nfaces);
+    ASSERT_EQ(cache.get_mode(), forcing_cache::mode::replay);
+
+    std::vector<double> v;
+    for (size_t ts = 0; ts < ntimesteps; ts++)
+    {
+        cache.read(v, start + dt * ts);
+        ASSERT_EQ(v, values[ts]);
+    }
+
+    // past the end of the recording
+    ASSERT_THROW(cache.read(v, start + dt * ntimesteps), io_error);
+    cache.close();
+    ASSERT_TRUE(valid());
+}
+
+TEST_F(ForcingCacheTest, ReplayAtDifferentTimeThrows)
+{
+    record(ntimesteps, true);
+
+    forcing_cache cache;
+    cache.open_replay(file, variables, vectors, nfaces);
+
+    std::vector<double> v;
+    ASSERT_THROW(cache.read(v, start + dt), forcing_error);
+}
+
+TEST_F(ForcingCacheTest, IncompleteRecordingIsNotValid)
+{
+    // stopped early, e.g., a module threw after some timesteps
+    record(ntimesteps - 1, false);
+    ASSERT_FALSE(valid());
+
+    // claims to have finished but is missing timesteps
+    record(ntimesteps - 1, true);
+    ASSERT_FALSE(valid());
+
+    // every timestep written but the run did not reach the end of the forcing
+    record(ntimesteps, false);
+    ASSERT_FALSE(valid());
+
+    // never closed
+    {
+        forcing_cache cache;
+        cache.open_record(file, hash, variables, vectors, nfaces, ntimesteps);
+        for (size_t ts = 0; ts < ntimesteps; ts++)
+            cache.write(values[ts], start + dt * ts);
+    }
+    ASSERT_FALSE(valid());
+}
+
+TEST_F(ForcingCacheTest, MismatchedRunIsNotValid)
+{
+    record(ntimesteps, true);
+    ASSERT_TRUE(valid());
+
+    ASSERT_FALSE(forcing_cache::is_valid(file, hash + 1, nfaces, nvalues, ntimesteps));
+    ASSERT_FALSE(forcing_cache::is_valid(file, hash, nfaces + 1, nvalues, ntimesteps));
+    ASSERT_FALSE(forcing_cache::is_valid(file, hash, nfaces, nvalues + 1, ntimesteps));
+    ASSERT_FALSE(forcing_cache::is_valid(file, hash, nfaces, nvalues, ntimesteps + 1));
+    ASSERT_FALSE(forcing_cache::is_valid(file, hash, nfaces, nvalues, ntimesteps - 1));
+    ASSERT_FALSE(forcing_cache::is_valid(file + ".missing", hash, nfaces, nvalues, ntimesteps));
+}
+
+TEST_F(ForcingCacheTest, WrongNumberOfValuesThrows)
+{
+    forcing_cache cache;
+    cache.open_record(file, hash, variables, vectors, nfaces, ntimesteps);
+
+    std::vector<double> v(nvalues * nfaces + 1);
+    ASSERT_THROW(cache.write(v, start), io_error);
+}
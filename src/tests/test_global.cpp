@@ -0,0 +1,105 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+
+#include "global.hpp"
+
+#include "gtest/gtest.h"
+
+#include <random>
+#include <vector>
+
+/**
+ * Checks the cached calendar against boost's decomposition of the date.
+ */
+class GlobalTest : public testing::Test
+{
+  protected:
+    std::vector<boost::posix_time::ptime> dates(size_t n)
+    {
+        std::mt19937 gen(42);
+        std::uniform_int_distribution<long> U(0, 100L * 365 * 86400);
+
+        std::vector<boost::posix_time::ptime> d(n);
+        auto start = boost::posix_time::ptime(boost::gregorian::date(1950, 1, 1));
+        for (auto& itr : d)
+            itr = start + boost::posix_time::seconds(U(gen));
+        return d;
+    }
+
+    // as core does when the timestep advances
+    void set_current_date(global& g, const boost::posix_time::ptime& date)
+    {
+        g.set_current_date(date);
+    }
+};
+
+TEST_F(GlobalTest, CalendarMatchesBoost)
+{
+    auto epoch = boost::posix_time::from_time_t(0);
+
+    for (auto& d : dates(10000))
+    {
+        auto c = global::to_calendar(d);
+        std::tm tm = boost::posix_time::to_tm(d);
+
+        ASSERT_EQ(c.year, tm.tm_year + 1900);
+        ASSERT_EQ(c.month, tm.tm_mon + 1);
+        ASSERT_EQ(c.day, tm.tm_mday);
+        ASSERT_EQ(c.hour, tm.tm_hour);
+        ASSERT_EQ(c.minute, tm.tm_min);
+        ASSERT_EQ(c.second, tm.tm_sec);
+        ASSERT_EQ(c.day_of_year, tm.tm_yday + 1);
+        ASSERT_DOUBLE_EQ(c.fractional_hour, tm.tm_hour + tm.tm_min / 60.0 + tm.tm_sec / 3600.0);
+        ASSERT_EQ(c.epoch_seconds, static_cast<uint64_t>((d - epoch).total_seconds()));
+    }
+}
+
+TEST_F(GlobalTest, CalendarLeapDay)
+{
+    auto c = global::to_calendar(boost::posix_time::time_from_string("2020-12-31 23:30:00"));
+    ASSERT_EQ(c.day_of_year, 366);
+    ASSERT_DOUBLE_EQ(c.fractional_hour, 23.5);
+
+    c = global::to_calendar(boost::posix_time::ptime(boost::posix_time::not_a_date_time));
+    ASSERT_EQ(c.year, 0);
+    ASSERT_EQ(c.epoch_seconds, 0);
+}
+
+TEST_F(GlobalTest, AccessorsFollowCurrentDate)
+{
+    // the accessors modules call per face return the fields cached when the timestep advances
+    global g;
+    for (auto& d : dates(1000))
+    {
+        set_current_date(g, d);
+        std::tm tm = boost::posix_time::to_tm(d);
+
+        ASSERT_EQ(g.year(), d.date().year());
+        ASSERT_EQ(g.month(), d.date().month());
+        ASSERT_EQ(g.day(), d.date().day());
+        ASSERT_EQ(g.hour(), tm.tm_hour);
+        ASSERT_EQ(g.min(), tm.tm_min);
+        ASSERT_EQ(g.sec(), tm.tm_sec);
+    }
+}
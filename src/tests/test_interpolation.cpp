@@ -165,3 +165,28 @@ TEST_F(InterpTest,interpolation_class_static_size2)
 
 
 }
+
+TEST_F(InterpTest,spline_weights)
+{
+    thin_plate_spline s;
+    std::vector<boost::tuple<double,double,double> > xy;
+
+    xy.push_back( boost::make_tuple(-1276639.4142831599,1408220.6433826166,22.241299818717572));
+    xy.push_back( boost::make_tuple(-1276628.96002623, 1408213.5776356135, 22.423794697169313));
+    xy.push_back( boost::make_tuple(-1276628.8896492834,1408225.6645281466,22.301020204404736));
+
+    auto query = boost::make_tuple(-1276633.6294519969,1408220.6575855566,2306.0533040364585);
+
+    auto w = s.weights(xy, query);
+    ASSERT_EQ(w.size(), 3);
+
+    // the constant term is fitted exactly, so the weights sum to 1
+    ASSERT_NEAR(w[0] + w[1] + w[2], 1.0, 1e-12);
+
+    double result = 0;
+    for (size_t i = 0; i < xy.size(); i++)
+        result += w[i] * xy[i].get<2>();
+
+    ASSERT_NEAR(result, s(xy, query), 1e-10);
+    ASSERT_NEAR(result, 22.30217013945628, 1e-10);
+}
@@ -26,6 +26,7 @@
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <cmath>
 
 class MetdataTest : public testing::Test
 {
@@ -562,4 +563,159 @@ TEST_F(MetdataTest, NC_TestPrune)
 
     ASSERT_EQ((151*151)-(151*150),md.nstations());
     ASSERT_EQ(md.stations().at(0)->ID(),"0");
-}
\ No newline at end of file
+}
+TEST_F(MetdataTest, NC_TestNearestInRadius)
+{
+    metdata md(proj4str);
+
+    ASSERT_NO_THROW(md.load_from_netcdf("GEM-CHM_2p5_snowcast_2018011506_2018011605.nc"));
+
+    auto s = md.at(75+75*151);
+    double x = s->x();
+    double y = s->y();
+
+    // a large radius is the same as the N nearest
+    auto nearest = md.nearest_station(x, y, 8);
+    auto capped = md.nearest_station_in_radius(x, y, 8, 1e6);
+    ASSERT_EQ(capped.size(), 8);
+    ASSERT_EQ(capped.at(0), s);
+
+    std::set<std::shared_ptr<station>> a(nearest.begin(), nearest.end());
+    std::set<std::shared_ptr<station>> b(capped.begin(), capped.end());
+    ASSERT_TRUE(a == b);
+
+    // a tiny radius only contains the coincident station, but we always return at least min_N
+    ASSERT_EQ(md.nearest_station_in_radius(x, y, 8, 1.0).size(), 1);
+    ASSERT_EQ(md.nearest_station_in_radius(x, y, 8, 1.0, 2).size(), 2);
+}
+
+TEST_F(MetdataTest, NC_TestQuadrantStations)
+{
+    metdata md(proj4str);
+
+    ASSERT_NO_THROW(md.load_from_netcdf("GEM-CHM_2p5_snowcast_2018011506_2018011605.nc"));
+
+    // offset slightly so no station lies on the quadrant boundaries
+    auto center = md.at(75+75*151);
+    double x = center->x() + 1.0;
+    double y = center->y() + 1.0;
+
+    auto stations = md.quadrant_stations(x, y, 2);
+    ASSERT_EQ(stations.size(), 8);
+
+    std::array<int, 4> count = {0, 0, 0, 0};
+    for(auto& s : stations)
+    {
+        double dx = s->x() - x;
+        double dy = s->y() - y;
+        count[ dy >= 0 ? (dx >= 0 ? 0 : 1) : (dx < 0 ? 2 : 3) ]++;
+    }
+    for(auto c : count)
+        ASSERT_EQ(c, 2);
+
+    // with a tiny radius the quadrants are empty and only the min_N nearest are used
+    ASSERT_EQ(md.quadrant_stations(x, y, 2, 0.1, 2).size(), 2);
+}
+
+TEST_F(MetdataTest, NC_TestQuadrantStationsAtCorner)
+{
+    metdata md(proj4str);
+
+    ASSERT_NO_THROW(md.load_from_netcdf("GEM-CHM_2p5_snowcast_2018011506_2018011605.nc"));
+
+    // at the corner of the grid at most three quadrants have stations, and the search stops instead of walking every
+    // station for the empty one
+    auto corner = md.at(0);
+    double x = corner->x() + 1.0;
+    double y = corner->y() + 1.0;
+
+    auto nearest = md.nearest_station(x, y, 8);
+    double d = std::hypot(nearest.back()->x() - x, nearest.back()->y() - y);
+
+    auto stations = md.quadrant_stations(x, y, 2);
+    ASSERT_LT(stations.size(), 8);
+    for(auto& s : stations)
+        ASSERT_LE(std::hypot(s->x() - x, s->y() - y), 3 * d * (1 + 1e-9));
+}
+
+TEST_F(MetdataTest, GRIB2_FirstTimestep)
+{
+    ASSERT_EQ(metdata::grib2_first_timestep({"p", "press", "rh", "t"}), 0);
+    ASSERT_EQ(metdata::grib2_first_timestep({"Qli", "t"}), 1);
+    ASSERT_EQ(metdata::grib2_first_timestep({"Qsi", "t"}), 1);
+}
+
+TEST_F(MetdataTest, GRIB2_Conversions)
+{
+    // as read from the files: [time][variable][cell]
+    std::vector<std::string> variables = {"Qli", "Qsi", "p", "press", "rh", "t"};
+    size_t ntimes = 3;
+    size_t ncells = 2;
+    size_t nvars = variables.size();
+    time_t dt = 3600;
+    float nan = std::nanf("");
+
+    std::vector<float> values = {
+        // t = 0
+        1e6, 2e6,              // Qli, J/m^2 accumulated
+        0, 0,                  // Qsi, J/m^2 accumulated
+        1e-4f, 0,              // p, kg/(m^2 s)
+        90000, 101325,         // press, Pa
+        nan, 50,               // rh, %
+        273.15f, 263.15f,      // t, K
+        // t = 1
+        1e6 + 300 * 3600, 2e6 + 250 * 3600,
+        1000 * 3600, 500 * 3600,
+        2e-4f, 0,
+        90100, 101300,
+        80, 55,
+        274.15f, 264.15f,
+        // t = 2
+        1e6 + 600 * 3600, 2e6 + 550 * 3600,
+        1200 * 3600, 400 * 3600, // the second cell's accumulation decreases
+        0, 5e-5f,
+        90200, 101200,
+        85, nan,
+        nan, 265.15f};
+    ASSERT_EQ(values.size(), ntimes * nvars * ncells);
+
+    size_t missing = metdata::convert_grib2(values.data(), variables, ntimes, ncells, dt);
+
+    auto at = [&](size_t t, size_t v, size_t i) { return values[(t * nvars + v) * ncells + i]; };
+
+    // the first timestep is unknown, so its missing rh is not replaced or counted
+    ASSERT_EQ(missing, 2);
+    ASSERT_TRUE(std::isnan(at(0, 4, 0)));
+    ASSERT_FLOAT_EQ(at(2, 4, 1), -9999);
+    ASSERT_FLOAT_EQ(at(2, 5, 0), -9999);
+
+    // accumulated J/m^2 -> W/m^2 over the timestep, with Qsi clamped to 0
+    ASSERT_NEAR(at(1, 0, 0), 300, 1e-2);
+    ASSERT_NEAR(at(1, 0, 1), 250, 1e-2);
+    ASSERT_NEAR(at(2, 0, 0), 300, 1e-2);
+    ASSERT_NEAR(at(2, 0, 1), 300, 1e-2);
+    ASSERT_NEAR(at(1, 1, 0), 1000, 1e-2);
+    ASSERT_NEAR(at(1, 1, 1), 500, 1e-2);
+    ASSERT_NEAR(at(2, 1, 0), 200, 1e-2);
+    ASSERT_FLOAT_EQ(at(2, 1, 1), 0);
+
+    for (size_t t = 0; t < ntimes; t++)
+    {
+        // kg/(m^2 s) -> mm per timestep
+        ASSERT_NEAR(at(t, 2, 0), (t == 0 ? 1e-4 : t == 1 ? 2e-4 : 0) * dt, 1e-4);
+
+        // Pa -> hPa
+        ASSERT_NEAR(at(t, 3, 0), 900 + t, 1e-3);
+    }
+    ASSERT_NEAR(at(2, 2, 1), 5e-5 * dt, 1e-4);
+    ASSERT_NEAR(at(0, 3, 1), 1013.25, 1e-3);
+
+    // K -> C
+    ASSERT_NEAR(at(0, 5, 0), 0, 1e-4);
+    ASSERT_NEAR(at(1, 5, 0), 1, 1e-4);
+    ASSERT_NEAR(at(0, 5, 1), -10, 1e-4);
+    ASSERT_NEAR(at(2, 5, 1), -8, 1e-4);
+
+    // unconverted
+    ASSERT_FLOAT_EQ(at(1, 4, 0), 80);
+}
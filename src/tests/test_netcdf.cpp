@@ -23,6 +23,7 @@
 
 #include "netcdf.hpp"
 #include "gtest/gtest.h"
+#include <boost/filesystem.hpp>
 #include <vector>
 #include <string>
 #include <algorithm>
@@ -117,4 +118,75 @@ TEST_F(NetCDFTest, access_time_offset)
     value = nc.get_var("t",time,150,150);
     ASSERT_DOUBLE_EQ(value, -11.3069305419921875);
 
-}
\ No newline at end of file
+}
+
+// Lehning_snowpack writes whole per-face variables on the tri_id dim with put_var1D(var, dim, values), while other
+// modules and core create the variables with create_variable1D and write them a value at a time. Either order has to
+// give 1D variables on the same dim
+TEST(NetCDFCheckpointTest, RoundTripMixedPerFaceWriters)
+{
+    size_t nfaces = 17;
+    auto path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("chkp_%%%%%%.nc");
+
+    std::vector<double> snowpack_albedo(nfaces);
+    std::vector<unsigned long long> offset(nfaces + 1);
+    std::vector<double> layers;
+    for (size_t i = 0; i < nfaces; i++)
+    {
+        snowpack_albedo[i] = 0.5 + 0.01 * i;
+        offset[i + 1] = offset[i] + i % 3;
+        for (size_t e = 0; e < i % 3; e++)
+            layers.push_back(i + 0.1 * e);
+    }
+
+    {
+        netcdf chkpt;
+        chkpt.create(path.string());
+
+        // snowpack checkpoints first and creates tri_id
+        chkpt.put_var1D("snowpack:offset", "snowpack:offset", offset);
+        chkpt.put_var1D("snowpack:albedo", "tri_id", snowpack_albedo);
+        chkpt.put_var1D("snowpack:thickness", "snowpack:element", layers);
+
+        // then e.g., Richard_albedo and core's global_id
+        for (std::string var : {"Richard_albedo:albedo", "global_id"})
+        {
+            chkpt.create_variable1D(var, nfaces);
+            for (size_t i = 0; i < nfaces; i++)
+                chkpt.put_var1D(var, i, var == "global_id" ? 1000.0 + i : 0.8 - 0.01 * i);
+        }
+
+        ASSERT_THROW(chkpt.create_variable1D("bad_length", nfaces + 1), forcing_error);
+        ASSERT_THROW(chkpt.put_var1D("not_created", 0, 1.0), forcing_error);
+    }
+
+    netcdf in;
+    in.open(path.string());
+
+    for (std::string var : {"snowpack:albedo", "Richard_albedo:albedo", "global_id"})
+    {
+        auto nc_var = in.get_ncfile().getVar(var);
+        ASSERT_EQ(nc_var.getDimCount(), 1) << var;
+        ASSERT_EQ(nc_var.getDim(0).getName(), "tri_id") << var;
+        ASSERT_EQ(nc_var.getDim(0).getSize(), nfaces) << var;
+    }
+
+    std::vector<double> values;
+    in.get_var1D("snowpack:albedo", values);
+    ASSERT_EQ(values, snowpack_albedo);
+
+    std::vector<unsigned long long> offset_in;
+    in.get_var1D("snowpack:offset", offset_in);
+    ASSERT_EQ(offset_in, offset);
+
+    in.get_var1D("snowpack:thickness", values);
+    ASSERT_EQ(values, layers);
+
+    for (size_t i = 0; i < nfaces; i++)
+    {
+        ASSERT_DOUBLE_EQ(in.get_var1D("Richard_albedo:albedo", i), 0.8 - 0.01 * i);
+        ASSERT_DOUBLE_EQ(in.get_var1D("global_id", i), 1000.0 + i);
+    }
+
+    boost::filesystem::remove(path);
+}
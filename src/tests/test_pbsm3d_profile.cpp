@@ -0,0 +1,253 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+#include "modules/PBSM3D_profile.hpp"
+#include <physics/PhysConst.h>
+#include "physics/Atmosphere.h"
+
+#include "gtest/gtest.h"
+
+#include <boost/math/tools/roots.hpp>
+#include <boost/math/tools/tuple.hpp>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+/**
+ * Compares the blocked [face][layer] PBSM3D suspension profile kernel against the original per-face layer loop,
+ * and times the two.
+ */
+class PBSM3DProfileTest : public testing::Test
+{
+  protected:
+    virtual void SetUp()
+    {
+        s.nLayer = 10;
+        s.v_edge_height = 5.0 / s.nLayer;
+        s.l__max = 40;
+        s.snow_diffusion_const = 0.3;
+        s.rouault_diffusion_coeff = false;
+        s.do_fixed_settling = false;
+        s.settling_velocity = 0.5;
+        s.do_sublimation = true;
+        s.iterative_subl = false;
+    }
+
+    void fill(pbsm3d::suspension_profile& p, size_t nfaces)
+    {
+        std::mt19937 gen(42);
+        std::uniform_real_distribution<double> U(0, 1);
+
+        p.resize(nfaces, s.nLayer, false);
+        for (size_t i = 0; i < nfaces; ++i)
+        {
+            p.saltation[i] = U(gen) < 0.7;
+            p.hs[i] = p.saltation[i] ? 0.08436 * pow(0.2 + U(gen), 1.27) : 0;
+            p.snow_depth[i] = 2.0 * U(gen);
+            p.height_diff[i] = U(gen) < 0.2 ? 1.5 * U(gen) : 0;
+            p.z0[i] = Snow::Z0_SNOW + 0.01 * U(gen);
+            p.ustar[i] = 0.01 + U(gen);
+            p.uref[i] = 0.5 + 25 * U(gen);
+            p.T[i] = -30 + 30 * U(gen);
+            p.t[i] = p.T[i] + 273.15;
+            p.u_th[i] = 0.35 + (1.0 / 150.0) * p.T[i] + (1.0 / 8200.0) * p.T[i] * p.T[i];
+            p.rh[i] = 0.3 + 0.7 * U(gen);
+        }
+    }
+
+    /**
+     * The per-face layer loop as previously found in PBSM3D::run
+     */
+    void reference(const pbsm3d::suspension_profile& p, size_t i, double* u_z, double* w, double* K, double* csubl)
+    {
+        double rho_p = PhysConst::rho_ice;
+        double hs = p.hs[i];
+        double snow_depth = p.snow_depth[i];
+        double height_diff = p.height_diff[i];
+        double z0 = p.z0[i];
+        double uref = p.uref[i];
+        double ustar = p.ustar[i];
+        double T = p.T[i];
+        double t = p.t[i];
+        double rh = p.rh[i];
+        double es = Atmosphere::saturatedVapourPressure(t);
+        double ea = rh * es / 1000.;
+
+        for (int z = 0; z < s.nLayer; ++z)
+        {
+            double cz = z * s.v_edge_height + hs + s.v_edge_height / 2.;
+            double hz = cz + snow_depth;
+
+            double uz = 0;
+            if (p.saltation[i] && cz < height_diff)
+                uz = 2.8 * p.u_th[i];
+            else if (cz < height_diff)
+                uz = 0.01;
+            else if (hz < Atmosphere::Z_U_R)
+                uz = std::max(0.01, Atmosphere::log_scale_wind(uref, Atmosphere::Z_U_R, hz, snow_depth, z0));
+            else
+                uz = std::max(0.01, uref);
+
+            double rm = 4.6e-5 * pow(cz, -0.258);
+            double mm_alpha = 4.08 + 12.6 * cz;
+            double mm = 4. / 3. * M_PI * rho_p * rm * rm * rm * (1.0 + 3.0 / mm_alpha + 2. / (mm_alpha * mm_alpha));
+            double r_z = pow((3.0 * mm) / (4 * M_PI * rho_p), 0.3333333);
+            double xrz = 0.005 * pow(uz, 1.36);
+
+            double omega = s.settling_velocity;
+            if (!s.do_fixed_settling)
+                omega = 1.1e7 * pow(r_z, 1.8);
+
+            double Vr = omega + 3.0 * xrz * cos(M_PI / 4.0);
+            double v = 1.88e-5;
+            double Re = 2.0 * r_z * Vr / v;
+            double Nu, Sh;
+            Nu = Sh = 1.79 + 0.606 * pow(Re, 0.5);
+            double D = 2.06e-5 * pow(t / 273.15, 1.75);
+            double lambda_t = 0.000063 * t + 0.00673;
+            double L = 2.838e6;
+
+            double dmdtz = 0;
+            if (s.iterative_subl)
+            {
+                double mw = 0.01801528 * 1000.0;
+                double R = 8.31441 / 1000.0;
+                double rho = (mw * ea) / (R * t);
+
+                auto fx = [=](double Ti) {
+                    return boost::math::make_tuple(
+                        T + D * L * (rho / (1000.0) - .611 * mw * exp(17.3 * Ti / (237.3 + Ti)) / (R * (Ti + 273.15) * (1000.0))) / lambda_t - Ti,
+                        D * L * (-0.6110000000e-3 * mw * (17.3 / (237.3 + Ti) - 17.3 * Ti / pow(237.3 + Ti, 2)) * exp(17.3 * Ti / (237.3 + Ti)) / (R * (Ti + 273.15)) +
+                                 0.6110000000e-3 * mw * exp(17.3 * Ti / (237.3 + Ti)) / (R * pow(Ti + 273.15, 2))) / lambda_t - 1);
+                };
+
+                double Ti = boost::math::tools::newton_raphson_iterate(fx, T, -50., 0., 6);
+                double Ts = Ti + 273.15;
+                dmdtz = 2.0 * M_PI * rm * lambda_t / L * Nu * (Ts - (t + 273.15));
+            }
+            else
+            {
+                double M = 18.01;
+                double R = 8313;
+                double sigma = (rh - 1.0) * (1.019 + 0.027 * log(cz));
+                double rho = (M * es) / (R * t);
+                double Qr = 0.9 * M_PI * rm * rm * 120.0;
+                dmdtz = Sh * rho * D * (6.283185308 * Nu * R * r_z * sigma * t * t * lambda_t - L * M * Qr + Qr * R * t) /
+                        (D * L * Sh * (L * M - R * t) * rho + lambda_t * t * t * Nu * R);
+            }
+
+            double c = dmdtz / mm;
+            if (!s.do_sublimation)
+                c = 0;
+
+            double l = PhysConst::kappa * (cz + z0) * s.l__max / (PhysConst::kappa * (cz + z0) + s.l__max);
+            double diffusion_coeff = s.snow_diffusion_const;
+            if (s.rouault_diffusion_coeff)
+                diffusion_coeff = 1.0 / (1.0 + (omega * omega) / (1.56 * ustar * ustar));
+
+            u_z[z] = uz;
+            w[z] = omega;
+            K[z] = diffusion_coeff * ustar * l;
+            csubl[z] = c;
+        }
+    }
+
+    void compare(size_t nfaces)
+    {
+        pbsm3d::suspension_profile p;
+        fill(p, nfaces);
+        p.compute(s, 0, nfaces);
+
+        std::vector<double> u_z(s.nLayer), w(s.nLayer), K(s.nLayer), csubl(s.nLayer);
+        for (size_t i = 0; i < nfaces; ++i)
+        {
+            reference(p, i, u_z.data(), w.data(), K.data(), csubl.data());
+            for (int z = 0; z < s.nLayer; ++z)
+            {
+                size_t k = p.index(i, z);
+                ASSERT_NEAR(p.u_z[k], u_z[z], 1e-12 * std::fabs(u_z[z]));
+                ASSERT_NEAR(p.w[k], w[z], 1e-12 * std::fabs(w[z]));
+                ASSERT_NEAR(p.K[k], K[z], 1e-12 * std::fabs(K[z]));
+                ASSERT_NEAR(p.csubl[k], csubl[z], 1e-10 * std::fabs(csubl[z]));
+            }
+        }
+    }
+
+    pbsm3d::profile_settings s;
+};
+
+TEST_F(PBSM3DProfileTest, MatchesReference)
+{
+    compare(1000);
+}
+
+TEST_F(PBSM3DProfileTest, MatchesReferenceIterativeSublimation)
+{
+    s.iterative_subl = true;
+    s.rouault_diffusion_coeff = true;
+    compare(1000);
+}
+
+TEST_F(PBSM3DProfileTest, MatchesReferenceFixedSettling)
+{
+    s.do_fixed_settling = true;
+    s.do_sublimation = false;
+    compare(1000);
+}
+
+TEST_F(PBSM3DProfileTest, UstarMatchesBracketing)
+{
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> U(0, 1);
+
+    size_t n = 1000;
+    std::vector<double> u2(n), lambda(n), ustar(n);
+    std::vector<char> converged(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        u2[i] = 1 + 20 * U(gen);
+        lambda[i] = 0.3 * U(gen);
+    }
+
+    pbsm3d::solve_ustar_coupled(n, u2.data(), lambda.data(), ustar.data(), converged.data());
+
+    auto tol = [](double a, double b) -> bool { return fabs(a - b) < 1e-8; };
+    size_t nconverged = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (!converged[i])
+            continue;
+        ++nconverged;
+
+        auto ustarFn = [&](double u) -> double {
+            return u2[i] * PhysConst::kappa / log(2.0 / pbsm3d::z0_blowing_snow(u, lambda[i])) - u;
+        };
+        boost::uintmax_t max_iter = 500;
+        auto r = boost::math::tools::bracket_and_solve_root(ustarFn, 1.0, 1.0, false, tol, max_iter);
+        ASSERT_NEAR(ustar[i], r.first + (r.second - r.first) / 2.0, 1e-7);
+    }
+
+    // the vectorized path should handle nearly everything, otherwise there is no point
+    ASSERT_GT(nconverged, 0.95 * n);
+}
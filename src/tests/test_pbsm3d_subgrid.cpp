@@ -0,0 +1,93 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+#include "modules/PBSM3D.hpp"
+
+#include "gtest/gtest.h"
+
+#include <gsl/gsl_errno.h>
+
+#include <random>
+
+/**
+ * Compares the tabulated use_subgrid_topo_V2 holding capacity against integrating it directly
+ */
+class PBSM3DSubgridTest : public testing::Test
+{
+  protected:
+    virtual void SetUp()
+    {
+        logging::core::get()->set_logging_enabled(false);
+        gsl_set_error_handler_off(); // as core does
+
+        pbsm = boost::make_shared<PBSM3D>(config_file());
+
+        // the defaults PBSM3D::init sets
+        pbsm->min_sd_trans = 0.1;
+        pbsm->subgrid_table_max_sd = 5.0;
+        pbsm->subgrid_table_dsd = 0.05;
+        pbsm->subgrid_table_tol = 1e-4;
+    }
+
+    boost::shared_ptr<PBSM3D> pbsm;
+};
+
+TEST_F(PBSM3DSubgridTest, LookupMatchesIntegration)
+{
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> U(0, 1);
+
+    for (auto tpi : {std::make_pair(0.0, 0.1), std::make_pair(-2.3, 1.7), std::make_pair(4.1, 5.0),
+                     std::make_pair(-4.0, 0.6)})
+    {
+        PBSM3D::subgrid_topo_table tbl;
+        tbl.moy_tpi = tpi.first;
+        tbl.std_tpi = tpi.second;
+        pbsm->build_subgrid_topo_table(tbl);
+
+        ASSERT_EQ(tbl.nfailed, 0);
+        ASSERT_TRUE(tbl.converged);
+        ASSERT_LE(tbl.max_err, pbsm->subgrid_table_tol);
+
+        double tpi_lim, hold, frac_contrib;
+        ASSERT_FALSE(tbl.lookup(tbl.sd0 - 1e-3, tpi_lim, hold, frac_contrib));
+        ASSERT_FALSE(tbl.lookup(tbl.sd_max, tpi_lim, hold, frac_contrib));
+
+        for (int k = 0; k < 500; ++k)
+        {
+            double sd = tbl.sd0 + U(gen) * (tbl.sd_max - tbl.sd0);
+            ASSERT_TRUE(tbl.lookup(sd, tpi_lim, hold, frac_contrib));
+
+            double exact_tpi_lim, exact_hold, exact_frac_contrib;
+            ASSERT_EQ(pbsm->subgrid_topo_V2_holding(sd, tbl.norm, tbl.moy_tpi, tbl.std_tpi,
+                                                    exact_tpi_lim, exact_hold, exact_frac_contrib),
+                      GSL_SUCCESS);
+
+            // the tolerance is checked at the midpoints, where the linear interpolation error of a smooth function peaks
+            double tol = 2 * pbsm->subgrid_table_tol;
+            ASSERT_NEAR(tpi_lim, exact_tpi_lim, tol) << "sd=" << sd;
+            ASSERT_NEAR(hold, exact_hold, tol) << "sd=" << sd;
+            ASSERT_NEAR(frac_contrib, exact_frac_contrib, tol) << "sd=" << sd;
+        }
+    }
+}
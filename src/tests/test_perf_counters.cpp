@@ -0,0 +1,84 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+
+#include "utility/perf_counters.hpp"
+
+#include "gtest/gtest.h"
+
+TEST(PerfCountersTest, AddScaledScalesMultiplexedCounts)
+{
+    perf_counters::values start{}, end{}, total{};
+
+    start[perf_counters::cycles] = 1000;
+    start[perf_counters::instructions] = 2000;
+    start[perf_counters::time_enabled] = 100;
+    start[perf_counters::time_running] = 100;
+
+    // the group only ran for a quarter of the interval
+    end[perf_counters::cycles] = 1250;
+    end[perf_counters::instructions] = 2500;
+    end[perf_counters::time_enabled] = 500;
+    end[perf_counters::time_running] = 200;
+
+    perf_counters::add_scaled(total, start, end);
+
+    ASSERT_EQ(total[perf_counters::cycles], 1000u);
+    ASSERT_EQ(total[perf_counters::instructions], 2000u);
+    ASSERT_EQ(total[perf_counters::time_enabled], 400u);
+    ASSERT_EQ(total[perf_counters::time_running], 100u);
+
+    // not multiplexed: counts pass through, and repeated calls accumulate
+    perf_counters::values start2{}, end2{};
+    end2[perf_counters::cycles] = 7;
+    end2[perf_counters::time_enabled] = 10;
+    end2[perf_counters::time_running] = 10;
+
+    perf_counters::add_scaled(total, start2, end2);
+    ASSERT_EQ(total[perf_counters::cycles], 1007u);
+    ASSERT_EQ(total[perf_counters::time_enabled], 410u);
+}
+
+TEST(PerfCountersTest, AddScaledIgnoresIntervalsThatNeverRan)
+{
+    perf_counters::values start{}, end{}, total{};
+    end[perf_counters::cycles] = 5;
+    end[perf_counters::time_enabled] = 10;
+
+    perf_counters::add_scaled(total, start, end);
+
+    ASSERT_EQ(total[perf_counters::cycles], 0u);
+    ASSERT_EQ(total[perf_counters::time_enabled], 10u);
+    ASSERT_EQ(total[perf_counters::time_running], 0u);
+}
+
+TEST(PerfCountersTest, ReadIsZeroWhenClosed)
+{
+    perf_counters pc;
+    perf_counters::values v;
+    v.fill(1);
+    pc.read(v);
+
+    for (auto x : v)
+        ASSERT_EQ(x, 0u);
+}
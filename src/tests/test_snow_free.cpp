@@ -0,0 +1,226 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+
+
+#include "triangulation.hpp"
+#include "face_range.hpp"
+#include "global.hpp"
+#include "modules/Richard_albedo.hpp"
+#include "modules/sub_grid.hpp"
+#include "gtest/gtest.h"
+#include "readjson.hpp"
+
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+/**
+ * Runs the modules that skip snow-free faces, Richard_albedo and sub_grid, over a synthetic snow season on two copies
+ * of a mesh: one evaluating every face, and one skipping snow-free faces and blocks as core does with
+ * snow_free_fast_path. The outputs have to be identical.
+ */
+class SnowFreeTest : public testing::Test
+{
+  protected:
+    virtual void SetUp()
+    {
+        logging::core::get()->set_logging_enabled(false);
+        mesh_json = read_json("meshes/granger1m.mesh");
+
+        param = boost::make_shared<global>();
+        param->_dt = 3600;
+
+        albedo = boost::make_shared<Richard_albedo>(config_file());
+        cover = boost::make_shared<sub_grid>(config_file());
+        for (auto m : {albedo, cover})
+        {
+            m->global_param = param;
+            m->set_optional_found("p_snow"); // as core does when a precipitation phase module provides it
+        }
+
+        full = make_domain();
+        skip = make_domain();
+    }
+
+    mesh make_domain()
+    {
+        mesh domain = boost::make_shared<triangulation>();
+        domain->from_json(mesh_json);
+        domain->init_timeseries(variables);
+        std::set<std::string> modules = {albedo->ID};
+        domain->init_module_data(modules);
+        domain->init_face_columns(variables, {});
+
+        albedo->init(domain);
+        cover->init(domain);
+        return domain;
+    }
+
+    void set(mesh& domain, size_t i, const uint64_t& variable, double value)
+    {
+        (*domain->face(i))[variable] = value;
+    }
+
+    pt::ptree mesh_json;
+    std::set<std::string> variables = {"swe", "snowdepthavg", "p_snow", "T_s_0",
+                                       "snow_albedo", "melting_albedo", "snowcoverfraction"};
+
+    boost::shared_ptr<global> param;
+    module albedo;
+    module cover;
+
+    mesh full;
+    mesh skip;
+};
+
+TEST_F(SnowFreeTest, IdenticalToFullEvaluation)
+{
+    size_t nfaces = full->size_faces();
+    size_t block = 16;
+    ASSERT_GT(nfaces, 4 * block);
+
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> U(0, 1);
+
+    // The first half of the mesh is mostly snow free, with the odd snowfall that often melts the same timestep, so
+    // that there are whole snow-free blocks. The second half accumulates snow and is also hit by drift deposition
+    // without any snowfall
+    std::vector<double> swe(nfaces, 0);
+
+    face_range range_full(*full);
+    face_range range_skip(*skip);
+
+    size_t skipped_faces = 0;
+    size_t skipped_blocks = 0;
+
+    for (int step = 0; step < 500; step++)
+    {
+        for (size_t i = 0; i < nfaces; i++)
+        {
+            bool low = i < nfaces / 2;
+            double p_snow = U(gen) < (low ? 0.02 : 0.1) ? 5 * U(gen) : 0;
+            double drift = !low && U(gen) < 0.02 ? 3 * U(gen) : 0;
+            double melt = low ? 4 : 0.5 * U(gen);
+            swe[i] = std::max(0.0, swe[i] + p_snow + drift - melt);
+
+            double T_s_0 = swe[i] > 0 ? 263 + 11 * U(gen) : -9999;
+            for (auto domain : {full, skip})
+            {
+                set(domain, i, "p_snow"_s, p_snow);
+                set(domain, i, "swe"_s, swe[i]);
+                set(domain, i, "snowdepthavg"_s, swe[i] / 300.);
+                set(domain, i, "T_s_0"_s, T_s_0);
+            }
+        }
+
+        for (size_t i = 0; i < nfaces; i++)
+        {
+            auto face = full->face(i);
+            albedo->run(face);
+        }
+        for (size_t begin = 0; begin < nfaces; begin += block)
+        {
+            range_full.set(begin, std::min(nfaces, begin + block));
+            cover->run(range_full);
+            range_full.commit();
+        }
+
+        // as core::_run_blocks
+        for (size_t begin = 0; begin < nfaces; begin += block)
+        {
+            size_t end = std::min(nfaces, begin + block);
+
+            if (albedo->snow_free(*skip, begin, end))
+            {
+                skipped_blocks++;
+            }
+            else
+            {
+                for (size_t i = begin; i < end; i++)
+                {
+                    auto face = skip->face(i);
+                    if (albedo->snow_free(face))
+                    {
+                        skipped_faces++;
+                        continue;
+                    }
+                    albedo->run(face);
+                }
+            }
+
+            if (!cover->snow_free(*skip, begin, end))
+            {
+                range_skip.set(begin, end);
+                cover->run(range_skip);
+                range_skip.commit();
+            }
+        }
+
+        skip->update_snow_free(block);
+        param->first_time_step = false;
+
+        for (size_t i = 0; i < nfaces; i++)
+        {
+            auto f = full->face(i);
+            auto s = skip->face(i);
+            ASSERT_EQ((*f)["snow_albedo"_s], (*s)["snow_albedo"_s]) << "face " << i << " step " << step;
+            ASSERT_EQ((*f)["melting_albedo"_s], (*s)["melting_albedo"_s]) << "face " << i << " step " << step;
+            ASSERT_EQ((*f)["snowcoverfraction"_s], (*s)["snowcoverfraction"_s]) << "face " << i << " step " << step;
+            ASSERT_EQ(f->get_module_data<Richard_albedo::data>(albedo->ID).albedo,
+                      s->get_module_data<Richard_albedo::data>(albedo->ID).albedo);
+        }
+    }
+
+    // the comparison is only meaningful if both the face and the block skips were taken
+    ASSERT_GT(skipped_faces, 0);
+    ASSERT_GT(skipped_blocks, 0);
+}
+
+TEST_F(SnowFreeTest, SnowfallPreventsSkip)
+{
+    auto face = skip->face(0);
+
+    // no snow at the end of the last timestep
+    set(skip, 0, "swe"_s, 0);
+    set(skip, 0, "snowdepthavg"_s, 0);
+    set(skip, 0, "p_snow"_s, 0);
+    skip->update_snow_free(16);
+    ASSERT_TRUE(face->snow_free);
+    ASSERT_TRUE(albedo->snow_free(face));
+
+    // snowfall this timestep, even if the snowpack model has not added it yet
+    set(skip, 0, "p_snow"_s, 1);
+    ASSERT_FALSE(albedo->snow_free(face));
+    ASSERT_FALSE(cover->snow_free(face));
+    ASSERT_FALSE(albedo->snow_free(*skip, 0, 16));
+
+    // deposition without snowfall
+    set(skip, 0, "p_snow"_s, 0);
+    set(skip, 0, "swe"_s, 2);
+    ASSERT_FALSE(albedo->snow_free(face));
+
+    // only the blocks of the last update are known
+    ASSERT_FALSE(skip->snow_free_block(1, 17));
+}
@@ -24,6 +24,7 @@
 
 
 #include "triangulation.hpp"
+#include "face_range.hpp"
 #include "gtest/gtest.h"
 #include "readjson.hpp"
 #include <boost/property_tree/ptree.hpp>
@@ -64,6 +65,67 @@ class TriangulationTest : public testing::Test
 
     }
 
+#ifdef USE_MPI
+    // Ghost region as the full load computes it, for the owned global id range [first, last]
+    void full_mesh_ghost_region(int first, int last, double max_distance,
+                                std::set<int>& ghost_neighbors, std::set<int>& ghost_faces)
+    {
+        mesh._local_faces.clear();
+        mesh._boundary_faces.clear();
+        mesh._ghost_neighbors.clear();
+        mesh._ghost_faces.clear();
+        for (auto f : mesh._faces)
+        {
+            f->is_ghost = f->cell_global_id < first || f->cell_global_id > last;
+            if (!f->is_ghost)
+                mesh._local_faces.push_back(f);
+        }
+
+        mesh.determine_local_boundary_faces();
+        mesh.determine_process_ghost_faces_nearest_neighbors();
+        mesh.determine_process_ghost_faces_by_distance(max_distance);
+
+        for (auto f : mesh._ghost_neighbors)
+            ghost_neighbors.insert(f->cell_global_id);
+        for (auto f : mesh._ghost_faces)
+            ghost_faces.insert(f->cell_global_id);
+    }
+#endif
+
+    // Ghost region as the distributed load computes it, with the mesh standing in for the h5 file
+    void distributed_ghost_region(int first, int last, double max_distance,
+                                    std::set<int>& ghost_neighbors, std::set<int>& ghost_faces)
+    {
+        std::map<int, mesh_elem> by_id;
+        for (auto f : mesh._faces)
+            by_id[f->cell_global_id] = f;
+
+        std::set<int> fetched;
+        auto get = [&](int id)
+        {
+            // only faces that have been fetched can be asked for
+            EXPECT_TRUE(fetched.count(id));
+            return by_id.at(id);
+        };
+
+        triangulation::distributed_ghost_region(
+            first, last, max_distance,
+            [&](const std::vector<int>& ids)
+            {
+                fetched.insert(ids.begin(), ids.end());
+            },
+            [&](int id)
+            {
+                auto f = get(id);
+                std::array<int, 3> neigh;
+                for (int j = 0; j < 3; ++j)
+                    neigh[j] = f->neighbor(j) != nullptr ? f->neighbor(j)->cell_global_id : -1;
+                return neigh;
+            },
+            [&](int id) { return get(id)->center(); },
+            ghost_neighbors, ghost_faces);
+    }
+
     pt::ptree mesh_json;
     pt::ptree param_json;
     pt::ptree ic_json;
@@ -183,4 +245,166 @@ TEST_F(TriangulationTest, ModuleData)
 
 
 
-}
\ No newline at end of file
+}
+
+TEST_F(TriangulationTest, FaceRange)
+{
+    std::set<std::string> parameters = {"MS0"};
+    mesh.init_face_columns(variables, parameters);
+
+    for (size_t i = 0; i < mesh.size_faces(); ++i)
+        (*mesh.face(i))["t"_s] = i;
+
+    face_range range(mesh);
+    range.set(1, 5);
+    ASSERT_EQ(range.size(), 4);
+
+    const double* t = range.in("t"_s);
+    const double* ms0 = range.parameter("MS0"_s);
+    double* rh = range.out("rh"_s);
+    for (size_t k = 0; k < range.size(); ++k)
+    {
+        ASSERT_DOUBLE_EQ(t[k], k + 1);
+        ASSERT_DOUBLE_EQ(ms0[k], range.face(k)->parameter("MS0"_s));
+        rh[k] = 2 * t[k];
+    }
+
+    // outputs are only written back on commit
+    ASSERT_EQ((*mesh.face(1))["rh"_s], -9999.0);
+    range.commit();
+
+    for (size_t i = 1; i < 5; ++i)
+        ASSERT_DOUBLE_EQ((*mesh.face(i))["rh"_s], 2.0 * i);
+    ASSERT_EQ((*mesh.face(0))["rh"_s], -9999.0);
+    ASSERT_EQ((*mesh.face(5))["rh"_s], -9999.0);
+
+    // no column was built for it
+    ASSERT_ANY_THROW(range.in("swe"_s));
+
+    // out() then in() on the next block reads this block's values, not those left over from the last block
+    range.set(5, 9);
+    double* rh_out = range.out("rh"_s);
+    for (size_t i = 5; i < 9; ++i)
+        (*mesh.face(i))["rh"_s] = 10.0 * i;
+    const double* rh_in = range.in("rh"_s);
+    ASSERT_EQ(rh_in, rh_out);
+    for (size_t k = 0; k < range.size(); ++k)
+        ASSERT_DOUBLE_EQ(rh_in[k], 10.0 * (k + 5));
+}
+
+TEST_F(TriangulationTest, CompactMesh)
+{
+    auto& c = mesh.compact();
+    ASSERT_EQ(c.size_faces(), mesh.size_faces());
+    ASSERT_EQ(c.size(), mesh.size_faces());
+    ASSERT_EQ(c.size_vertex(), mesh.size_vertex());
+
+    for (size_t i = 0; i < c.size(); ++i)
+    {
+        auto f = mesh.face(i);
+        ASSERT_EQ(c.global_id[i], f->cell_global_id);
+        ASSERT_DOUBLE_EQ(c.area[i], f->get_area());
+        ASSERT_DOUBLE_EQ(c.z[i], f->get_z());
+        ASSERT_DOUBLE_EQ(c.slope[i], f->slope());
+
+        // the faces read their geometry from the compact mesh, so check it against the vertices
+        auto& p0 = f->vertex(0)->point();
+        auto& p1 = f->vertex(1)->point();
+        auto& p2 = f->vertex(2)->point();
+        auto centroid = CGAL::centroid(p0, p1, p2);
+        ASSERT_DOUBLE_EQ(c.x[i], centroid.x());
+        ASSERT_DOUBLE_EQ(c.y[i], centroid.y());
+        ASSERT_DOUBLE_EQ(c.z[i], centroid.z());
+        auto normal = CGAL::unit_normal(p0, p1, p2);
+        ASSERT_DOUBLE_EQ(c.nx[i], normal.x());
+        ASSERT_DOUBLE_EQ(c.ny[i], normal.y());
+        ASSERT_DOUBLE_EQ(c.nz[i], normal.z());
+        ASSERT_NEAR(c.area[i], 0.5 * std::fabs((p1.x() - p0.x()) * (p2.y() - p0.y()) - (p2.x() - p0.x()) * (p1.y() - p0.y())),
+                    1e-9 * c.area[i]);
+
+        for (int j = 0; j < 3; ++j)
+        {
+            int v = c.vertex(i, j);
+            ASSERT_DOUBLE_EQ(c.vx[v], f->vertex(j)->point().x());
+            ASSERT_DOUBLE_EQ(c.vy[v], f->vertex(j)->point().y());
+            ASSERT_DOUBLE_EQ(c.edge_length(i, j), f->edge_length(j));
+
+            int n = c.neighbor(i, j);
+            if (f->neighbor(j) == nullptr)
+            {
+                ASSERT_EQ(n, compact_mesh::no_neighbor);
+                continue;
+            }
+            ASSERT_EQ(mesh.face(n), f->neighbor(j));
+
+            // the neighbour points back across the shared edge
+            ASSERT_TRUE(c.neighbor(n, 0) == (int)i || c.neighbor(n, 1) == (int)i || c.neighbor(n, 2) == (int)i);
+            ASSERT_GT(c.neighbor_dist(i, j), 0);
+        }
+    }
+}
+
+#ifdef USE_MPI
+TEST_F(TriangulationTest, DistributedGhostRegion)
+{
+    math::gis::distance = &math::gis::distance_UTM;
+
+    int nglobal = mesh.size_faces();
+    for (int nranks : {2, 5})
+    {
+        for (double max_distance : {10.0, 100.0})
+        {
+            int first = 0;
+            for (int rank = 0; rank < nranks; ++rank)
+            {
+                // same split as partition_mesh
+                int last = first + nglobal / nranks + (rank < nglobal % nranks ? 1 : 0) - 1;
+
+                std::set<int> full_neighbors, full_faces;
+                full_mesh_ghost_region(first, last, max_distance, full_neighbors, full_faces);
+
+                std::set<int> neighbors, faces;
+                distributed_ghost_region(first, last, max_distance, neighbors, faces);
+
+                ASSERT_FALSE(full_neighbors.empty());
+                ASSERT_EQ(neighbors, full_neighbors);
+                ASSERT_EQ(faces, full_faces);
+
+                first = last + 1;
+            }
+            ASSERT_EQ(first, nglobal);
+        }
+    }
+}
+#endif
+
+TEST_F(TriangulationTest, CompactFaceData)
+{
+    auto& c = mesh.compact();
+
+    // the faces' variables and parameters are the compact mesh's arrays
+    double* t = c.variables.column("t"_s);
+    const double* ms0 = c.parameters.column("MS0"_s);
+    ASSERT_NE(t, nullptr);
+    ASSERT_NE(ms0, nullptr);
+    ASSERT_EQ(c.variables.column("not_a_variable"_s), nullptr);
+
+    for (size_t i = 0; i < c.size(); ++i)
+    {
+        auto f = mesh.face(i);
+        (*f)["t"_s] = i;
+        ASSERT_EQ(&(*f)["t"_s], &t[i]);
+        ASSERT_DOUBLE_EQ(t[i], i);
+        ASSERT_EQ(&f->parameter("MS0"_s), &ms0[i]);
+    }
+    ASSERT_DOUBLE_EQ(ms0[0], 0.972731475402661);
+    ASSERT_DOUBLE_EQ(ms0[1], 0.984907757406954);
+
+    // and follow the faces when the compact mesh is rebuilt
+    std::vector<mesh_elem> faces = {mesh.face(3), mesh.face(1)};
+    mesh.prune_faces(faces);
+    ASSERT_EQ(mesh.compact().size(), 2u);
+    ASSERT_DOUBLE_EQ((*mesh.face(0))["t"_s], 3);
+    ASSERT_DOUBLE_EQ((*mesh.face(1))["t"_s], 1);
+    ASSERT_DOUBLE_EQ(mesh.face(1)->parameter("MS0"_s), 0.984907757406954);
+}
@@ -33,34 +33,34 @@ netcdf::~netcdf()
 {
 
 }
- void netcdf::add_dim1D(const std::string& var, size_t length)
- {
-     auto nTri = _data.addDim(var, length);
-     _dimVector.push_back(nTri);
- }
-void netcdf::create_variable1D( const std::string& var, size_t length)
+void netcdf::add_dim1D(const std::string& var, size_t length)
 {
-    //only create the dim and variables once
-    try
-    {
-        add_dim1D("tri_id",length);
+    // the dim may already have been created outside of _dimVector, e.g., by put_var1D(var, dim, values)
+    auto dim = _data.getDim(var);
+    if (dim.isNull())
+        dim = _data.addDim(var, length);
 
-    }
-    catch(netCDF::exceptions::NcNameInUse& e)
+    if (dim.getSize() != length)
     {
-
+        CHM_THROW_EXCEPTION(forcing_error, "Dimension " + var + " has length " + std::to_string(dim.getSize()) +
+                                               " but " + std::to_string(length) + " was requested");
     }
 
-    try
-    {
-        auto nc_var = _data.addVar(var.c_str(), netCDF::ncDouble, _dimVector);
-    }
-    catch(netCDF::exceptions::NcNameInUse& e)
+    for (auto& d : _dimVector)
     {
-
+        if (d.getName() == var)
+            return;
     }
+    _dimVector.push_back(dim);
+}
 
+void netcdf::create_variable1D( const std::string& var, size_t length)
+{
+    //only create the dim and variables once
+    add_dim1D("tri_id", length);
 
+    if (_data.getVar(var).isNull())
+        _data.addVar(var, netCDF::ncDouble, _data.getDim("tri_id"));
 }
 
 netCDF::NcFile& netcdf::get_ncfile()
@@ -73,6 +73,10 @@ void netcdf::put_var1D(const std::string& var, size_t index, double value)
     auto vars = _data.getVars();
 
     auto itr = vars.find(var);
+    if (itr == vars.end())
+    {
+        CHM_THROW_EXCEPTION(forcing_error, "Variable not initialized: " + var);
+    }
 
     std::vector<size_t> startp,countp;
     startp.push_back(index);
@@ -91,6 +95,59 @@ void netcdf::put_var1D(const std::string& var, size_t index, double value)
 
 }
 
+template<typename T>
+static void put_var1D_all(netCDF::NcFile& file, const std::string& var, const std::string& dim,
+                          const netCDF::NcType& type, const std::vector<T>& values)
+{
+    auto nc_dim = file.getDim(dim);
+    if (nc_dim.isNull())
+        nc_dim = file.addDim(dim, values.size());
+
+    if (nc_dim.getSize() != values.size())
+    {
+        CHM_THROW_EXCEPTION(forcing_error, "Dimension " + dim + " has length " + std::to_string(nc_dim.getSize()) +
+                                               " but " + var + " has " + std::to_string(values.size()) + " values");
+    }
+
+    auto nc_var = file.addVar(var, type, nc_dim);
+    if (!values.empty())
+        nc_var.putVar(values.data());
+}
+
+void netcdf::put_var1D(const std::string& var, const std::string& dim, const std::vector<double>& values)
+{
+    put_var1D_all(_data, var, dim, netCDF::ncDouble, values);
+}
+
+void netcdf::put_var1D(const std::string& var, const std::string& dim, const std::vector<unsigned long long>& values)
+{
+    put_var1D_all(_data, var, dim, netCDF::ncUint64, values);
+}
+
+template<typename T>
+static void get_var1D_all(netCDF::NcFile& file, const std::string& var, std::vector<T>& values)
+{
+    auto nc_var = file.getVar(var);
+    if (nc_var.isNull())
+    {
+        CHM_THROW_EXCEPTION(forcing_error, "Variable not found: " + var);
+    }
+
+    values.resize(nc_var.getDim(0).getSize());
+    if (!values.empty())
+        nc_var.getVar(values.data());
+}
+
+void netcdf::get_var1D(const std::string& var, std::vector<double>& values)
+{
+    get_var1D_all(_data, var, values);
+}
+
+void netcdf::get_var1D(const std::string& var, std::vector<unsigned long long>& values)
+{
+    get_var1D_all(_data, var, values);
+}
+
 void netcdf::create(const std::string& file)
 {
     _data.open(file.c_str(), netCDF::NcFile::replace);
@@ -564,6 +621,39 @@ netcdf::data netcdf::get_var(std::string var, size_t timestep)
 
 }
 
+netcdf::data netcdf::get_var(std::string var, size_t timestep, size_t x, size_t y, size_t nx, size_t ny)
+{
+    std::vector<size_t> startp = {timestep, y, x};
+    std::vector<size_t> countp = {1, ny, nx};
+
+    auto vars = _data.getVars();
+
+    netcdf::data array(boost::extents[ny][nx]);
+
+    auto itr = vars.find(var);
+    itr->second.getVar(startp, countp, array.data());
+
+    double fill_value = get_fillvalue(itr->second);
+
+    double* values = array.data();
+    for (size_t i = 0; i < array.num_elements(); i++)
+    {
+        if (values[i] == fill_value)
+            values[i] = std::nan("nan");
+    }
+
+    return array;
+}
+
+netcdf::data netcdf::get_var(std::string var, boost::posix_time::ptime timestep, size_t x, size_t y, size_t nx, size_t ny)
+{
+    auto diff = timestep - _start; // a duration
+
+    auto offset = diff.total_seconds() / _timestep.total_seconds();
+
+    return get_var(var, offset, x, y, nx, ny);
+}
+
 double netcdf::get_var(std::string var, boost::posix_time::ptime timestep, size_t x, size_t y)
 {
     auto diff = timestep - _start; // a duration
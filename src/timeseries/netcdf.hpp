@@ -28,6 +28,7 @@
 #include <boost/date_time/posix_time/posix_time.hpp> // for boost::posix
 #include <netcdf>
 #include <string>
+#include <vector>
 
 #include "logger.hpp"
 #include "exception.hpp"
@@ -83,9 +84,32 @@ public:
     double get_var(std::string var, size_t timestep, size_t x, size_t y);
     double get_var(std::string var, boost::posix_time::ptime timestep, size_t x, size_t y);
 
+    /**
+     * Reads the ny by nx region of a variable starting at x, y for one timestep with a single read
+     * @param var
+     * @param timestep
+     * @param x
+     * @param y
+     * @param nx
+     * @param ny
+     * @return [ny][nx] array
+     */
+    data get_var(std::string var, size_t timestep, size_t x, size_t y, size_t nx, size_t ny);
+    data get_var(std::string var, boost::posix_time::ptime timestep, size_t x, size_t y, size_t nx, size_t ny);
+
     void add_dim1D(const std::string& var, size_t length);
     void create_variable1D(const std::string& var,  size_t length);
     void put_var1D(const std::string& var, size_t index, double value);
+
+    /**
+     * Creates var on its own dimension dim, which is created if needed, and writes all of values in a single call.
+     * Used for per-face variable length (ragged) data, stored as the flattened values plus an offset variable.
+     * @param var
+     * @param dim
+     * @param values
+     */
+    void put_var1D(const std::string& var, const std::string& dim, const std::vector<double>& values);
+    void put_var1D(const std::string& var, const std::string& dim, const std::vector<unsigned long long>& values);
     /**
      * Some data, such as lat/long do not have a time component are only 2 data. This allows loading those data.
      * @param var
@@ -94,6 +118,14 @@ public:
     data get_var2D(std::string var);
     double get_var1D(std::string var, size_t index);
 
+    /**
+     * Reads all of a 1D variable in a single call. Unlike get_var1D(var, index), fill values are not converted to NaN
+     * @param var
+     * @param values
+     */
+    void get_var1D(const std::string& var, std::vector<double>& values);
+    void get_var1D(const std::string& var, std::vector<unsigned long long>& values);
+
     double get_var2D(std::string var, size_t x, size_t y);
 
     netCDF::NcFile& get_ncfile();
@@ -0,0 +1,131 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+
+#include "cost_schedule.hpp"
+
+#include <algorithm>
+
+cost_schedule::cost_schedule()
+{
+    _window = 1;
+    _step = 0;
+    _windows = 0;
+    _initial = 0;
+    _measured = 0;
+    _predicted = 0;
+}
+
+void cost_schedule::init(size_t n, int nparts, size_t window)
+{
+    _cost.assign(n, 0);
+    _bounds = partition(n, std::max(1, nparts));
+    _window = std::max<size_t>(1, window);
+    _step = 0;
+    _windows = 0;
+    _initial = 0;
+    _measured = 0;
+    _predicted = 0;
+}
+
+bool cost_schedule::end_timestep()
+{
+    if (++_step < _window)
+        return false;
+
+    _measured = imbalance(_cost, _bounds);
+    if (_windows == 0)
+        _initial = _measured;
+
+    _bounds = partition(_cost, parts());
+    _predicted = imbalance(_cost, _bounds);
+
+    std::fill(_cost.begin(), _cost.end(), 0);
+    _step = 0;
+    ++_windows;
+
+    return true;
+}
+
+std::vector<size_t> cost_schedule::partition(size_t n, int nparts)
+{
+    std::vector<size_t> bounds(nparts + 1);
+    for (int p = 0; p <= nparts; ++p)
+        bounds[p] = n * p / nparts;
+    return bounds;
+}
+
+std::vector<size_t> cost_schedule::partition(const std::vector<double>& cost, int nparts)
+{
+    size_t n = cost.size();
+
+    double total = 0;
+    for (auto c : cost)
+        total += c;
+
+    if (total <= 0)
+        return partition(n, nparts);
+
+    // walk the prefix sum once, closing a range whenever it reaches the next multiple of total / nparts. The item that
+    // crosses the target goes to whichever side leaves the boundary closest to it
+    std::vector<size_t> bounds(nparts + 1, n);
+    bounds[0] = 0;
+
+    double sum = 0;
+    size_t i = 0;
+    for (int p = 1; p < nparts; ++p)
+    {
+        double target = total * p / nparts;
+        while (i < n && sum + cost[i] < target)
+            sum += cost[i++];
+
+        if (i < n && (sum + cost[i]) - target < target - sum)
+            sum += cost[i++];
+
+        bounds[p] = i;
+    }
+
+    return bounds;
+}
+
+double cost_schedule::imbalance(const std::vector<double>& cost, const std::vector<size_t>& bounds)
+{
+    size_t nparts = bounds.size() - 1;
+
+    double total = 0;
+    double max = 0;
+    for (size_t p = 0; p < nparts; ++p)
+    {
+        double sum = 0;
+        for (size_t i = bounds[p]; i < bounds[p + 1]; ++i)
+            sum += cost[i];
+
+        total += sum;
+        max = std::max(max, sum);
+    }
+
+    if (total <= 0)
+        return 1;
+
+    return max / (total / nparts);
+}
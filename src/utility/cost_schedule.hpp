@@ -0,0 +1,134 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * Splits a loop over n items (faces or blocks of faces) into contiguous ranges, one per thread, so that every range has
+ * about the same measured cost. The cost of each item is accumulated over a window of timesteps and at the end of each
+ * window the boundaries are recomputed from it. Until the first window is complete the ranges are equal in size,
+ * which is what the default OpenMP static schedule does.
+ *
+ * add() is not synchronized: each item must only be timed by one thread at a time, which is the case when every
+ * thread runs its own range.
+ */
+class cost_schedule
+{
+  public:
+    cost_schedule();
+
+    /**
+     * @param n Number of items
+     * @param nparts Number of ranges, normally the number of threads
+     * @param window Number of timesteps the cost is accumulated over before the ranges are recomputed
+     */
+    void init(size_t n, int nparts, size_t window);
+
+    size_t size() const
+    {
+        return _cost.size();
+    }
+
+    int parts() const
+    {
+        return static_cast<int>(_bounds.size()) - 1;
+    }
+
+    size_t begin(int part) const
+    {
+        return _bounds[part];
+    }
+
+    size_t end(int part) const
+    {
+        return _bounds[part + 1];
+    }
+
+    /**
+     * Adds the cost (any unit, normally ns) of running item i this timestep
+     */
+    void add(size_t i, double cost)
+    {
+        _cost[i] += cost;
+    }
+
+    /**
+     * Call once per timestep after the loop. At the end of a window the ranges are recomputed from the window's cost
+     * and the cost is reset.
+     * @return true if the window ended and the ranges were recomputed
+     */
+    bool end_timestep();
+
+    /// Imbalance over the last window with the ranges that were in use, 0 if no window has ended
+    double measured_imbalance() const
+    {
+        return _measured;
+    }
+
+    /// Imbalance of the last window's cost had it been run with the recomputed ranges
+    double predicted_imbalance() const
+    {
+        return _predicted;
+    }
+
+    /// Imbalance over the first window, i.e., with equal sized ranges
+    double initial_imbalance() const
+    {
+        return _initial;
+    }
+
+    /**
+     * Contiguous ranges of about equal summed cost
+     * @param cost Per item cost
+     * @param nparts Number of ranges
+     * @return nparts + 1 boundaries, range p is [bounds[p], bounds[p+1])
+     */
+    static std::vector<size_t> partition(const std::vector<double>& cost, int nparts);
+
+    /**
+     * Equal sized contiguous ranges
+     */
+    static std::vector<size_t> partition(size_t n, int nparts);
+
+    /**
+     * Maximum range cost over the mean range cost, i.e., how much longer the slowest thread takes than a perfect
+     * split. 1 is perfectly balanced.
+     */
+    static double imbalance(const std::vector<double>& cost, const std::vector<size_t>& bounds);
+
+  private:
+    std::vector<double> _cost;   // per item, summed over the current window
+    std::vector<size_t> _bounds; // nparts + 1
+
+    size_t _window;
+    size_t _step; // timesteps into the current window
+    size_t _windows; // completed windows
+
+    double _initial;
+    double _measured;
+    double _predicted;
+};
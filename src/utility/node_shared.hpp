@@ -0,0 +1,162 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+
+#pragma once
+
+#ifdef USE_MPI
+
+#include <boost/mpi.hpp>
+
+#include <cstddef>
+#include <exception>
+
+#include "exception.hpp"
+
+/**
+ * Read-only data held once per node in MPI-3 shared memory windows (MPI_Win_allocate_shared), instead of once per rank.
+ * The node's first rank fills the data and the other ranks on the node map the same memory.
+ */
+namespace node_shared
+{
+    /**
+     * The ranks of comm that share memory with this rank, i.e., are on the same node
+     */
+    inline boost::mpi::communicator communicator(const boost::mpi::communicator& comm)
+    {
+        MPI_Comm node;
+        MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, comm.rank(), MPI_INFO_NULL, &node);
+        return boost::mpi::communicator(node, boost::mpi::comm_take_ownership);
+    }
+
+    /**
+     * Size of the per-rank copies node_shared::array has avoided on this node so far, that is, each allocation's size
+     * times the number of other ranks on the node. Only counted on the node's first rank. This is not a change in peak
+     * memory if the ranks go on to build their own structures from the data.
+     */
+    inline size_t& saved_bytes()
+    {
+        static size_t saved = 0;
+        return saved;
+    }
+
+    template<typename T>
+    class array
+    {
+      public:
+        array() = default;
+        ~array()
+        {
+            free();
+        }
+
+        array(const array&) = delete;
+        array& operator=(const array&) = delete;
+
+        /**
+         * Collective over node. Allocates n values in a shared window on the node's first rank, which then calls
+         * fill(T*) to set them. Once this returns, every rank on the node can read them.
+         * n only needs to be set on the node's first rank. If fill throws, every rank throws.
+         */
+        template<typename F>
+        void allocate(const boost::mpi::communicator& node, size_t n, F&& fill)
+        {
+            free();
+
+            boost::mpi::broadcast(node, n, 0);
+            _n = n;
+
+            void* base = nullptr;
+            MPI_Aint bytes = node.rank() == 0 ? n * sizeof(T) : 0;
+            MPI_Win_allocate_shared(bytes, sizeof(T), MPI_INFO_NULL, node, &base, &_win);
+
+            std::exception_ptr error = nullptr;
+            if (node.rank() == 0)
+            {
+                _data = static_cast<T*>(base);
+                try
+                {
+                    fill(_data);
+                }
+                catch (...)
+                {
+                    error = std::current_exception();
+                }
+
+                if (!error)
+                    saved_bytes() += n * sizeof(T) * (node.size() - 1);
+            }
+            else
+            {
+                MPI_Aint size;
+                int disp_unit;
+                MPI_Win_shared_query(_win, 0, &size, &disp_unit, &base);
+                _data = static_cast<T*>(base);
+            }
+
+            // makes the writes visible to the node before anyone reads
+            MPI_Win_fence(0, _win);
+
+            bool failed = error != nullptr;
+            boost::mpi::broadcast(node, failed, 0);
+            if (error)
+                std::rethrow_exception(error);
+            if (failed)
+                CHM_THROW_EXCEPTION(model_init_error, "Filling node shared memory failed on the node's first rank");
+        }
+
+        /**
+         * Collective over the node the array was allocated on
+         */
+        void free()
+        {
+            if (_win != MPI_WIN_NULL)
+                MPI_Win_free(&_win);
+
+            _data = nullptr;
+            _n = 0;
+        }
+
+        const T* data() const
+        {
+            return _data;
+        }
+
+        size_t size() const
+        {
+            return _n;
+        }
+
+        const T& operator[](size_t i) const
+        {
+            return _data[i];
+        }
+
+      private:
+        MPI_Win _win = MPI_WIN_NULL;
+        T* _data = nullptr;
+        size_t _n = 0;
+    };
+}
+
+#endif // USE_MPI
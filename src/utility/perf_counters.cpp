@@ -0,0 +1,139 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+#include "perf_counters.hpp"
+
+#ifdef __linux__
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+const std::array<std::string, perf_counters::n_values> perf_counters::names = {
+    "cycles", "instructions", "llc_misses", "branch_misses", "time_enabled", "time_running"};
+
+perf_counters::perf_counters()
+{
+    _fd.fill(-1);
+}
+
+perf_counters::~perf_counters()
+{
+    close();
+}
+
+bool perf_counters::open()
+{
+#ifdef __linux__
+    if (is_open())
+        return true;
+
+    const std::array<uint64_t, n_counters> config = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES, // last level cache
+        PERF_COUNT_HW_BRANCH_MISSES};
+
+    for (size_t i = 0; i < n_counters; ++i)
+    {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = config[i];
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attr.exclude_kernel = 1; // we want the model cost, not the cost of reading the counters
+        attr.exclude_hv = 1;
+        attr.disabled = (i == 0); // leader starts disabled, members follow the leader
+
+        // pid=0, cpu=-1: this thread on any cpu
+        int fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, i == 0 ? -1 : _fd[0], 0));
+        if (fd == -1)
+        {
+            close();
+            return false;
+        }
+        _fd[i] = fd;
+    }
+
+    ioctl(_fd[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(_fd[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void perf_counters::close()
+{
+#ifdef __linux__
+    // members first, leader last
+    for (size_t i = n_counters; i-- > 0;)
+    {
+        if (_fd[i] != -1)
+            ::close(_fd[i]);
+        _fd[i] = -1;
+    }
+#endif
+}
+
+void perf_counters::read(values& v) const
+{
+    v.fill(0);
+#ifdef __linux__
+    if (!is_open())
+        return;
+
+    // read_format layout: nr, time_enabled, time_running, then one value per counter in the order they were added
+    uint64_t buf[3 + n_counters];
+    if (::read(_fd[0], buf, sizeof(buf)) != static_cast<ssize_t>(sizeof(buf)))
+        return;
+
+    for (size_t i = 0; i < n_counters && i < buf[0]; ++i)
+        v[i] = buf[3 + i];
+    v[time_enabled] = buf[1];
+    v[time_running] = buf[2];
+#endif
+}
+
+void perf_counters::add_scaled(values& total, const values& start, const values& end)
+{
+    uint64_t enabled = end[time_enabled] - start[time_enabled];
+    uint64_t running = end[time_running] - start[time_running];
+
+    // if the group never ran in the interval there is nothing to scale from
+    double scale = running > 0 ? static_cast<double>(enabled) / running : 0.0;
+
+    for (size_t i = 0; i < n_counters; ++i)
+        total[i] += static_cast<uint64_t>((end[i] - start[i]) * scale + 0.5);
+
+    total[time_enabled] += enabled;
+    total[time_running] += running;
+}
+
+bool perf_counters::is_open() const
+{
+    return _fd[0] != -1;
+}
@@ -0,0 +1,92 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+/**
+ * Hardware counters for the calling thread via Linux perf_event_open.
+ * The counters are opened as a single group so they are scheduled onto the PMU together and are read with one syscall.
+ * Only user space is counted. On non-Linux platforms, or if the kernel refuses (e.g., perf_event_paranoid), open()
+ * returns false and read() returns zeros.
+ */
+class perf_counters
+{
+public:
+
+    enum counter
+    {
+        cycles,
+        instructions,
+        llc_misses,
+        branch_misses,
+        n_counters,
+
+        // ns the group was enabled and actually scheduled on the PMU. If the PMU is oversubscribed the kernel multiplexes
+        // the group and running < enabled
+        time_enabled = n_counters,
+        time_running,
+        n_values
+    };
+
+    typedef std::array<uint64_t, n_values> values;
+
+    static const std::array<std::string, n_values> names;
+
+    perf_counters();
+    ~perf_counters();
+
+    perf_counters(const perf_counters&) = delete;
+    perf_counters& operator=(const perf_counters&) = delete;
+
+    /**
+     * Opens and enables the counter group for the calling thread. Must be called from the thread to be measured.
+     * @return true if the counters are available
+     */
+    bool open();
+
+    /**
+     * Closes the counter group
+     */
+    void close();
+
+    /**
+     * Current raw counter values and times since open()
+     * @param v
+     */
+    void read(values& v) const;
+
+    /**
+     * Adds the change from start to end to total. The counters are scaled by the fraction of the interval the group
+     * was running, so multiplexed counts estimate the full interval; the times are added as is.
+     */
+    static void add_scaled(values& total, const values& start, const values& end);
+
+    bool is_open() const;
+
+private:
+    std::array<int, n_counters> _fd;
+};